@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Loopback ReadArea latency against a local S7Server (binds port 102)
+// Usage: node bench/readarea_latency.js [reads] [size]
+
+var snap7 = require('../');
+
+var reads = parseInt(process.argv[2], 10) || 3000;
+var size = parseInt(process.argv[3], 10) || 200;
+
+var s7server = new snap7.S7Server();
+s7server.RegisterArea(s7server.srvAreaDB, 1, Buffer.alloc(Math.max(size, 1024)));
+if (!s7server.StartTo('127.0.0.1')) {
+    console.log('Server start failed : ' + s7server.ErrorText(s7server.LastError()));
+    process.exit(1);
+}
+
+var s7client = new snap7.S7Client();
+if (!s7client.ConnectTo('127.0.0.1', 0, 2)) {
+    console.log('Connection failed : ' + s7client.ErrorText(s7client.LastError()));
+    process.exit(1);
+}
+
+// Warm up, then time every blocking read
+for (var i = 0; i < 100; i++)
+    s7client.DBRead(1, 0, size);
+
+var times = new Float64Array(reads);
+for (var i = 0; i < reads; i++) {
+    var t0 = process.hrtime();
+    if (!s7client.DBRead(1, 0, size)) {
+        console.log('Read failed : ' + s7client.ErrorText(s7client.LastError()));
+        process.exit(1);
+    }
+    var dt = process.hrtime(t0);
+    times[i] = dt[0] * 1e6 + dt[1] / 1e3;
+}
+times.sort();
+
+function percentile(p) {
+    return times[Math.min(reads - 1, Math.floor(reads * p))].toFixed(1);
+}
+
+console.log(reads + ' x ' + size + ' bytes DBRead : p50 ' + percentile(0.5) +
+    ' us, p99 ' + percentile(0.99) + ' us, max ' + times[reads - 1].toFixed(1) + ' us');
+
+s7client.Disconnect();
+s7server.Stop();
@@ -37,6 +37,7 @@ TIsoTcpSocket::TIsoTcpSocket()
 	IsoPDUSize =1024;
     IsoMaxFragments=MaxIsoFragments;
     LastIsoError=0;
+    IsoPushExpected=false;
 }
 //---------------------------------------------------------------------------
 TIsoTcpSocket::~TIsoTcpSocket()
@@ -281,22 +282,155 @@ int TIsoTcpSocket::isoSendBuffer(void *Data, int Size)
 	return Result;
 }
 //---------------------------------------------------------------------------
+// Sends a telegram whose payload is the head already built into PDU.Payload
+// (HeadSize bytes) followed by the caller buffers, which are gathered by the
+// socket without being copied into the PDU.
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::isoSendBufferV(int HeadSize, PMsgVector Vector, int Count)
+{
+	TMsgVector Gather[MaxMsgVectors];
+	int IsoSize;
+	int c;
+
+	ClrIsoError();
+	if ((Count<0) || (Count>MaxMsgVectors-1))
+		return SetIsoError(errIsoInvalidDataSize);
+	IsoSize=HeadSize+DataHeaderSize;
+	for (c = 0; c < Count; c++)
+		IsoSize+=Vector[c].Size;
+	if ((HeadSize<0) || (IsoSize>int(IsoFrameSize)))
+		return SetIsoError(errIsoInvalidDataSize);
+	// TPKT
+	PDU.TPKT.Version  = isoTcpVersion;
+	PDU.TPKT.Reserved = 0;
+	PDU.TPKT.HI_Lenght= (u_short(IsoSize)>> 8) & 0xFF;
+	PDU.TPKT.LO_Lenght= u_short(IsoSize) & 0xFF;
+	// COPT
+	PDU.COTP.HLength   =sizeof(TCOTP_DT)-1;
+	PDU.COTP.PDUType   =pdu_type_DT;
+	PDU.COTP.EoT_Num   =pdu_EoT;
+	// Header + head are contiguous
+	Gather[0].Data=&PDU;
+	Gather[0].Size=DataHeaderSize+HeadSize;
+	for (c = 0; c < Count; c++)
+		Gather[c+1]=Vector[c];
+	if (SendPacketV(Gather, Count+1)!=0)
+		return SetIsoError(errIsoSendPacket);
+	return 0;
+}
+//---------------------------------------------------------------------------
 int TIsoTcpSocket::isoRecvBuffer(void *Data, int & Size)
 {
 	int Result;
 
     ClrIsoError();
 	Size =0;
-	Result =isoRecvPDU(&PDU);
-	if (Result==0)
+	do
 	{
-		Size =PDUSize( &PDU )-DataHeaderSize;
-		if (Data!=0)  // Data=NULL ==> a child will consume directly PDY.Payload
-            memcpy(Data, &PDU.Payload, Size);
+		Result =isoRecvPDU(&PDU);
+		if (Result==0)
+			Size =PDUSize( &PDU )-DataHeaderSize;
 	}
+	while ((Result==0) && IsoPushExpected && IsoPushReceived(Size));
+
+	if ((Result==0) && (Data!=0))  // Data=NULL ==> a child will consume directly PDY.Payload
+		memcpy(Data, &PDU.Payload, Size);
 	return Result;
 }
 //---------------------------------------------------------------------------
+bool TIsoTcpSocket::IsoPushReceived(int)
+{
+	return false;
+}
+//---------------------------------------------------------------------------
+bool TIsoTcpSocket::IsoScatterAccepted(void *)
+{
+	return true;
+}
+//---------------------------------------------------------------------------
+// Receives a telegram splitting its payload : the first HeadSize bytes go
+// into PDU.Payload, the next ones (up to Room) directly into Target and the
+// remainder, if any, into PDU.Payload just after the head.
+// On exit Size is the payload size and Direct the bytes stored into Target.
+// Fragmented (or shorter than HeadSize) telegrams are not scattered, they
+// are received as a whole into PDU.Payload and Direct is 0.
+// Target is touched only if the head, peeked before extracting anything, is
+// already queued and IsoScatterAccepted() agrees, otherwise the telegram is
+// received as a whole into PDU.Payload as well.
+// The same happens if an unsolicited telegram could arrive in place of the
+// answer expected, since we cannot know it until its head is received.
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::isoRecvBufferV(int HeadSize, void *Target, int Room, int &Size, int &Direct)
+{
+	TMsgVector Vector[3];
+	int DataLength;
+	int Received;
+	int NumParts;
+	bool EoT;
+
+	ClrIsoError();
+	Size  =0;
+	Direct=0;
+	if (IsoPushExpected)
+		return isoRecvBuffer(0, Size);
+	RecvPacket(&PDU, DataHeaderSize); // TPKT + COPT_DT
+	if (LastTcpError!=0)
+		return SetIsoError(errIsoRecvPacket);
+	if (CheckPDU(&PDU, pdu_type_DT)!=0)
+	{
+		Purge();
+		return LastIsoError;
+	}
+	DataLength=PDUSize(&PDU)-DataHeaderSize;
+	EoT=(PDU.COTP.EoT_Num & 0x80) == 0x80;
+
+	if (EoT && (DataLength>=HeadSize) &&
+		(PeekQueued(&PDU.Payload, HeadSize)==HeadSize) && IsoScatterAccepted(&PDU.Payload))
+	{
+		Direct=DataLength-HeadSize;
+		if (Direct>Room)
+			Direct=Room;
+		Vector[0].Data=&PDU.Payload;
+		Vector[0].Size=HeadSize;
+		Vector[1].Data=Target;
+		Vector[1].Size=Direct;
+		Vector[2].Data=pbyte(&PDU.Payload)+HeadSize;
+		Vector[2].Size=DataLength-HeadSize-Direct;
+		if (RecvPacketV(Vector, 3)!=0)
+		{
+			Direct=0;
+			return SetIsoError(errIsoRecvPacket);
+		}
+		Size=DataLength;
+		return 0;
+	}
+
+	// Not scattered : same as isoRecvPDU
+	RecvPacket(&PDU.Payload, DataLength);
+	if (LastTcpError!=0)
+		return SetIsoError(errIsoRecvPacket);
+	Size=DataLength;
+	NumParts=1;
+	while (!EoT)
+	{
+		if (++NumParts>IsoMaxFragments)
+		{
+			Purge();
+			return SetIsoError(errIsoTooManyFragments);
+		}
+		if (isoRecvFragment(pbyte(&PDU.Payload)+Size, IsoPayload_Size-Size, Received, EoT)!=0)
+		{
+			if (LastTcpError!=WSAECONNRESET)
+				Purge();
+			return LastIsoError;
+		}
+		Size+=Received;
+	}
+	PDU.TPKT.HI_Lenght =(u_short(Size+DataHeaderSize)>>8) & 0xFF;
+	PDU.TPKT.LO_Lenght =u_short(Size+DataHeaderSize) & 0xFF;
+	return 0;
+}
+//---------------------------------------------------------------------------
 int TIsoTcpSocket::isoExchangeBuffer(void *Data, int &Size)
 {
 	int Result;
@@ -489,6 +623,40 @@ int TIsoTcpSocket::isoRecvPDU(PIsoDataPDU Data)
 	return Result;
 }
 //---------------------------------------------------------------------------
+// Walks the TPKT headers of the data queued (without extracting it) up to the
+// fragment carrying the EoT flag. A server reactor uses it to not enter into
+// isoRecvPDU() until the whole telegram is arrived.
+//---------------------------------------------------------------------------
+int TIsoTcpSocket::BytesMissing()
+{
+	byte Queued[IsoFrameSize*2];
+	int Avail;
+	int Offset;
+	int Size;
+
+	Avail =WaitingData();
+	// Nothing (or a disconnection) or more than a telegram : nothing to wait
+	if ((Avail<=0) || (Avail>int(sizeof(Queued))))
+		return 0;
+	// Not PeekPacket : it would wait and reset SO_RCVLOWAT behind the reactor
+	if (PeekQueued(&Queued, Avail)!=Avail)
+		return 0;
+	Offset =0;
+	for (;;)
+	{
+		if (Avail-Offset<int(DataHeaderSize))
+			return Offset+DataHeaderSize-Avail;
+		Size =PDUSize(&Queued[Offset]);
+		if (Size<int(DataHeaderSize))
+			return 0; // Malformed : isoRecvPDU will reject it
+		if (Avail-Offset<Size)
+			return Offset+Size-Avail;
+		if ((Queued[Offset+5]!=pdu_type_DT) || ((Queued[Offset+6] & pdu_EoT)==pdu_EoT))
+			return 0;
+		Offset+=Size;
+	}
+}
+//---------------------------------------------------------------------------
 int TIsoTcpSocket::isoExchangePDU(PIsoDataPDU Data)
 {
     int Result;
@@ -234,6 +234,14 @@ protected:
 	int IsoConfirmConnection(u_char PDUType);
     void ClrIsoError();
 	virtual void FragmentSkipped(int Size);
+	// Set by a child which can receive unsolicited telegrams from the peer
+	bool IsoPushExpected;
+	// Returns true if the telegram into PDU was an unsolicited one (and was
+	// consumed), in that case isoRecvBuffer waits for the next telegram
+	virtual bool IsoPushReceived(int Size);
+	// Returns true if the data of the telegram whose head (still queued) is
+	// passed can be stored into the Target of isoRecvBufferV
+	virtual bool IsoScatterAccepted(void *Head);
 public:
 	word SrcTSap;  // Source TSAP
 	word DstTSap;  // Destination TSAP
@@ -252,8 +260,12 @@ public:
 	int isoDisconnect(bool OnlyTCP);
 	// Sends a buffer, a valid header is created
 	int isoSendBuffer(void *Data, int Size);
+	// Sends the first HeadSize bytes of PDU.Payload followed by the buffers of Vector (see the source)
+	int isoSendBufferV(int HeadSize, PMsgVector Vector, int Count);
 	// Receives a buffer
 	int isoRecvBuffer(void *Data, int & Size);
+	// Receives a buffer, the payload is scattered between PDU.Payload and Target (see the source)
+	int isoRecvBufferV(int HeadSize, void *Target, int Room, int & Size, int & Direct);
 	// Exchange cycle send->receive
 	int isoExchangeBuffer(void *Data, int & Size);
 	// A PDU is ready (at least its header) to be read
@@ -266,6 +278,8 @@ public:
 	int isoExchangePDU(PIsoDataPDU Data);
 	// Peeks an header info to know which kind of telegram is incoming
 	void IsoPeek(void *pPDU, TPDUKind &PduKind);
+	// Bytes still missing to complete the telegram (all its fragments) queued
+	int BytesMissing();
 };
 
 #endif // s7_isotcp_h
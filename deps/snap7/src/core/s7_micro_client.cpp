@@ -41,31 +41,232 @@ TSnap7MicroClient::TSnap7MicroClient()
 	DstTSap =0x0000; // It's filled by connection functions
     ConnectionType = CONNTYPE_PG; // Default connection type
 	memset(&Job,0,sizeof(TSnap7Job));
+	memset(&Subs,0,sizeof(Subs));
+	SubsCount=0;
+	SubsLast =0;
+	TagVars  =NULL;
+	TagFirst =NULL;
+	AmQRequest=MaxAmQ; // The client pipelines its multi-PDU reads and writes
 }
 //---------------------------------------------------------------------------
 TSnap7MicroClient::~TSnap7MicroClient()
 {
     Destroying = true;
+    ClearSubs();
 }
 //---------------------------------------------------------------------------
-int TSnap7MicroClient::opReadArea()
+// Pipelining : up to AmQCalling telegrams are sent before waiting for the
+// first answer, answers are matched to their slice by the Sequence number.
+// Request() builds the telegram of a slice into the PDU, Answer() consumes
+// the answer received into the PDU.
+// If Request() leaves the user data into TxVector, they are sent after the
+// telegram head (IsoSize bytes) without being copied into the PDU.
+// If Target() is given, the answer is scattered : the headers go into the PDU
+// and the data directly into the buffer of the oldest slice in flight (the
+// one normally answered first), see InPlaceSlice/InPlaceSize. The headers
+// are checked before : an answer out of order or with an error never
+// touches the user buffer, it's received into the PDU.
+// After an error no other slice is sent, but the answers of those already
+// in flight are drained to keep the connection in sync.
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::PipelineExchange(int Slices, pfn_SliceRequest Request, pfn_SliceAnswer Answer, pfn_SliceTarget Target)
+{
+    PS7ResHeader23 ResHeader;
+    word Sequence[MaxAmQ];
+    int  SliceOf[MaxAmQ];
+    int  Window, InFlight, Next, IsoSize, Result, Oldest, Room, c;
+    pbyte Dest;
+
+    Window=AmQCalling;
+    if (Window>MaxAmQ)
+        Window=MaxAmQ;
+    if (Window<1)
+        Window=1;
+
+    ResHeader=PS7ResHeader23(&PDU.Payload);
+    InFlight =0;
+    Next     =0;
+    Result   =0;
+    while ((Next<Slices) || (InFlight>0))
+    {
+        // Fill the window
+        while ((Result==0) && (Next<Slices) && (InFlight<Window))
+        {
+            TxVectors=0;
+            Result=(this->*Request)(Next, IsoSize);
+            if (Result!=0)
+                break;
+            Sequence[InFlight]=PDUH_out->Sequence;
+            SliceOf[InFlight] =Next;
+            // If the send fails the connection is lost, nothing to drain
+            c=isoSendBufferV(IsoSize, TxVector, TxVectors);
+            if (c!=0)
+                return c;
+            InFlight++;
+            Next++;
+        }
+        if (InFlight==0)
+            break;
+
+        // Wait for the next answer
+        InPlaceSlice=-1;
+        InPlaceSize =0;
+        if ((Target!=NULL) && (Result==0))
+        {
+            Oldest=0;
+            for (c = 1; c < InFlight; c++)
+                if (SliceOf[c]<SliceOf[Oldest])
+                    Oldest=c;
+            InPlaceSequence=Sequence[Oldest];
+            Oldest=SliceOf[Oldest];
+            Dest=(this->*Target)(Oldest, Room);
+            c=isoRecvBufferV(ResHeaderSize23+sizeof(TResFunReadParams)+4, Dest, Room, IsoSize, InPlaceSize);
+            if (InPlaceSize>0)
+                InPlaceSlice=Oldest;
+        }
+        else
+            c=isoRecvBuffer(0,IsoSize);
+        if (c!=0)
+            return c;
+        for (c = 0; c < InFlight; c++)
+            if (Sequence[c]==ResHeader->Sequence)
+                break;
+        // An answer that we didn't ask for : the telegrams in flight are
+        // still drained, otherwise their answers would be taken for the
+        // ones of the next function
+        if (c==InFlight)
+        {
+            Result=errCliInvalidPlcAnswer;
+            Next=Slices;
+            continue;
+        }
+
+        if (Result==0)
+            Result=(this->*Answer)(SliceOf[c]);
+        // Remove the slice from the window
+        InFlight--;
+        Sequence[c]=Sequence[InFlight];
+        SliceOf[c] =SliceOf[InFlight];
+        if (Result!=0)
+            Next=Slices;
+    }
+    return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadAreaRequest(int Slice, int &IsoSize)
 {
      PReqFunReadParams ReqParams;
-     PResFunReadParams ResParams;
-     PS7ResHeader23    Answer;
-     PResFunReadItem   ResData;
      word              RPSize; // ReqParams size
-     int WordSize;
-     uintptr_t Offset;
-     pbyte Target;
      int Address;
-     int IsoSize;
      int Start;
-     int MaxElements;  // Max elements that we can transfer in a PDU
      word NumElements; // Num of elements that we are asking for this telegram
-     int TotElements;  // Total elements requested
-     int Size;
-     int Result;
+
+     // Request Params size
+     RPSize    =sizeof(TReqFunReadItem)+2; // 1 item + FunRead + ItemsCount
+     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+     ReqParams =PReqFunReadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
+
+     NumElements=Job.Amount-Slice*SliceElements;
+     if (NumElements>SliceElements)
+         NumElements=SliceElements;
+     Start=Job.Start+Slice*SliceElements*DataSizeByte(Job.WordLen);
+
+     PDUH_out->P = 0x32;                    // Always 0x32
+     PDUH_out->PDUType = PduType_request;   // 0x01
+     PDUH_out->AB_EX = 0x0000;              // Always 0x0000
+     PDUH_out->Sequence = GetNextWord();    // AutoInc
+     PDUH_out->ParLen = SwapWord(RPSize);   // 14 bytes params
+     PDUH_out->DataLen = 0x0000;            // No data
+
+     ReqParams->FunRead = pduFuncRead;      // 0x04
+     ReqParams->ItemsCount = 1;
+     ReqParams->Items[0].ItemHead[0] = 0x12;
+     ReqParams->Items[0].ItemHead[1] = 0x0A;
+     ReqParams->Items[0].ItemHead[2] = 0x10;
+     ReqParams->Items[0].TransportSize = Job.WordLen;
+     ReqParams->Items[0].Length = SwapWord(NumElements);
+     ReqParams->Items[0].Area = Job.Area;
+     if (Job.Area==S7AreaDB)
+          ReqParams->Items[0].DBNumber = SwapWord(Job.Number);
+     else
+          ReqParams->Items[0].DBNumber = 0x0000;
+     // Adjusts the offset
+     if ((Job.WordLen==S7WLBit) || (Job.WordLen==S7WLCounter) || (Job.WordLen==S7WLTimer))
+          Address = Start;
+     else
+          Address = Start*8;
+
+     ReqParams->Items[0].Address[2] = Address & 0x000000FF;
+     Address = Address >> 8;
+     ReqParams->Items[0].Address[1] = Address & 0x000000FF;
+     Address = Address >> 8;
+     ReqParams->Items[0].Address[0] = Address & 0x000000FF;
+
+     IsoSize = sizeof(TS7ReqHeader)+RPSize;
+     return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadAreaAnswer(int Slice)
+{
+     PResFunReadParams ResParams;
+     PS7ResHeader23    Answer;
+     PResFunReadItem   ResData;
+     pbyte Target;
+     int WordSize;
+     int Size, Room;
+
+     Answer    =PS7ResHeader23(&PDU.Payload);
+     ResParams =PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
+     ResData   =PResFunReadItem(pbyte(ResParams)+sizeof(TResFunReadParams));
+
+     WordSize=DataSizeByte(Job.WordLen);
+     Room=(Job.Amount-Slice*SliceElements);
+     if (Room>SliceElements)
+         Room=SliceElements;
+     Room*=WordSize;
+
+     // Item level error
+     if (ResData->ReturnCode==0xFF) // <-- 0xFF means Result OK
+     {
+        // Calcs data size in bytes
+        Size = SwapWord(ResData->DataLength);
+        // Adjust Size in accord of TransportSize
+        if ((ResData->TransportSize != TS_ResOctet) && (ResData->TransportSize != TS_ResReal) && (ResData->TransportSize != TS_ResBit))
+            Size = Size >> 3;
+        if (Size>Room)
+            Size=Room;
+        Target=pbyte(Job.pData)+Slice*SliceElements*WordSize;
+        if (InPlaceSlice!=Slice) // Data into the PDU, otherwise already in place
+            memcpy(Target, &ResData->Data[0], Size);
+        return 0;
+     }
+     else
+        return CpuError(ResData->ReturnCode);
+}
+//---------------------------------------------------------------------------
+bool TSnap7MicroClient::IsoScatterAccepted(void *Head)
+{
+     PS7ResHeader23  Answer =PS7ResHeader23(Head);
+     PResFunReadItem ResData=PResFunReadItem(pbyte(Head)+ResHeaderSize23+sizeof(TResFunReadParams));
+
+     return (Answer->Sequence==InPlaceSequence) && (Answer->Error==0) && (ResData->ReturnCode==0xFF);
+}
+//---------------------------------------------------------------------------
+pbyte TSnap7MicroClient::ReadAreaTarget(int Slice, int &Room)
+{
+     int WordSize=DataSizeByte(Job.WordLen);
+
+     Room=(Job.Amount-Slice*SliceElements);
+     if (Room>SliceElements)
+         Room=SliceElements;
+     Room*=WordSize;
+     return pbyte(Job.pData)+Slice*SliceElements*WordSize;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opReadArea()
+{
+     int WordSize;
+     int Slices;
 
      WordSize=DataSizeByte(Job.WordLen); // The size in bytes of an element that we are asking for
      if (WordSize==0)
@@ -76,107 +277,145 @@ int TSnap7MicroClient::opReadArea()
      // Second check : transport size
 	 if ((Job.WordLen==S7WLBit) && (Job.Amount>1))
         return errCliInvalidTransportSize;
-     // Request Params size
-     RPSize    =sizeof(TReqFunReadItem)+2; // 1 item + FunRead + ItemsCount
-     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
-     ReqParams =PReqFunReadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-     Answer    =PS7ResHeader23(&PDU.Payload);
-     ResParams =PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
-     ResData   =PResFunReadItem(pbyte(ResParams)+sizeof(TResFunReadParams));
      // Each packet cannot exceed the PDU length (in bytes) negotiated, and moreover
      // we must ensure to transfer a "finite" number of item per PDU
-     MaxElements=(PDULength-sizeof(TS7ResHeader23)-sizeof(TResFunReadParams)-4) / WordSize;
-     TotElements=Job.Amount;
-     Start      =Job.Start;
-     Offset     =0;
-     Result     =0;
-     while ((TotElements>0) && (Result==0))
-     {
-          NumElements=TotElements;
-          if (NumElements>MaxElements)
-             NumElements=MaxElements;
-
-          Target=pbyte(Job.pData)+Offset;
-          //----------------------------------------------- Read next slice-----
-          PDUH_out->P = 0x32;                    // Always 0x32
-          PDUH_out->PDUType = PduType_request;   // 0x01
-          PDUH_out->AB_EX = 0x0000;              // Always 0x0000
-          PDUH_out->Sequence = GetNextWord();    // AutoInc
-          PDUH_out->ParLen = SwapWord(RPSize);   // 14 bytes params
-          PDUH_out->DataLen = 0x0000;            // No data
-
-          ReqParams->FunRead = pduFuncRead;      // 0x04
-          ReqParams->ItemsCount = 1;
-          ReqParams->Items[0].ItemHead[0] = 0x12;
-          ReqParams->Items[0].ItemHead[1] = 0x0A;
-          ReqParams->Items[0].ItemHead[2] = 0x10;
-          ReqParams->Items[0].TransportSize = Job.WordLen;
-          ReqParams->Items[0].Length = SwapWord(NumElements);
-          ReqParams->Items[0].Area = Job.Area;
-          if (Job.Area==S7AreaDB)
-               ReqParams->Items[0].DBNumber = SwapWord(Job.Number);
-          else
-               ReqParams->Items[0].DBNumber = 0x0000;
-          // Adjusts the offset
-          if ((Job.WordLen==S7WLBit) || (Job.WordLen==S7WLCounter) || (Job.WordLen==S7WLTimer))
-               Address = Start;
-          else
-               Address = Start*8;
-
-          ReqParams->Items[0].Address[2] = Address & 0x000000FF;
-          Address = Address >> 8;
-          ReqParams->Items[0].Address[1] = Address & 0x000000FF;
-          Address = Address >> 8;
-          ReqParams->Items[0].Address[0] = Address & 0x000000FF;
-
-          IsoSize = sizeof(TS7ReqHeader)+RPSize;
-          Result = isoExchangeBuffer(0,IsoSize);
-          // Get Data
-          if (Result==0)  // 1St level Iso
-          {
-               Size = 0;
-               // Item level error
-                if (ResData->ReturnCode==0xFF) // <-- 0xFF means Result OK
-                {
-                   // Calcs data size in bytes
-                   Size = SwapWord(ResData->DataLength);
-                   // Adjust Size in accord of TransportSize
-                   if ((ResData->TransportSize != TS_ResOctet) && (ResData->TransportSize != TS_ResReal) && (ResData->TransportSize != TS_ResBit))
-                       Size = Size >> 3;
-                   memcpy(Target, &ResData->Data[0], Size);
-                }
-                else
-                     Result = CpuError(ResData->ReturnCode);
-           Offset+=Size;
-          };
-          //--------------------------------------------------------------------
-          TotElements -= NumElements;
-          Start += NumElements*WordSize;
-     }
-     return Result;
+     SliceElements=(PDULength-sizeof(TS7ResHeader23)-sizeof(TResFunReadParams)-4) / WordSize;
+     if (SliceElements<1)
+        return errCliSizeOverPDU;
+     Slices=(Job.Amount+SliceElements-1) / SliceElements;
+     return PipelineExchange(Slices, &TSnap7MicroClient::ReadAreaRequest, &TSnap7MicroClient::ReadAreaAnswer, &TSnap7MicroClient::ReadAreaTarget);
 }
 //---------------------------------------------------------------------------
-int TSnap7MicroClient::opWriteArea()
+int TSnap7MicroClient::WriteAreaRequest(int Slice, int &IsoSize)
 {
      PReqFunWriteParams   ReqParams;
      PReqFunWriteDataItem ReqData;  // only 1 item for WriteArea Function
-     PResFunWrite         ResParams;
-     PS7ResHeader23       Answer;
      word RPSize;  // ReqParams size
      word RHSize;  // Request headers size
-     bool First = true;
      pbyte Source;
-     pbyte Target;
      int Address;
-     int IsoSize;
      int WordSize;
      word Size;
-     uintptr_t Offset = 0;
      int Start;        // where we are starting from for this telegram
-     int MaxElements;  // Max elements that we can transfer in a PDU
      word NumElements; // Num of elements that we are asking for this telegram
-     int TotElements;  // Total elements requested
-     int Result = 0;
+
+     WordSize=DataSizeByte(Job.WordLen); // The size in bytes of an element that we are pushing
+     RHSize =sizeof(TS7ReqHeader)+    // Request header
+             2+                       // FunWrite+ItemCount (of TReqFunWriteParams)
+             sizeof(TReqFunWriteItem)+// 1 item reference
+             4;                       // ReturnCode+TransportSize+DataLength
+     RPSize =sizeof(TReqFunWriteItem)+2;
+
+     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+     ReqParams=PReqFunWriteParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
+     ReqData  =PReqFunWriteDataItem(pbyte(ReqParams)+sizeof(TReqFunWriteItem)+2); // 2 = FunWrite+ItemsCount
+
+     NumElements=Job.Amount-Slice*SliceElements;
+     if (NumElements>SliceElements)
+         NumElements=SliceElements;
+     Start =Job.Start+Slice*SliceElements*WordSize;
+     Source=pbyte(Job.pData)+Slice*SliceElements*WordSize;
+
+     Size=NumElements * WordSize;
+     PDUH_out->P=0x32;                    // Always 0x32
+     PDUH_out->PDUType=PduType_request;   // 0x01
+     PDUH_out->AB_EX=0x0000;              // Always 0x0000
+     PDUH_out->Sequence=GetNextWord();    // AutoInc
+     PDUH_out->ParLen  =SwapWord(RPSize); // 14 bytes params
+     PDUH_out->DataLen =SwapWord(Size+4);
+
+     ReqParams->FunWrite=pduFuncWrite;    // 0x05
+     ReqParams->ItemsCount=1;
+     ReqParams->Items[0].ItemHead[0]=0x12;
+     ReqParams->Items[0].ItemHead[1]=0x0A;
+     ReqParams->Items[0].ItemHead[2]=0x10;
+     ReqParams->Items[0].TransportSize=Job.WordLen;
+     ReqParams->Items[0].Length=SwapWord(NumElements);
+     ReqParams->Items[0].Area=Job.Area;
+     if (Job.Area==S7AreaDB)
+         ReqParams->Items[0].DBNumber=SwapWord(Job.Number);
+     else
+         ReqParams->Items[0].DBNumber=0x0000;
+
+     // Adjusts the offset
+     if ((Job.WordLen==S7WLBit) || (Job.WordLen==S7WLCounter) || (Job.WordLen==S7WLTimer))
+         Address=Start;
+     else
+         Address=Start*8;
+
+     ReqParams->Items[0].Address[2]=Address & 0x000000FF;
+     Address=Address >> 8;
+     ReqParams->Items[0].Address[1]=Address & 0x000000FF;
+     Address=Address >> 8;
+     ReqParams->Items[0].Address[0]=Address & 0x000000FF;
+
+     ReqData->ReturnCode=0x00;
+
+     switch(Job.WordLen)
+     {
+         case S7WLBit:
+             ReqData->TransportSize=TS_ResBit;
+             break;
+         case S7WLInt:
+         case S7WLDInt:
+             ReqData->TransportSize=TS_ResInt;
+             break;
+         case S7WLReal:
+             ReqData->TransportSize=TS_ResReal;
+             break;
+         case S7WLChar   :
+         case S7WLCounter:
+         case S7WLTimer:
+             ReqData->TransportSize=TS_ResOctet;
+             break;
+         default:
+             ReqData->TransportSize=TS_ResByte;
+             break;
+     };
+
+     if ((ReqData->TransportSize!=TS_ResOctet) && (ReqData->TransportSize!=TS_ResReal) && (ReqData->TransportSize!=TS_ResBit))
+         ReqData->DataLength=SwapWord(Size*8);
+     else
+         ReqData->DataLength=SwapWord(Size);
+
+     // The data follow the headers straight from the user buffer
+     TxVector[0].Data=Source;
+     TxVector[0].Size=Size;
+     TxVectors=1;
+     IsoSize=RHSize;
+     return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::WriteAreaAnswer(int Slice)
+{
+     PResFunWrite   ResParams;
+     PS7ResHeader23 Answer;
+     int Result;
+
+     Answer   =PS7ResHeader23(&PDU.Payload);
+     ResParams=PResFunWrite(pbyte(Answer)+ResHeaderSize23);
+
+     Result=CpuError(SwapWord(Answer->Error)); // 2nd level global error
+     if (Result==0)
+     {     // 2th check : item error
+         if (ResParams->Data[0] != 0xFF) // <-- 0xFF means Result OK
+         {
+             // Now we check the error : if it's the first part we report the cpu error
+             // otherwise we warn that the function failed but some data were written
+             if (Slice==0)
+                 Result=CpuError(ResParams->Data[0]);
+             else
+                 Result=errCliPartialDataWritten;
+         }
+     };
+     return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opWriteArea()
+{
+     word RHSize;  // Request headers size
+     int WordSize;
+     int Slices;
 
      WordSize=DataSizeByte(Job.WordLen); // The size in bytes of an element that we are pushing
      if (WordSize==0)
@@ -192,158 +431,66 @@ int TSnap7MicroClient::opWriteArea()
              2+                       // FunWrite+ItemCount (of TReqFunWriteParams)
              sizeof(TReqFunWriteItem)+// 1 item reference
              4;                       // ReturnCode+TransportSize+DataLength
-     RPSize =sizeof(TReqFunWriteItem)+2;
-
-     // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
-     ReqParams=PReqFunWriteParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-     ReqData  =PReqFunWriteDataItem(pbyte(ReqParams)+sizeof(TReqFunWriteItem)+2); // 2 = FunWrite+ItemsCount
-     Target   =pbyte(ReqData)+4; // 4 = ReturnCode+TransportSize+DataLength
-     Answer   =PS7ResHeader23(&PDU.Payload);
-     ResParams=PResFunWrite(pbyte(Answer)+ResHeaderSize23);
 
      // Each packet cannot exceed the PDU length (in bytes) negotiated, and moreover
      // we must ensure to transfer a "finite" number of item per PDU
-     MaxElements=(PDULength-RHSize) / WordSize;
-     TotElements=Job.Amount;
-     Start      =Job.Start;
-     while ((TotElements>0) && (Result==0))
-     {
-           NumElements=TotElements;
-           if (NumElements>MaxElements)
-               NumElements=MaxElements;
-           Source=pbyte(Job.pData)+Offset;
-
-           Size=NumElements * WordSize;
-           PDUH_out->P=0x32;                    // Always 0x32
-           PDUH_out->PDUType=PduType_request;   // 0x01
-           PDUH_out->AB_EX=0x0000;              // Always 0x0000
-           PDUH_out->Sequence=GetNextWord();    // AutoInc
-           PDUH_out->ParLen  =SwapWord(RPSize); // 14 bytes params
-           PDUH_out->DataLen =SwapWord(Size+4);
-
-           ReqParams->FunWrite=pduFuncWrite;    // 0x05
-           ReqParams->ItemsCount=1;
-           ReqParams->Items[0].ItemHead[0]=0x12;
-           ReqParams->Items[0].ItemHead[1]=0x0A;
-           ReqParams->Items[0].ItemHead[2]=0x10;
-           ReqParams->Items[0].TransportSize=Job.WordLen;
-           ReqParams->Items[0].Length=SwapWord(NumElements);
-           ReqParams->Items[0].Area=Job.Area;
-           if (Job.Area==S7AreaDB)
-               ReqParams->Items[0].DBNumber=SwapWord(Job.Number);
-           else
-               ReqParams->Items[0].DBNumber=0x0000;
-
-           // Adjusts the offset
-           if ((Job.WordLen==S7WLBit) || (Job.WordLen==S7WLCounter) || (Job.WordLen==S7WLTimer))
-               Address=Start;
-           else
-               Address=Start*8;
-
-           ReqParams->Items[0].Address[2]=Address & 0x000000FF;
-           Address=Address >> 8;
-           ReqParams->Items[0].Address[1]=Address & 0x000000FF;
-           Address=Address >> 8;
-           ReqParams->Items[0].Address[0]=Address & 0x000000FF;
-
-           ReqData->ReturnCode=0x00;
-
-           switch(Job.WordLen)
-           {
-               case S7WLBit:
-                   ReqData->TransportSize=TS_ResBit;
-                   break;
-               case S7WLInt:
-               case S7WLDInt:
-                   ReqData->TransportSize=TS_ResInt;
-                   break;
-               case S7WLReal:
-                   ReqData->TransportSize=TS_ResReal;
-                   break;
-               case S7WLChar   :
-               case S7WLCounter:
-               case S7WLTimer:
-                   ReqData->TransportSize=TS_ResOctet;
-				   break;
-			   default:
-                   ReqData->TransportSize=TS_ResByte;
-                   break;
-           };
-
-           if ((ReqData->TransportSize!=TS_ResOctet) && (ReqData->TransportSize!=TS_ResReal) && (ReqData->TransportSize!=TS_ResBit))
-               ReqData->DataLength=SwapWord(Size*8);
-           else
-               ReqData->DataLength=SwapWord(Size);
-
-           memcpy(Target, Source, Size);
-           IsoSize=RHSize + Size;
-           Result=isoExchangeBuffer(0,IsoSize);
-
-           if (Result==0) // 1St check : Iso result
-           {
-               Result=CpuError(SwapWord(Answer->Error)); // 2nd level global error
-               if (Result==0)
-               {     // 2th check : item error
-                   if (ResParams->Data[0] == 0xFF) // <-- 0xFF means Result OK
-                       Result=0;
-                   else
-                       // Now we check the error : if it's the first part we report the cpu error
-                       // otherwise we warn that the function failed but some data were written
-                       if (First)
-                           Result=CpuError(ResParams->Data[0]);
-                       else
-                           Result=errCliPartialDataWritten;
-               };
-               Offset+=Size;
-           };
-           First=false;
-
-           TotElements-=NumElements;
-           Start+=(NumElements*WordSize);
-     }
-     return Result;
+     SliceElements=(PDULength-RHSize) / WordSize;
+     if (SliceElements<1)
+        return errCliSizeOverPDU;
+     Slices=(Job.Amount+SliceElements-1) / SliceElements;
+     return PipelineExchange(Slices, &TSnap7MicroClient::WriteAreaRequest, &TSnap7MicroClient::WriteAreaAnswer, NULL);
 }
 //---------------------------------------------------------------------------
-int TSnap7MicroClient::opReadMultiVars()
+void TSnap7MicroClient::FillReadItem(PReqFunReadItem ReqItem, PS7DataItem Item)
 {
-    PS7DataItem       Item;
-    PReqFunReadParams ReqParams;
-    PS7ResHeader23    Answer;
-    PResFunReadParams ResParams;
-    TResFunReadData   ResData;
+    longword Address;
 
+    // Adjusts Word Length in case of timers and counters and clears results
+    Item->Result=0;
+    if (Item->Area==S7AreaCT)
+      Item->WordLen=S7WLCounter;
+    if (Item->Area==S7AreaTM)
+      Item->WordLen=S7WLTimer;
+
+    ReqItem->ItemHead[0]=0x12;
+    ReqItem->ItemHead[1]=0x0A;
+    ReqItem->ItemHead[2]=0x10;
+
+    ReqItem->TransportSize=Item->WordLen;
+    ReqItem->Length=SwapWord(Item->Amount);
+    ReqItem->Area=Item->Area;
+    // Automatically drops DBNumber if (Area is not DB
+    if (Item->Area==S7AreaDB)
+        ReqItem->DBNumber=SwapWord(Item->DBNumber);
+    else
+        ReqItem->DBNumber=0x0000;
+    // Adjusts the offset
+    if ((Item->WordLen==S7WLBit) || (Item->WordLen==S7WLCounter) || (Item->WordLen==S7WLTimer))
+        Address=Item->Start;
+    else
+        Address=Item->Start*8;
+    // Builds the offset
+    ReqItem->Address[2]=Address & 0x000000FF;
+    Address=Address >> 8;
+    ReqItem->Address[1]=Address & 0x000000FF;
+    Address=Address >> 8;
+    ReqItem->Address[0]=Address & 0x000000FF;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadMultiVarsRequest(PS7DataItem Item, int ItemsCount, int &IsoSize)
+{
+    PReqFunReadParams ReqParams;
     word       RPSize; // ReqParams size
-    uintptr_t  Offset =0 ;
-    word       Slice;
-    longword   Address;
-    int        IsoSize;
-    pbyte      P;
-    int        ItemsCount, c, Result;
-
-    Item       = PS7DataItem(Job.pData);
-    ItemsCount = Job.Amount;
+    int        c;
 
     // Some useful initial check to detail the errors (Since S7 CPU always answers
     // with $05 if (something is wrong in params)
     if (ItemsCount>MaxVars)
     	return errCliTooManyItems;
 
-    // Adjusts Word Length in case of timers and counters and clears results
-    for (c = 0; c < ItemsCount; c++)
-    {
-    	Item->Result=0;
-        if (Item->Area==S7AreaCT)
-          Item->WordLen=S7WLCounter;
-        if (Item->Area==S7AreaTM)
-          Item->WordLen=S7WLTimer;
-        Item++;
-    };
-
     // Let's build the PDU
     RPSize    = word(2 + ItemsCount * sizeof(TReqFunReadItem));
     ReqParams = PReqFunReadParams(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
-    Answer    = PS7ResHeader23(&PDU.Payload);
-    ResParams = PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
     // Fill Header
     PDUH_out->P=0x32;                    // Always 0x32
     PDUH_out->PDUType=PduType_request;   // 0x01
@@ -356,42 +503,30 @@ int TSnap7MicroClient::opReadMultiVars()
     ReqParams->FunRead=pduFuncRead;      // 0x04
     ReqParams->ItemsCount=ItemsCount;
 
-    Item = PS7DataItem(Job.pData);
     for (c = 0; c < ItemsCount; c++)
     {
-        ReqParams->Items[c].ItemHead[0]=0x12;
-        ReqParams->Items[c].ItemHead[1]=0x0A;
-        ReqParams->Items[c].ItemHead[2]=0x10;
-
-        ReqParams->Items[c].TransportSize=Item->WordLen;
-        ReqParams->Items[c].Length=SwapWord(Item->Amount);
-        ReqParams->Items[c].Area=Item->Area;
-        // Automatically drops DBNumber if (Area is not DB
-        if (Item->Area==S7AreaDB)
-	        ReqParams->Items[c].DBNumber=SwapWord(Item->DBNumber);
-        else
-    	    ReqParams->Items[c].DBNumber=0x0000;
-        // Adjusts the offset
-        if ((Item->WordLen==S7WLBit) || (Item->WordLen==S7WLCounter) || (Item->WordLen==S7WLTimer))
-        	Address=Item->Start;
-        else
-        	Address=Item->Start*8;
-        // Builds the offset
-        ReqParams->Items[c].Address[2]=Address & 0x000000FF;
-        Address=Address >> 8;
-        ReqParams->Items[c].Address[1]=Address & 0x000000FF;
-        Address=Address >> 8;
-        ReqParams->Items[c].Address[0]=Address & 0x000000FF;
+        FillReadItem(&ReqParams->Items[c], Item);
         Item++;
     };
 
     IsoSize=RPSize+sizeof(TS7ReqHeader);
-	if (IsoSize>PDULength) 
+	if (IsoSize>PDULength)
 		return errCliSizeOverPDU;
-	Result=isoExchangeBuffer(0,IsoSize);
+	return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadMultiVarsAnswer(PS7DataItem Item, int ItemsCount)
+{
+    PS7ResHeader23    Answer;
+    PResFunReadParams ResParams;
+    TResFunReadData   ResData;
+    uintptr_t  Offset =0 ;
+    word       Slice;
+    pbyte      P;
+    int        c;
 
-	if (Result!=0)
-        return Result;
+    Answer    = PS7ResHeader23(&PDU.Payload);
+    ResParams = PResFunReadParams(pbyte(Answer)+ResHeaderSize23);
 
     // Function level error
     if (Answer->Error!=0)
@@ -401,7 +536,6 @@ int TSnap7MicroClient::opReadMultiVars()
     	return errCliInvalidPlcAnswer;
 
     P=pbyte(ResParams)+sizeof(TResFunReadParams);
-    Item = PS7DataItem(Job.pData);
     for (c = 0; c < ItemsCount; c++)
     {
         ResData[c] =PResFunReadItem(pbyte(P)+Offset);
@@ -427,6 +561,22 @@ int TSnap7MicroClient::opReadMultiVars()
         Offset+=(4+Slice);
         Item++;
     };
+    return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opReadMultiVars()
+{
+    PS7DataItem Item;
+    int         ItemsCount, IsoSize, Result;
+
+    Item       = PS7DataItem(Job.pData);
+    ItemsCount = Job.Amount;
+
+    Result=ReadMultiVarsRequest(Item, ItemsCount, IsoSize);
+    if (Result==0)
+        Result=isoExchangeBuffer(0,IsoSize);
+    if (Result==0)
+        Result=ReadMultiVarsAnswer(Item, ItemsCount);
     return Result;
 }
 //---------------------------------------------------------------------------
@@ -438,12 +588,13 @@ int TSnap7MicroClient::opWriteMultiVars()
     TReqFunWriteData   ReqData;
     PS7ResHeader23     Answer;
     pbyte              P;
+    pbyte              Spare;
     uintptr_t          Offset;
     longword           Address;
     int                ItemsCount, c, IsoSize;
     word               RPSize; // ReqParams size
     word               Size;   // Write data size
-    int                WordSize, Result;
+    int                WordSize, Result, Fill;
 
     Item       = PS7DataItem(Job.pData);
     ItemsCount = Job.Amount;
@@ -482,7 +633,13 @@ int TSnap7MicroClient::opWriteMultiVars()
     ReqParams->FunWrite=pduFuncWrite;      // 0x05
     ReqParams->ItemsCount=ItemsCount;
 
+    // Only the first item data header follows the params, the next ones
+    // (with the fill byte of the previous item) are built apart into Spare
+    // and gathered with the user data when sending
+    Spare =P+4;
     Offset=0;
+    Fill  =0;
+    TxVectors=0;
     Item  = PS7DataItem(Job.pData);
     for (c = 0; c < ItemsCount; c++)
     {
@@ -513,7 +670,17 @@ int TSnap7MicroClient::opWriteMultiVars()
         ReqParams->Items[c].Address[0]=Address & 0x000000FF;
 
         // Items Data
-        ReqData[c]=PReqFunWriteDataItem(pbyte(P)+Offset);
+        if (c==0)
+            ReqData[c]=PReqFunWriteDataItem(P);
+        else
+        {
+            Spare[0]=0x00; // Fill byte
+            ReqData[c]=PReqFunWriteDataItem(Spare+1);
+            TxVector[TxVectors].Data=Spare+1-Fill;
+            TxVector[TxVectors].Size=4+Fill;
+            TxVectors++;
+            Spare+=5;
+        }
         ReqData[c]->ReturnCode=0x00;
 
         switch (Item->WordLen)
@@ -545,28 +712,33 @@ int TSnap7MicroClient::opWriteMultiVars()
         else
            ReqData[c]->DataLength=SwapWord(Size);
 
-        memcpy(ReqData[c]->Data, Item->pdata, Size);
+        TxVector[TxVectors].Data=Item->pdata;
+        TxVector[TxVectors].Size=Size;
+        TxVectors++;
 
 		if ((Size % 2) != 0 && (ItemsCount - c != 1))
-			Size++; // Skip fill byte for Odd frame (except for the last one)
+			Fill=1; // Fill byte for Odd frame (except for the last one)
+		else
+			Fill=0;
 
-        Offset+=(4+Size); // next item
+        Offset+=(4+Size+Fill); // next item
         Item++;
     };
 
     PDUH_out->DataLen=SwapWord(word(Offset));
 
     IsoSize=RPSize+sizeof(TS7ReqHeader)+int(Offset);
-	if (IsoSize>PDULength) 
-		return errCliSizeOverPDU;
-    Result=isoExchangeBuffer(0,IsoSize);
-
-	if (Result!=0)
-		return Result;
+    if (IsoSize>PDULength)
+        return errCliSizeOverPDU;
+    Result=isoSendBufferV(RPSize+sizeof(TS7ReqHeader)+4, TxVector, TxVectors);
+    if (Result==0)
+        Result=isoRecvBuffer(0,IsoSize);
+    if (Result!=0)
+        return Result;
 
-	// Function level error
-	if (Answer->Error!=0)
-		return CpuError(SwapWord(Answer->Error));
+    // Function level error
+    if (Answer->Error!=0)
+        return CpuError(SwapWord(Answer->Error));
 
     if (ResParams->ItemCount!=ItemsCount)
         return errCliInvalidPlcAnswer;
@@ -584,6 +756,676 @@ int TSnap7MicroClient::opWriteMultiVars()
     return Result;
 }
 //---------------------------------------------------------------------------
+// ReadTagList : a user Item is seen as a Span (a byte range), overlapping or
+// near Spans of the same Area/DB are merged into Segments, Segments are
+// split into Chunks that fit a PDU answer, and Chunks are packed into the
+// fewest ReadMultiVars telegrams (first fit decreasing).
+// Since a telegram carries at most MaxVars items, a gap smaller than the
+// average room per item is cheaper to read than to skip.
+// Bit, Counter and Timer items are never merged.
+// A merged Segment fails as a whole (e.g. if it crosses the end of a DB),
+// in that case its items are read again without merging.
+//---------------------------------------------------------------------------
+typedef struct {
+    int  Item;     // User item index
+    int  Area;
+    int  DBNumber;
+    int  WordLen;
+    int  Start;    // Byte offset (bit/element index if not mergeable)
+    int  Amount;
+    int  Size;     // Size in bytes
+    bool Bytes;    // Byte addressable : can be merged and split
+    int  Segment;
+} TTagSpan, *PTagSpan;
+
+typedef struct {
+    int  Area;
+    int  DBNumber;
+    int  WordLen;
+    int  Start;
+    int  Amount;
+    int  Size;
+    int  Offset;   // Into the scratch buffer
+    int  Count;    // Spans merged
+    int  Result;
+} TTagSegment, *PTagSegment;
+
+typedef struct {
+    int  Segment;
+    int  Start;
+    int  Amount;
+    int  Offset;   // Into the scratch buffer
+    int  Cost;     // Answer size (item header + data + fill byte)
+} TTagChunk, *PTagChunk;
+
+typedef struct {
+    int  Count;
+    int  ReqSize;
+    int  ResSize;
+} TTagBin, *PTagBin;
+
+static int CompareTagSpans(const void *A, const void *B)
+{
+    PTagSpan SA = PTagSpan(A);
+    PTagSpan SB = PTagSpan(B);
+    if (SA->Bytes != SB->Bytes) return SA->Bytes ? -1 : 1;
+    if (SA->Area != SB->Area) return SA->Area < SB->Area ? -1 : 1;
+    if (SA->DBNumber != SB->DBNumber) return SA->DBNumber < SB->DBNumber ? -1 : 1;
+    if (SA->Start != SB->Start) return SA->Start < SB->Start ? -1 : 1;
+    return SA->Item - SB->Item;
+}
+
+static int CompareTagChunks(const void *A, const void *B)
+{
+    PTagChunk CA = PTagChunk(A);
+    PTagChunk CB = PTagChunk(B);
+    if (CA->Cost != CB->Cost) return CA->Cost > CB->Cost ? -1 : 1;
+    return CA->Offset - CB->Offset;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadTags(PS7DataItem Items, int *Index, int Count, bool Merge, bool *Shared)
+{
+    PS7DataItem Item;
+    PTagSpan    Spans;
+    PTagSegment Segments, Seg;
+    PTagChunk   Chunks;
+    PTagBin     Bins;
+    PS7DataItem Vars;
+    int         *ChunkOf;
+    pbyte       Scratch;
+    int         SpansCount, SegCount, ChunksCount, BinsCount;
+    int         MaxChunk, MaxChunks, MaxGap, ReqItemSize, ReqBase, ResBase;
+    int         WordSize, Total, Slice, Size, c, b, n, Result;
+
+    ReqBase    = sizeof(TS7ReqHeader)+2;
+    ReqItemSize= sizeof(TReqFunReadItem);
+    ResBase    = sizeof(TS7ResHeader23)+sizeof(TResFunReadParams);
+    // An odd Chunk is followed by a fill byte : the room is kept even so
+    // that a full Chunk, fill byte included, still fits the answer
+    MaxChunk   = (PDULength-ResBase-4) & ~1;
+    if ((MaxChunk<1) || (ReqBase+ReqItemSize>PDULength))
+    {
+        for (c = 0; c < Count; c++)
+            Items[Index[c]].Result=errCliSizeOverPDU;
+        return errCliSizeOverPDU;
+    }
+    MaxGap     = MaxChunk / MaxVars;
+
+    // Items -> Spans
+    Spans = new TTagSpan[Count];
+    SpansCount = 0;
+    for (c = 0; c < Count; c++)
+    {
+        Item=&Items[Index[c]];
+        Item->Result=0;
+        if (Item->Area==S7AreaCT)
+          Item->WordLen=S7WLCounter;
+        if (Item->Area==S7AreaTM)
+          Item->WordLen=S7WLTimer;
+
+        WordSize=DataSizeByte(Item->WordLen);
+        if (WordSize==0)
+        {
+            Item->Result=errCliInvalidWordLen;
+            continue;
+        }
+        if ((Item->Start<0) || (Item->Amount<1) || (Item->DBNumber<0) || (Item->DBNumber>65535))
+        {
+            Item->Result=errCliInvalidParams;
+            continue;
+        }
+        if ((Item->WordLen==S7WLBit) && (Item->Amount>1))
+        {
+            Item->Result=errCliInvalidTransportSize;
+            continue;
+        }
+
+        PTagSpan Span = &Spans[SpansCount++];
+        Span->Item    =Index[c];
+        Span->Area    =Item->Area;
+        Span->DBNumber=Item->Area==S7AreaDB ? Item->DBNumber : 0;
+        Span->WordLen =Item->WordLen;
+        Span->Start   =Item->Start;
+        Span->Amount  =Item->Amount;
+        Span->Size    =Item->Amount*WordSize;
+        Span->Bytes   =(Item->WordLen!=S7WLBit) && (Item->WordLen!=S7WLCounter) && (Item->WordLen!=S7WLTimer);
+        Span->Segment =-1;
+
+        // Not mergeable items must fit a single answer
+        if (!Span->Bytes && (Span->Size>MaxChunk))
+        {
+            Item->Result=errCliSizeOverPDU;
+            SpansCount--;
+        }
+    }
+
+    // Spans -> Segments
+    qsort(Spans, SpansCount, sizeof(TTagSpan), CompareTagSpans);
+    Segments = new TTagSegment[SpansCount+1];
+    SegCount = 0;
+    Seg      = NULL;
+    for (c = 0; c < SpansCount; c++)
+    {
+        PTagSpan Span = &Spans[c];
+        if (Merge && Span->Bytes && (Seg!=NULL) && (Seg->WordLen==S7WLByte) &&
+            (Seg->Area==Span->Area) && (Seg->DBNumber==Span->DBNumber) &&
+            (Span->Start<=Seg->Start+Seg->Size+MaxGap))
+        {
+            Seg->Count++;
+            if (Span->Start+Span->Size>Seg->Start+Seg->Size)
+            {
+                Seg->Size  =Span->Start+Span->Size-Seg->Start;
+                Seg->Amount=Seg->Size;
+            }
+        }
+        else
+        {
+            Seg = &Segments[SegCount++];
+            Seg->Area    =Span->Area;
+            Seg->DBNumber=Span->DBNumber;
+            Seg->WordLen =Span->Bytes ? S7WLByte : Span->WordLen;
+            Seg->Start   =Span->Start;
+            Seg->Amount  =Span->Bytes ? Span->Size : Span->Amount;
+            Seg->Size    =Span->Size;
+            Seg->Count   =1;
+            Seg->Result  =0;
+        }
+        Span->Segment=SegCount-1;
+    }
+
+    // Segments -> Chunks
+    MaxChunks=0;
+    Total=0;
+    for (c = 0; c < SegCount; c++)
+    {
+        Segments[c].Offset=Total;
+        Total+=Segments[c].Size;
+        MaxChunks+=(Segments[c].Size+MaxChunk-1) / MaxChunk;
+    }
+    Chunks = new TTagChunk[MaxChunks+1];
+    ChunksCount = 0;
+    for (c = 0; c < SegCount; c++)
+    {
+        Seg = &Segments[c];
+        if (Seg->WordLen!=S7WLByte)
+        {
+            PTagChunk Chunk = &Chunks[ChunksCount++];
+            Chunk->Segment=c;
+            Chunk->Start  =Seg->Start;
+            Chunk->Amount =Seg->Amount;
+            Chunk->Offset =Seg->Offset;
+            Chunk->Cost   =4+Seg->Size+(Seg->Size & 1);
+            continue;
+        }
+        for (n = 0; n < Seg->Size; n+=Slice)
+        {
+            Slice = Seg->Size-n;
+            if (Slice>MaxChunk)
+                Slice=MaxChunk;
+            PTagChunk Chunk = &Chunks[ChunksCount++];
+            Chunk->Segment=c;
+            Chunk->Start  =Seg->Start+n;
+            Chunk->Amount =Slice;
+            Chunk->Offset =Seg->Offset+n;
+            Chunk->Cost   =4+Slice+(Slice & 1);
+        }
+    }
+
+    // Chunks -> Bins : the biggest first, each one into the first Bin where it fits
+    qsort(Chunks, ChunksCount, sizeof(TTagChunk), CompareTagChunks);
+    Bins = new TTagBin[ChunksCount+1];
+    int *BinOf = new int[ChunksCount+1];
+    BinsCount = 0;
+    for (c = 0; c < ChunksCount; c++)
+    {
+        for (b = 0; b < BinsCount; b++)
+        {
+            if ((Bins[b].Count<MaxVars) &&
+                (Bins[b].ReqSize+ReqItemSize<=PDULength) &&
+                (Bins[b].ResSize+Chunks[c].Cost<=PDULength))
+                break;
+        }
+        if (b==BinsCount)
+        {
+            Bins[b].Count  =0;
+            Bins[b].ReqSize=ReqBase;
+            Bins[b].ResSize=ResBase;
+            BinsCount++;
+        }
+        Bins[b].Count++;
+        Bins[b].ReqSize+=ReqItemSize;
+        Bins[b].ResSize+=Chunks[c].Cost;
+        BinOf[c]=b;
+    }
+
+    // Bins -> Vars, grouped by Bin
+    Scratch = new byte[Total+1];
+    Vars    = new TS7DataItem[ChunksCount+1];
+    ChunkOf = new int[ChunksCount+1];
+    TagFirst= new int[BinsCount+1];
+    n=0;
+    for (b = 0; b < BinsCount; b++)
+    {
+        TagFirst[b]=n;
+        for (c = 0; c < ChunksCount; c++)
+        {
+            if (BinOf[c]!=b)
+                continue;
+            Seg = &Segments[Chunks[c].Segment];
+            Vars[n].Area    =Seg->Area;
+            Vars[n].WordLen =Seg->WordLen;
+            Vars[n].DBNumber=Seg->DBNumber;
+            Vars[n].Start   =Chunks[c].Start;
+            Vars[n].Amount  =Chunks[c].Amount;
+            Vars[n].pdata   =Scratch+Chunks[c].Offset;
+            ChunkOf[n++]=c;
+        }
+    }
+    TagFirst[BinsCount]=n;
+    TagVars=Vars;
+
+    // Read the Bins
+    Result=PipelineExchange(BinsCount, &TSnap7MicroClient::ReadTagsRequest, &TSnap7MicroClient::ReadTagsAnswer, NULL);
+    for (c = 0; (c < n) && (Result==0); c++)
+    {
+        Seg = &Segments[Chunks[ChunkOf[c]].Segment];
+        if ((Vars[c].Result!=0) && (Seg->Result==0))
+            Seg->Result=Vars[c].Result;
+    }
+
+    // Scatter the Segments into the user Items
+    if (Result==0)
+    {
+        for (c = 0; c < SpansCount; c++)
+        {
+            Seg  = &Segments[Spans[c].Segment];
+            Item = &Items[Spans[c].Item];
+            Item->Result=Seg->Result;
+            Shared[Spans[c].Item]=Seg->Count>1;
+            if (Seg->Result==0)
+            {
+                Size=Spans[c].Size;
+                if (Seg->WordLen==S7WLByte)
+                    memcpy(Item->pdata, Scratch+Seg->Offset+Spans[c].Start-Seg->Start, Size);
+                else
+                    memcpy(Item->pdata, Scratch+Seg->Offset, Size);
+            }
+        }
+    }
+    else // No Item is left with a result of success
+        for (c = 0; c < SpansCount; c++)
+            Items[Spans[c].Item].Result=Result;
+
+    delete[] TagFirst;
+    TagFirst=NULL;
+    TagVars =NULL;
+    delete[] ChunkOf;
+    delete[] Vars;
+    delete[] Scratch;
+    delete[] BinOf;
+    delete[] Bins;
+    delete[] Chunks;
+    delete[] Segments;
+    delete[] Spans;
+    return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadTagsRequest(int Slice, int &IsoSize)
+{
+    return ReadMultiVarsRequest(&TagVars[TagFirst[Slice]], TagFirst[Slice+1]-TagFirst[Slice], IsoSize);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadTagsAnswer(int Slice)
+{
+    return ReadMultiVarsAnswer(&TagVars[TagFirst[Slice]], TagFirst[Slice+1]-TagFirst[Slice]);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opReadTagList()
+{
+    PS7DataItem Items;
+    int ItemsCount, c, n, Result;
+    int *Index;
+    bool *Shared;
+
+    Items      = PS7DataItem(Job.pData);
+    ItemsCount = Job.Amount;
+
+    if (ItemsCount<1)
+        return errCliInvalidParams;
+    if (!Connected)
+        return WSAENOTCONN;
+
+    Index  = new int[ItemsCount];
+    Shared = new bool[ItemsCount];
+    for (c = 0; c < ItemsCount; c++)
+    {
+        Index[c]=c;
+        Shared[c]=false;
+    }
+    Result=ReadTags(Items, Index, ItemsCount, true, Shared);
+
+    // Items of failed merged Segments are read again one by one
+    if (Result==0)
+    {
+        n=0;
+        for (c = 0; c < ItemsCount; c++)
+            if ((Items[c].Result!=0) && Shared[c])
+                Index[n++]=c;
+        if (n>0)
+            Result=ReadTags(Items, Index, n, false, Shared);
+    }
+    Job.Amount=ItemsCount;
+
+    delete[] Shared;
+    delete[] Index;
+    return Result;
+}
+//---------------------------------------------------------------------------
+// Cyclic data : the PLC pushes the data of a subscribed job every interval.
+// A push can arrive at any time, also in place of the answer of another
+// function, so, while there are subscriptions, every telegram received is
+// checked by IsoPushReceived() : the data pushed are stored into their
+// subscription (only the last ones are kept) and delivered to the user
+// items by CheckCyclic().
+//---------------------------------------------------------------------------
+PCyclicSub TSnap7MicroClient::FindSub(int JobID)
+{
+    int c;
+    for (c = 0; c < MaxCyclicJobs; c++)
+        if ((JobID!=0) && (Subs[c].JobID==JobID))
+            return &Subs[c];
+    return NULL;
+}
+//---------------------------------------------------------------------------
+void TSnap7MicroClient::FreeSub(PCyclicSub Sub)
+{
+    if (Sub->Data!=NULL)
+        delete[] Sub->Data;
+    memset(Sub,0,sizeof(TCyclicSub));
+    SubsCount--;
+    IsoPushExpected=SubsCount>0;
+}
+//---------------------------------------------------------------------------
+void TSnap7MicroClient::ClearSubs()
+{
+    int c;
+    for (c = 0; c < MaxCyclicJobs; c++)
+        if (Subs[c].JobID!=0)
+            FreeSub(&Subs[c]);
+}
+//---------------------------------------------------------------------------
+bool TSnap7MicroClient::IsoPushReceived(int Size)
+{
+    PS7ResHeader17 Header;
+    PS7ResParams7  ResParams;
+    PCyclicSub     Sub;
+    int ParLen, DataLen;
+
+    Header   =PS7ResHeader17(&PDU.Payload);
+    ResParams=PS7ResParams7(pbyte(Header)+ResHeaderSize17);
+    if ((Size<ResHeaderSize17+int(sizeof(TReqFunTypedParams))) || (Header->P!=0x32) ||
+        (Header->PDUType!=PduType_userdata) || (ResParams->Tg!=grCyclicPush))
+        return false;
+
+    ParLen =SwapWord(Header->ParLen);
+    DataLen=SwapWord(Header->DataLen);
+    Sub=FindSub(ResParams->Seq);
+    // A push of a job unknown (i.e. just unsubscribed) is dropped
+    if ((Sub!=NULL) && (ResHeaderSize17+ParLen+DataLen<=Size) && (DataLen<=PDULength))
+    {
+        memcpy(Sub->Data, pbyte(ResParams)+ParLen, DataLen);
+        Sub->Size =DataLen;
+        Sub->Fresh=true;
+    }
+    return true;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::CyclicScatter(PCyclicSub Sub)
+{
+    PResDataCyclic  ResData;
+    PResFunReadItem ResItem;
+    PS7DataItem     Item;
+    int Offset, Slice, c;
+
+    ResData=PResDataCyclic(Sub->Data);
+    if ((Sub->Size<int(sizeof(TResDataCyclic))) || (ResData->RetVal!=0xFF) ||
+        (SwapWord(ResData->ItemsCount)!=Sub->ItemsCount))
+        return errCliInvalidPlcAnswer;
+
+    Item  =Sub->Items;
+    Offset=sizeof(TResDataCyclic);
+    for (c = 0; c < Sub->ItemsCount; c++)
+    {
+        if (Offset+4>Sub->Size)
+            return errCliInvalidPlcAnswer;
+        ResItem=PResFunReadItem(Sub->Data+Offset);
+        Slice=0;
+        if (ResItem->ReturnCode==0xFF) // <-- 0xFF means Result OK
+        {
+            Slice=SwapWord(ResItem->DataLength);
+            if ((ResItem->TransportSize != TS_ResOctet) && (ResItem->TransportSize != TS_ResReal) && (ResItem->TransportSize != TS_ResBit))
+                Slice=Slice >> 3;
+            if ((Offset+4+Slice>Sub->Size) || (Slice>Item->Amount*DataSizeByte(Item->WordLen)))
+                return errCliInvalidPlcAnswer;
+            memcpy(Item->pdata, ResItem->Data, Slice);
+            Item->Result=0;
+        }
+        else
+            Item->Result=CpuError(ResItem->ReturnCode);
+
+        if ((Slice % 2)!=0)
+            Slice++; // Skip fill byte for Odd frame
+        Offset+=(4+Slice);
+        Item++;
+    }
+    return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opSubscribeCyclic()
+{
+    PS7DataItem    Item;
+    PReqFunCyclic  ReqParams;
+    PReqDataCyclic ReqData;
+    PS7ResHeader17 Answer;
+    PS7ResParams7  ResParams;
+    PCyclicSub     Sub;
+    int ItemsCount, Interval, DataLen, ParLen, IsoSize, Result, c;
+    byte TimeBase;
+    int  Factor;
+
+    Item      =PS7DataItem(Job.pData);
+    ItemsCount=Job.Amount;
+    Interval  =Job.Number;
+    *Job.pAmount=0;
+
+    if ((ItemsCount<1) || (Interval<1))
+        return errCliInvalidParams;
+    if (ItemsCount>MaxVars)
+        return errCliTooManyItems;
+    Sub=NULL;
+    for (c = 0; c < MaxCyclicJobs; c++)
+        if (Subs[c].JobID==0)
+        {
+            Sub=&Subs[c];
+            break;
+        }
+    if (Sub==NULL)
+        return errCliFunNotAvailable;
+
+    // The interval is rounded up to the time base
+    if (Interval<=9900)
+    {
+        TimeBase=CyclicBase100ms;
+        Factor  =(Interval+99) / 100;
+    }
+    else
+        if (Interval<=99000)
+        {
+            TimeBase=CyclicBase1s;
+            Factor  =(Interval+999) / 1000;
+        }
+        else
+        {
+            TimeBase=CyclicBase10s;
+            Factor  =(Interval+9999) / 10000;
+            if (Factor>99)
+                Factor=99;
+        }
+
+    // Setup pointers (note : PDUH_out and PDU.Payload are the same pointer)
+    ReqParams=PReqFunCyclic(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
+    ReqData  =PReqDataCyclic(pbyte(ReqParams)+sizeof(TReqFunCyclic));
+    Answer   =PS7ResHeader17(&PDU.Payload);
+    ResParams=PS7ResParams7(pbyte(Answer)+ResHeaderSize17);
+    DataLen  =8+ItemsCount*sizeof(TReqFunReadItem);
+    // Fill Header
+    PDUH_out->P=0x32;                    // Always 0x32
+    PDUH_out->PDUType=PduType_userdata;  // 0x07
+    PDUH_out->AB_EX=0x0000;              // Always 0x0000
+    PDUH_out->Sequence=GetNextWord();    // AutoInc
+    PDUH_out->ParLen=SwapWord(sizeof(TReqFunCyclic)); // 8 bytes params
+    PDUH_out->DataLen=SwapWord(DataLen);
+    // Fill params (mostly constants)
+    ReqParams->Head[0]=0x00;
+    ReqParams->Head[1]=0x01;
+    ReqParams->Head[2]=0x12;
+    ReqParams->Plen   =0x04;
+    ReqParams->Uk     =0x11;
+    ReqParams->Tg     =grCyclicData;
+    ReqParams->SubFun =SFun_CyclicMem;
+    ReqParams->Seq    =0x00;
+    // Fill data
+    ReqData->RetVal    =0xFF;
+    ReqData->TSize     =TS_ResOctet;
+    ReqData->Length    =SwapWord(DataLen-4);
+    ReqData->ItemsCount=SwapWord(ItemsCount);
+    ReqData->TimeBase  =TimeBase;
+    ReqData->TimeFactor=byte(Factor);
+    for (c = 0; c < ItemsCount; c++)
+        FillReadItem(&ReqData->Items[c], &Item[c]);
+
+    IsoSize=sizeof(TS7ReqHeader)+sizeof(TReqFunCyclic)+DataLen;
+    if (IsoSize>PDULength)
+        return errCliSizeOverPDU;
+    Result=isoExchangeBuffer(0,IsoSize);
+    if (Result!=0)
+        return Result;
+
+    if (ResParams->Err!=0)
+        return CpuError(SwapWord(ResParams->Err));
+    ParLen =SwapWord(Answer->ParLen);
+    DataLen=SwapWord(Answer->DataLen);
+    if ((ResParams->Seq==0) || (DataLen>PDULength) || (ResHeaderSize17+ParLen+DataLen>IsoSize))
+        return errCliInvalidPlcAnswer;
+
+    // Registers the job, from now on a push can arrive at any time
+    Sub->JobID     =ResParams->Seq;
+    Sub->ItemsCount=ItemsCount;
+    Sub->Items     =Item;
+    Sub->Data      =new byte[PDULength];
+    Sub->Fresh     =false;
+    SubsCount++;
+    IsoPushExpected=true;
+    *Job.pAmount=Sub->JobID;
+
+    // The answer carries the first data
+    memcpy(Sub->Data, pbyte(ResParams)+ParLen, DataLen);
+    Sub->Size=DataLen;
+    return CyclicScatter(Sub);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opUnsubscribeCyclic()
+{
+    PReqFunCyclic       ReqParams;
+    PReqDataCyclicUnsub ReqData;
+    PS7ResParams7       ResParams;
+    PCyclicSub          Sub;
+    int IsoSize, Result;
+
+    Sub=FindSub(Job.Number);
+    if (Sub==NULL)
+        return errCliInvalidParams;
+
+    ReqParams=PReqFunCyclic(pbyte(PDUH_out)+sizeof(TS7ReqHeader));
+    ReqData  =PReqDataCyclicUnsub(pbyte(ReqParams)+sizeof(TReqFunCyclic));
+    ResParams=PS7ResParams7(pbyte(&PDU.Payload)+ResHeaderSize17);
+    // Fill Header
+    PDUH_out->P=0x32;                    // Always 0x32
+    PDUH_out->PDUType=PduType_userdata;  // 0x07
+    PDUH_out->AB_EX=0x0000;              // Always 0x0000
+    PDUH_out->Sequence=GetNextWord();    // AutoInc
+    PDUH_out->ParLen=SwapWord(sizeof(TReqFunCyclic)); // 8 bytes params
+    PDUH_out->DataLen=SwapWord(sizeof(TReqDataCyclicUnsub));
+    // Fill params (mostly constants)
+    ReqParams->Head[0]=0x00;
+    ReqParams->Head[1]=0x01;
+    ReqParams->Head[2]=0x12;
+    ReqParams->Plen   =0x04;
+    ReqParams->Uk     =0x11;
+    ReqParams->Tg     =grCyclicData;
+    ReqParams->SubFun =SFun_CyclicUnsub;
+    ReqParams->Seq    =0x00;
+    // Fill data
+    ReqData->RetVal  =0xFF;
+    ReqData->TSize   =TS_ResOctet;
+    ReqData->Length  =SwapWord(0x0002);
+    ReqData->Function=0x01;
+    ReqData->JobID   =byte(Sub->JobID);
+
+    // The subscription is released anyway : if the PLC doesn't know it
+    // there is nothing to stop, if the connection fails it's lost
+    FreeSub(Sub);
+    IsoSize=sizeof(TS7ReqHeader)+sizeof(TReqFunCyclic)+sizeof(TReqDataCyclicUnsub);
+    Result=isoExchangeBuffer(0,IsoSize);
+    if ((Result==0) && (ResParams->Err!=0))
+        Result=CpuError(SwapWord(ResParams->Err));
+    return Result;
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::opCheckCyclic()
+{
+    PCyclicSub Sub;
+    longword Elapsed;
+    int Timeout, Left, Size, Result, c, n;
+
+    *Job.pAmount=0;
+    if (SubsCount==0)
+        return errCliInvalidParams;
+    Timeout=Job.Number;
+    Elapsed=SysGetTick();
+    Sub=NULL;
+    while (Sub==NULL)
+    {
+        // Round robin among the subscriptions with fresh data
+        for (c = 1; c <= MaxCyclicJobs; c++)
+        {
+            n=(SubsLast+c) % MaxCyclicJobs;
+            if ((Subs[n].JobID!=0) && Subs[n].Fresh)
+            {
+                Sub=&Subs[n];
+                SubsLast=n;
+                break;
+            }
+        }
+        if (Sub!=NULL)
+            break;
+        // Waits for the next push
+        Left=Timeout-int(DeltaTime(Elapsed));
+        if ((Left<0) || !CanRead(Left))
+            return errCliJobTimeout;
+        Result=isoRecvPDU(&PDU);
+        if (Result!=0)
+            return Result;
+        Size=PDUSize(&PDU)-DataHeaderSize;
+        // An answer nobody is waiting for
+        if (!IsoPushReceived(Size))
+            return errCliInvalidPlcAnswer;
+    }
+    Sub->Fresh=false;
+    *Job.pAmount=Sub->JobID;
+    return CyclicScatter(Sub);
+}
+//---------------------------------------------------------------------------
 int TSnap7MicroClient::opListBlocks()
 {
     PReqFunGetBlockInfo ReqParams;
@@ -2562,6 +3404,18 @@ int TSnap7MicroClient::PerformOperation()
         case s7opDBFill:
              Job.Result=opDBFill();
              break;
+        case s7opReadTagList:
+             Job.Result=opReadTagList();
+             break;
+        case s7opSubscribeCyclic:
+             Job.Result=opSubscribeCyclic();
+             break;
+        case s7opUnsubscribeCyclic:
+             Job.Result=opUnsubscribeCyclic();
+             break;
+        case s7opCheckCyclic:
+             Job.Result=opCheckCyclic();
+             break;
         case s7opUpload:
              Job.Result=opUpload();
              break;
@@ -2638,6 +3492,7 @@ int TSnap7MicroClient::Disconnect()
 {
      JobStart=SysGetTick();
      PeerDisconnect();
+     ClearSubs();
      Job.Time=SysGetTick()-JobStart;
 	 Job.Pending=false;
      return 0;
@@ -2658,6 +3513,7 @@ int TSnap7MicroClient::Connect()
 {
 	 int Result;
 	 JobStart=SysGetTick();
+	 ClearSubs(); // A new connection has no cyclic jobs
 	 Result  =PeerConnect();
 	 Job.Time=SysGetTick()-JobStart;
 	 return Result;
@@ -2713,6 +3569,12 @@ int TSnap7MicroClient::GetParam(int ParamNumber, void *pValue)
 	case p_i32_PDURequest:
 		*Pint32_t(pValue)=PDURequest;
 		break;
+	case p_i32_AmQRequest:
+		*Pint32_t(pValue)=AmQRequest;
+		break;
+	case p_i32_SocketHandle: // lets the caller wait for cyclic data pushes
+		*Pint32_t(pValue)=int32_t(FSocket);
+		break;
 	default: return errCliInvalidParamNumber;
     }
     return 0;
@@ -2752,6 +3614,11 @@ int TSnap7MicroClient::SetParam(int ParamNumber, void *pValue)
 	case p_i32_PDURequest:
 		PDURequest=*Pint32_t(pValue);
 		break;
+	case p_i32_AmQRequest:
+		if ((*Pint32_t(pValue)<1) || (*Pint32_t(pValue)>MaxAmQ))
+			return errCliInvalidParams;
+		AmQRequest=*Pint32_t(pValue);
+		break;
 	default: return errCliInvalidParamNumber;
     }
     return 0;
@@ -2811,6 +3678,67 @@ int TSnap7MicroClient::ReadMultiVars(PS7DataItem Item, int ItemsCount)
     	return SetError(errCliJobPending);
 }
 //---------------------------------------------------------------------------
+int TSnap7MicroClient::ReadTagList(PS7DataItem Item, int ItemsCount)
+{
+    if (!Job.Pending)
+    {
+        Job.Pending  =true;
+        Job.Op       =s7opReadTagList;
+        Job.Amount   =ItemsCount;
+        Job.pData    =Item;
+        JobStart     =SysGetTick();
+        return PerformOperation();
+    }
+    else
+    	return SetError(errCliJobPending);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::SubscribeCyclic(PS7DataItem Item, int ItemsCount, int Interval, int &JobID)
+{
+    if (!Job.Pending)
+    {
+        Job.Pending  =true;
+        Job.Op       =s7opSubscribeCyclic;
+        Job.Amount   =ItemsCount;
+        Job.Number   =Interval;
+        Job.pData    =Item;
+        Job.pAmount  =&JobID;
+        JobStart     =SysGetTick();
+        return PerformOperation();
+    }
+    else
+    	return SetError(errCliJobPending);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::UnsubscribeCyclic(int JobID)
+{
+    if (!Job.Pending)
+    {
+        Job.Pending  =true;
+        Job.Op       =s7opUnsubscribeCyclic;
+        Job.Number   =JobID;
+        JobStart     =SysGetTick();
+        return PerformOperation();
+    }
+    else
+    	return SetError(errCliJobPending);
+}
+//---------------------------------------------------------------------------
+int TSnap7MicroClient::CheckCyclic(int &JobID, int Timeout)
+{
+    if (!Job.Pending)
+    {
+        Job.Pending  =true;
+        Job.Op       =s7opCheckCyclic;
+        Job.Number   =Timeout;
+        Job.pAmount  =&JobID;
+        JobStart     =SysGetTick();
+        return PerformOperation();
+    }
+    else
+    	return SetError(errCliJobPending);
+}
+//---------------------------------------------------------------------------
 int TSnap7MicroClient::WriteMultiVars(PS7DataItem Item, int ItemsCount)
 {
     if (!Job.Pending)
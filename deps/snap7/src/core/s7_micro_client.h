@@ -198,6 +198,10 @@ typedef struct {
 #define s7opSetPassword       26
 #define s7opClearPassword     27
 #define s7opDBFill            28
+#define s7opReadTagList       29
+#define s7opSubscribeCyclic   30
+#define s7opUnsubscribeCyclic 31
+#define s7opCheckCyclic       32
 
 // Param Number (to use with setparam)
 
@@ -245,9 +249,48 @@ struct TSnap7Job
     int IParam;   // Used for full upload and CopyRamToRom extended timeout
 };
 
+// Cyclic data subscription
+typedef struct{
+    int         JobID;      // Assigned by the PLC, 0 : free slot
+    int         ItemsCount;
+    PS7DataItem Items;      // User items, their pdata receive the data pushed
+    pbyte       Data;       // Last data pushed (items as in a read answer)
+    int         Size;
+    bool        Fresh;      // Data not yet delivered to the items
+}TCyclicSub, *PCyclicSub;
+
+class TSnap7MicroClient;
+
+// Pipelined slices : builds the request of a slice / consumes its answer
+typedef int (TSnap7MicroClient::*pfn_SliceRequest)(int Slice, int &IsoSize);
+typedef int (TSnap7MicroClient::*pfn_SliceAnswer)(int Slice);
+// Where the data of a slice can be received in place
+typedef pbyte (TSnap7MicroClient::*pfn_SliceTarget)(int Slice, int &Room);
+
 class TSnap7MicroClient: public TSnap7Peer
 {
 private:
+    int SliceElements;     // ReadArea/WriteArea elements per telegram
+    PS7DataItem TagVars;   // ReadTagList items, grouped by telegram
+    int *TagFirst;         // ReadTagList first item of each telegram
+    int InPlaceSlice;      // Slice whose data were received in place
+    int InPlaceSize;       // and their size
+    word InPlaceSequence;  // Sequence of the answer allowed to be received in place
+    TMsgVector TxVector[MaxVars*2]; // User data sent without staging them into the PDU
+    int TxVectors;         // (WriteArea/WriteMultiVars) and their count
+    TCyclicSub Subs[MaxCyclicJobs];
+    int SubsCount;
+    int SubsLast;          // Last subscription delivered (round robin)
+    int PipelineExchange(int Slices, pfn_SliceRequest Request, pfn_SliceAnswer Answer, pfn_SliceTarget Target);
+    int ReadAreaRequest(int Slice, int &IsoSize);
+    int ReadAreaAnswer(int Slice);
+    pbyte ReadAreaTarget(int Slice, int &Room);
+    int WriteAreaRequest(int Slice, int &IsoSize);
+    int WriteAreaAnswer(int Slice);
+    int ReadMultiVarsRequest(PS7DataItem Item, int ItemsCount, int &IsoSize);
+    int ReadMultiVarsAnswer(PS7DataItem Item, int ItemsCount);
+    int ReadTagsRequest(int Slice, int &IsoSize);
+    int ReadTagsAnswer(int Slice);
     void FillTime(word SiemensTime, char *PTime);
     byte BCDtoByte(byte B);
     byte WordToBCD(word Value);
@@ -255,6 +298,16 @@ private:
     int opWriteArea();
     int opReadMultiVars();
     int opWriteMultiVars();
+    int ReadTags(PS7DataItem Items, int *Index, int Count, bool Merge, bool *Shared);
+    int opReadTagList();
+    void FillReadItem(PReqFunReadItem ReqItem, PS7DataItem Item);
+    PCyclicSub FindSub(int JobID);
+    void FreeSub(PCyclicSub Sub);
+    void ClearSubs();
+    int CyclicScatter(PCyclicSub Sub);
+    int opSubscribeCyclic();
+    int opUnsubscribeCyclic();
+    int opCheckCyclic();
     int opListBlocks();
     int opListBlocksOfType();
     int opAgBlockInfo();
@@ -290,6 +343,10 @@ protected:
     int DataSizeByte(int WordLength);
     int opSize; // last operation size
     int PerformOperation();
+    // Takes the cyclic data pushed by the PLC
+    bool IsoPushReceived(int Size);
+    // Only the good answer of the slice expected is received in place
+    bool IsoScatterAccepted(void *Head);
 public:
     TS7Buffer opData;
 	TSnap7MicroClient();
@@ -307,6 +364,11 @@ public:
     int WriteArea(int Area, int DBNumber, int Start, int Amount, int WordLen, void * pUsrData);
     int ReadMultiVars(PS7DataItem Item, int ItemsCount);
     int WriteMultiVars(PS7DataItem Item, int ItemsCount);
+    int ReadTagList(PS7DataItem Item, int ItemsCount);
+    // Cyclic data functions
+    int SubscribeCyclic(PS7DataItem Item, int ItemsCount, int Interval, int &JobID);
+    int UnsubscribeCyclic(int JobID);
+    int CheckCyclic(int &JobID, int Timeout);
     // Data I/O Helper functions
     int DBRead(int DBNumber, int Start, int Size, void * pUsrData);
     int DBWrite(int DBNumber, int Start, int Size, void * pUsrData);
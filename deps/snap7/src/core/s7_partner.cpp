@@ -715,6 +715,7 @@ bool TSnap7Partner::BlockSend()
     pword TotalPackSize;
     int DataPtrOffset;
     word Extra;
+    TMsgVector Vector;
 
     ClrError();
     TotalSize=TxBuffer.Size;
@@ -797,10 +798,15 @@ bool TSnap7Partner::BlockSend()
 		DataSendReq->DHead[2]=0x13;
 		DataSendReq->DHead[3]=0x00;
 		DataSendReq->R_ID    =SwapDWord(TxBuffer.R_ID);
-		memcpy(Data, Source ,Slice);
 
-		if (isoExchangeBuffer(NULL, TxIsoSize)!=0)
+		// The slice is sent straight from TxBuffer, after the headers
+		Vector.Data=Source;
+		Vector.Size=Slice;
+		if (isoSendBufferV(int(Data-pbyte(PDUH_out)), &Vector, 1)!=0)
 			SetError(errParSendingBlock);
+		else
+			if (isoRecvBuffer(NULL, TxIsoSize)!=0)
+				SetError(errParSendingBlock);
 
 		if (LastError==0)
 		{
@@ -30,6 +30,9 @@ TSnap7Peer::TSnap7Peer()
 {
     PDUH_out=PS7ReqHeader(&PDU.Payload);
     PDURequest=480; // Our request, FPDULength will contain the CPU answer
+    AmQRequest=1; // A child that can pipeline its jobs asks for more
+    AmQCalling=1;
+    AmQCalled =1;
     LastError=0;
     Destroying = false;
 }
@@ -81,8 +84,8 @@ int TSnap7Peer::NegotiatePDULength( )
     // Params
     ReqNegotiate->FunNegotiate = pduNegotiate;
     ReqNegotiate->Unknown = 0x00;
-    ReqNegotiate->ParallelJobs_1 = 0x0100;
-    ReqNegotiate->ParallelJobs_2 = 0x0100;
+    ReqNegotiate->ParallelJobs_1 = SwapWord(AmQRequest);
+    ReqNegotiate->ParallelJobs_2 = SwapWord(AmQRequest);
     ReqNegotiate->PDULength = SwapWord(PDURequest);
     IsoSize = sizeof( TS7ReqHeader ) + sizeof( TReqFunNegotiateParams );
     Result = isoExchangeBuffer(NULL, IsoSize);
@@ -94,7 +97,16 @@ int TSnap7Peer::NegotiatePDULength( )
         if ( Answer->Error != 0 )
 	    Result = SetError(errNegotiatingPDU);
         if ( Result == 0 )
+        {
 	    PDULength = SwapWord(ResNegotiate->PDULength);
+	    AmQCalling = SwapWord(ResNegotiate->ParallelJobs_1);
+	    AmQCalled  = SwapWord(ResNegotiate->ParallelJobs_2);
+	    // The CPU can grant less than requested, never more
+	    if ((AmQCalling < 1) || (AmQCalling > AmQRequest))
+	        AmQCalling = 1;
+	    if ((AmQCalled < 1) || (AmQCalled > AmQRequest))
+	        AmQCalled = 1;
+        }
     }
     return Result;
 }
@@ -34,6 +34,8 @@ const longword errPeerMask 	     = 0xFFF00000;
 const longword errPeerBase       = 0x000FFFFF;
 const longword errNegotiatingPDU = 0x00100000;
 
+const int MaxAmQ = 8; // Max parallel jobs that we ask for
+
 class TSnap7Peer: public TIsoTcpSocket
 {
 private:
@@ -49,6 +51,9 @@ public:
     int LastError;
     int PDULength;
     int PDURequest;
+    int AmQRequest;  // Parallel jobs that we ask for
+    int AmQCalling;  // Parallel jobs that we can issue
+    int AmQCalled;   // Parallel jobs that we can accept
     TSnap7Peer();
     ~TSnap7Peer();
     void PeerDisconnect();
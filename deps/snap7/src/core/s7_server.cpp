@@ -106,14 +106,60 @@ TS7Worker::TS7Worker()
     FPDULength=2048;
     DBCnt     =0;
     LastBlk   =Block_DB;
+    memset(&Cyclic,0,sizeof(Cyclic));
+    CyclicCount=0;
+    CyclicNext =-1;
+    CyclicSeq  =0;
+}
+
+bool TS7Worker::ExecuteSend()
+{
+    return ExecuteTimer(CyclicNext);
 }
 
 bool TS7Worker::ExecuteRecv()
 {
     WorkInterval=FServer->WorkInterval;
+    // Don't wait for incoming data beyond the next cyclic push
+    if ((CyclicNext>=0) && (CyclicNext<WorkInterval))
+        WorkInterval=CyclicNext;
     return TIsoTcpWorker::ExecuteRecv();
 }
 //------------------------------------------------------------------------------
+bool TS7Worker::ExecuteTimer(int &Next)
+{
+    PCyclicJob CJ;
+    longword Now;
+    int c, Left;
+
+    Next=-1;
+    if (CyclicCount==0)
+        return true;
+    Now=SysGetTick();
+    for (c = 0; c < MaxCyclicJobs; c++)
+    {
+        CJ=&Cyclic[c];
+        if (CJ->JobID==0)
+            continue;
+        Left=int(CJ->Due-Now);
+        if (Left<=0)
+        {
+            if (!CyclicPush(CJ))
+                return false;
+            CJ->Due+=CJ->Interval;
+            Left=int(CJ->Due-Now);
+            if (Left<=0) // We are late : the cycles lost are skipped
+            {
+                CJ->Due=Now+CJ->Interval;
+                Left=int(CJ->Interval);
+            }
+        }
+        if ((Next<0) || (Left<Next))
+            Next=Left;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
 bool TS7Worker::CheckPDU_in(int PayloadSize)
 {
     // Checks the size : packet size must match with header infos
@@ -261,7 +307,8 @@ bool TS7Worker::PerformPDUUsrData(int &Size)
     return Result;
 }
 //------------------------------------------------------------------------------
-int TS7Worker::DataSizeByte(int WordLength)
+// Bytes of an element, also used by the read cache
+static int WordLenSize(int WordLength)
 {
 	switch (WordLength){
 		case S7WLBit     : return 1;  // S7 sends 1 byte per bit
@@ -277,6 +324,11 @@ int TS7Worker::DataSizeByte(int WordLength)
 		default          : return 0;
      }
 }
+//------------------------------------------------------------------------------
+int TS7Worker::DataSizeByte(int WordLength)
+{
+	return WordLenSize(WordLength);
+}
 //==============================================================================
 // FUNCTION READ
 //==============================================================================
@@ -322,7 +374,7 @@ PS7Area TS7Worker::GetArea(byte S7Code, word index)
 }
 //------------------------------------------------------------------------------
 word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar,
-     int &PDURemainder, TEv &EV)
+     int &PDURemainder, TEv &EV, PSrvRWItem Item)
 {
     PS7Area P;
 	word DBNum = 0;
@@ -331,8 +383,8 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
     longword *PAdd;
     byte BitIndex, ByteVal;
 	int Multiplier;
-    void *Source = NULL;
-    PSnapCriticalSection pcs;
+    pbyte Source = NULL;
+    int Slot;
 
     P=NULL;
     EV.EvStart   =0;
@@ -420,7 +472,6 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
 		ASize = P->Size; // Area size
 		if (Start + Size > ASize)
 			return RA_OutOfRange(ResItemData, EV);
-		Source = P->PData + Start;
 	}
 
 	// Read Event (before copy data)
@@ -428,19 +479,27 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
 
 	if (FServer->ResourceLess)
 	{
-		memset(&ResItemData->Data, 0, Size);
-		if (!FServer->DoReadArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ResItemData->Data))
-			return RA_NotFound(ResItemData, EV);
+		if (Item != NULL) // Already read by BatchReadItems
+		{
+			if (Item->Result != 0)
+				return RA_NotFound(ResItemData, EV);
+			memcpy(&ResItemData->Data, Item->pData, Size);
+		}
+		else
+		{
+			memset(&ResItemData->Data, 0, Size);
+			if (!FServer->DoReadArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ResItemData->Data))
+				return RA_NotFound(ResItemData, EV);
+		}
 	}
 	else
 	{
-		// Lock the area
-		pcs = P->cs;
-		pcs->Enter();
+		// Lock the area (shared, other readers can proceed)
+		Source = FServer->EnterAreaRead(P, Slot) + Start;
 		// Get Data
 		memcpy(&ResItemData->Data, Source, Size);
 		// Unlock the area
-		pcs->Leave();
+		FServer->LeaveAreaRead(P, Slot);
 	}
 
     ResItemData->ReturnCode=0xFF;
@@ -494,6 +553,87 @@ word TS7Worker::ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar
     return Size;
 }
 //------------------------------------------------------------------------------
+// Decodes a request item into the Tag of the resourceless callbacks with the
+// same checks of ReadArea/WriteArea, false if the item will be refused
+//------------------------------------------------------------------------------
+bool TS7Worker::DecodeTag(PReqFunReadItem ReqItemPar, TS7Tag &Tag, int &Size)
+{
+    longword *PAdd;
+    longword Start;
+    int Multiplier;
+    bool ByteAddress;
+
+    Multiplier = DataSizeByte(ReqItemPar->TransportSize);
+    if (Multiplier==0)
+        return false;
+
+    if ((ReqItemPar->Area==S7AreaTM) ^ (ReqItemPar->TransportSize==S7WLTimer))
+        return false;
+
+    if ((ReqItemPar->Area==S7AreaCT) ^ (ReqItemPar->TransportSize==S7WLCounter))
+        return false;
+
+    Tag.Size = SwapWord(ReqItemPar->Length);
+    Size = Multiplier*Tag.Size;
+
+    if ((ReqItemPar->TransportSize==S7WLBit) && (Size>1))
+        return false;
+
+    PAdd=(longword*)(&ReqItemPar->Area);
+    Start=SwapDWord(*PAdd & 0xFFFFFF00);
+
+    ByteAddress=(ReqItemPar->TransportSize!=S7WLBit) &&
+                (ReqItemPar->TransportSize!=S7WLTimer) &&
+                (ReqItemPar->TransportSize!=S7WLCounter);
+
+    if (ByteAddress && ((Start % 8) !=0))
+        return false;
+
+    Tag.Area = ReqItemPar->Area;
+    if (ReqItemPar->Area==S7AreaDB)
+        Tag.DBNumber = SwapWord(ReqItemPar->DBNumber);
+    else
+        Tag.DBNumber = 0;
+    Tag.Start = ByteAddress ? Start >> 3 : Start;
+    Tag.WordLen = ReqItemPar->TransportSize;
+    return true;
+}
+//------------------------------------------------------------------------------
+// Reads all the items of the PDU with one batch callback into Scratch,
+// ReadArea then picks up the data of ItemOf[c] (NULL : not in the batch)
+//------------------------------------------------------------------------------
+void TS7Worker::BatchReadItems(PReqFunReadParams ReqParams, int ItemsCount,
+     PSrvRWItem Items, PSrvRWItem *ItemOf, pbyte Scratch)
+{
+    int c, Size, Count = 0;
+    int PDURemainder = FPDULength;
+    int Offset = 0;
+
+    for (c = 0; c < ItemsCount; c++)
+    {
+        ItemOf[c]=NULL;
+        if (!DecodeTag(&ReqParams->Items[c], Items[Count].Tag, Size))
+            continue;
+        // ReadArea will refuse the items over the PDU, here we skip at most
+        // the same ones
+        if ((PDURemainder-Size<=0) || (Offset+Size>IsoPayload_Size))
+            continue;
+        PDURemainder-=Size;
+
+        Items[Count].pData=Scratch+Offset;
+        Items[Count].Result=0;
+        memset(Items[Count].pData, 0, Size);
+        Offset+=Size;
+        ItemOf[c]=&Items[Count++];
+    }
+
+    if ((Count>0) && !FServer->DoRWAreaBatch(ClientHandle, OperationRead, Items, Count))
+    {
+        for (c = 0; c < Count; c++)
+            Items[c].Result=-1;
+    }
+}
+//------------------------------------------------------------------------------
 bool TS7Worker::PerformFunctionRead()
 {
     PReqFunReadParams ReqParams;
@@ -506,6 +646,10 @@ bool TS7Worker::PerformFunctionRead()
     TotalSize,
     PDURemainder;
     TEv EV;
+    TSrvRWItem Items[MaxVars];
+    PSrvRWItem ItemOf[MaxVars];
+    byte Scratch[IsoPayload_Size];
+    bool Batch;
 
 	PDURemainder=FPDULength;
     // Stage 1 : Setup pointers and initial check
@@ -518,13 +662,18 @@ bool TS7Worker::PerformFunctionRead()
 
     ItemsCount=ReqParams->ItemsCount;
 
+    // Resourceless with a batch callback : one call for the whole PDU
+    Batch=FServer->ResourceLess && (FServer->OnRWAreaBatch!=NULL);
+    if (Batch)
+        BatchReadItems(ReqParams, ItemsCount, Items, ItemOf, Scratch);
+
     // Stage 2 : gather data
     Offset=sizeof(TResFunReadParams);      // = 2
 
     for (c = 0; c < ItemsCount; c++)
 	{
 		ResData[c]=PResFunReadItem(pbyte(ResParams)+Offset);
-		ItemSize=ReadArea(ResData[c],&ReqParams->Items[c],PDURemainder, EV);
+		ItemSize=ReadArea(ResData[c],&ReqParams->Items[c],PDURemainder, EV, Batch ? ItemOf[c] : NULL);
 
         // S7 doesn't xfer odd byte amount
         if ((c<ItemsCount-1) && (ItemSize % 2 != 0))
@@ -585,17 +734,17 @@ byte TS7Worker::WA_DataSizeMismatch(TEv &EV)
 }
 //------------------------------------------------------------------------------
 byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem ReqItemPar,
-     TEv &EV)
+     TEv &EV, PSrvRWItem Item)
 {
 	int Multiplier;
     PS7Area P = NULL;
 	word DBNum = 0;
 	word Elements;
     longword *PAdd;
-	PSnapCriticalSection pcs;
 	longword Start, Size, ASize, DataLen, AStart;
 	pbyte Target = NULL;
 	byte BitIndex;
+	bool Changed;
 
     EV.EvStart   =0;
 	EV.EvSize    =0;
@@ -674,7 +823,6 @@ byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem Req
 		ASize = P->Size; // Area size
 		if (Start + Size > ASize)
 			return WA_OutOfRange(EV);
-		Target = pbyte(P->PData + Start);
 	}
     // Checks data size coherence
     DataLen=SwapWord(ReqItemData->DataLength);
@@ -687,11 +835,19 @@ byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem Req
 
 	if (FServer->ResourceLess)
 	{
-		if (!FServer->DoWriteArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ReqItemData->Data[0]))
-			return WA_NotFound(EV);
+		if (Item != NULL) // Already written by BatchWriteItems
+		{
+			if (Item->Result != 0)
+				return WA_NotFound(EV);
+		}
+		else
+			if (!FServer->DoWriteArea(ClientHandle, EV.EvArea, EV.EvIndex, AStart, Elements, ReqItemPar->TransportSize, &ReqItemData->Data[0]))
+				return WA_NotFound(EV);
 	}
 	else
 	{
+		// Lock the area (exclusive)
+		Target = FServer->EnterAreaWrite(P) + Start;
 		if (ReqItemPar->TransportSize==S7WLBit)
 		{
 		  if ((ReqItemData->Data[0] & 0x01) != 0)   // bit set
@@ -699,19 +855,52 @@ byte TS7Worker::WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem Req
 		  else                                      // bit reset
 			  *Target=*Target & (~BitMask[BitIndex]);
 		}
-		else {
-		  // Lock the area
-			pcs = P->cs;
-			pcs->Enter();
-			// Write Data
+		else // Write Data
 			memcpy(Target, &ReqItemData->Data[0], Size);
-			pcs->Leave();
-		};
+		Changed=FServer->MarkDirty(P, Start, Size);
+		FServer->LeaveAreaWrite(P);
+		// Only the first change after GetChanges() is notified
+		if (Changed)
+			FServer->DoChanges();
 	}
 	
 	return 0xFF;
 }
 //------------------------------------------------------------------------------
+// Writes all the items of the PDU with one batch callback, WriteArea then
+// picks up the result of ItemOf[c] (NULL : not in the batch)
+//------------------------------------------------------------------------------
+void TS7Worker::BatchWriteItems(PReqFunWriteParams ReqParams, TReqFunWriteData &ReqData,
+     int ItemsCount, PSrvRWItem Items, PSrvRWItem *ItemOf)
+{
+    int c, Size, Count = 0;
+    longword DataLen;
+
+    for (c = 0; c < ItemsCount; c++)
+    {
+        ItemOf[c]=NULL;
+        // Write and Read items share the same layout
+        if (!DecodeTag(PReqFunReadItem(&ReqParams->Items[c]), Items[Count].Tag, Size))
+            continue;
+        // Data size coherence, as in WriteArea
+        DataLen=SwapWord(ReqData[c]->DataLength);
+        if ((ReqData[c]->TransportSize!=TS_ResOctet) && (ReqData[c]->TransportSize!=TS_ResReal) && (ReqData[c]->TransportSize!=TS_ResBit))
+            DataLen=DataLen / 8;
+        if (DataLen!=longword(Size))
+            continue;
+
+        Items[Count].pData=&ReqData[c]->Data[0];
+        Items[Count].Result=0;
+        ItemOf[c]=&Items[Count++];
+    }
+
+    if ((Count>0) && !FServer->DoRWAreaBatch(ClientHandle, OperationWrite, Items, Count))
+    {
+        for (c = 0; c < Count; c++)
+            Items[c].Result=-1;
+    }
+}
+//------------------------------------------------------------------------------
 bool TS7Worker::PerformFunctionWrite()
 {
     PReqFunWriteParams ReqParams;
@@ -724,6 +913,9 @@ bool TS7Worker::PerformFunctionWrite()
 	int c, ItemsCount;
 	int ResDSize;
 	TEv EV;
+	TSrvRWItem Items[MaxVars];
+	PSrvRWItem ItemOf[MaxVars];
+	bool Batch;
 
 	// Stage 1 : Setup pointers and initial check
 	ReqParams=PReqFunWriteParams(pbyte(PDUH_in)+sizeof(TS7ReqHeader));
@@ -750,10 +942,15 @@ bool TS7Worker::PerformFunctionWrite()
 	ResData->FunWrite =pduFuncWrite;
 	ResData->ItemCount=ReqParams->ItemsCount;
 
+	// Resourceless with a batch callback : one call for the whole PDU
+	Batch=FServer->ResourceLess && (FServer->OnRWAreaBatch!=NULL);
+	if (Batch)
+		BatchWriteItems(ReqParams, ReqData, ItemsCount, Items, ItemOf);
+
 	// Stage 2 : Write data
 	for (c = 0; c < ItemsCount; c++)
 	{
-	  ResData->Data[c]=WriteArea(ReqData[c],&ReqParams->Items[c], EV);
+	  ResData->Data[c]=WriteArea(ReqData[c],&ReqParams->Items[c], EV, Batch ? ItemOf[c] : NULL);
       // For multiple items we have to create multiple events
       if (ItemsCount>1)
            DoEvent(evcDataWrite,EV.EvRetCode,EV.EvArea,EV.EvIndex,EV.EvStart,EV.EvSize);
@@ -928,7 +1125,7 @@ bool TS7Worker::PerformFunctionDownload()
     return true;
 }
 //==============================================================================
-// FUNCTIONS PROGRAMMER AND CYCLIC DATA (NOT IMPLEMENTED...yet)
+// FUNCTIONS PROGRAMMER (NOT IMPLEMENTED...yet) AND CYCLIC DATA
 //==============================================================================
 bool TS7Worker::PerformGroupProgrammer()
 {
@@ -938,9 +1135,241 @@ bool TS7Worker::PerformGroupProgrammer()
 //------------------------------------------------------------------------------
 bool TS7Worker::PerformGroupCyclicData()
 {
-    DoEvent(evcPDUincoming,evrNotImplemented,grCyclicData,0,0,0);
+    PS7ReqParams7 ReqParams;
+
+    ReqParams=PS7ReqParams7(pbyte(PDUH_in)+ReqHeaderSize);
+    switch (ReqParams->SubFun)
+    {
+        case SFun_CyclicMem   : CyclicSubscribe();
+             break;
+        case SFun_CyclicUnsub : CyclicUnsubscribe();
+             break;
+        default:
+             DoEvent(evcPDUincoming,evrNotImplemented,grCyclicData,0,0,0);
+    };
     return true;
 }
+//------------------------------------------------------------------------------
+// Builds the answer (or the push) of a cyclic job, its items are read as
+// in PerformFunctionRead
+//------------------------------------------------------------------------------
+int TS7Worker::CyclicAnswer(PCyclicJob CJ, TS7Answer17 &Answer, byte Tg, word Sequence)
+{
+    PS7ResParams7   ResParams;
+    PResDataCyclic  ResData;
+    PResFunReadItem ResItem;
+    uintptr_t       Offset;
+    word ItemSize;
+    int c, PDURemainder;
+    TEv EV;
+
+    ResParams=PS7ResParams7(pbyte(&Answer)+ResHeaderSize17);
+    ResData  =PResDataCyclic(pbyte(ResParams)+sizeof(TS7Params7));
+
+    PDURemainder=FPDULength-ResHeaderSize17-sizeof(TS7Params7)-sizeof(TResDataCyclic);
+    Offset=sizeof(TResDataCyclic);
+    for (c = 0; c < CJ->ItemsCount; c++)
+    {
+        ResItem=PResFunReadItem(pbyte(ResData)+Offset);
+        PDURemainder-=4; // Item header
+        ItemSize=ReadArea(ResItem, &CJ->Items[c], PDURemainder, EV);
+        // S7 doesn't xfer odd byte amount
+        if ((c<CJ->ItemsCount-1) && (ItemSize % 2 != 0))
+            ItemSize++;
+        Offset+=(ItemSize+4);
+    }
+
+    Answer.Header.P=0x32;
+    Answer.Header.PDUType=PduType_userdata;
+    Answer.Header.AB_EX=0x0000;
+    Answer.Header.Sequence=Sequence;
+    Answer.Header.ParLen =SwapWord(sizeof(TS7Params7));
+    Answer.Header.DataLen=SwapWord(word(Offset));
+
+    ResParams->Head[0]=0x00;
+    ResParams->Head[1]=0x01;
+    ResParams->Head[2]=0x12;
+    ResParams->Plen  =0x08;
+    ResParams->Uk    =0x12;
+    ResParams->Tg    =Tg;
+    ResParams->SubFun=SFun_CyclicMem;
+    ResParams->Seq   =CJ->JobID;
+    ResParams->resvd =0x0000;
+    ResParams->Err   =0x0000;
+
+    ResData->RetVal    =0xFF;
+    ResData->TSize     =TS_ResOctet;
+    ResData->Length    =SwapWord(word(Offset)-4);
+    ResData->ItemsCount=SwapWord(word(CJ->ItemsCount));
+
+    return ResHeaderSize17+sizeof(TS7Params7)+int(Offset);
+}
+//------------------------------------------------------------------------------
+bool TS7Worker::CyclicPush(PCyclicJob CJ)
+{
+    TS7Answer17 Answer;
+    int TotalSize;
+
+    TotalSize=CyclicAnswer(CJ, Answer, grCyclicPush, 0x0000);
+    return isoSendBuffer(&Answer, TotalSize)==0;
+}
+//------------------------------------------------------------------------------
+void TS7Worker::CyclicSubscribe()
+{
+    PS7ReqParams7  ReqParams;
+    PS7ResParams7  ResParams;
+    PReqDataCyclic ReqData;
+    TS7Answer17    Answer;
+    PCyclicJob     CJ;
+    longword       Interval;
+    int            ItemsCount, TotalSize, c;
+    word           Error;
+    pbyte          Data;
+
+    ReqParams=PS7ReqParams7(pbyte(PDUH_in)+ReqHeaderSize);
+    ReqData  =PReqDataCyclic(pbyte(ReqParams)+SwapWord(PDUH_in->ParLen));
+    ItemsCount=SwapWord(ReqData->ItemsCount);
+
+    switch (ReqData->TimeBase)
+    {
+        case CyclicBase100ms : Interval=100;
+             break;
+        case CyclicBase1s    : Interval=1000;
+             break;
+        case CyclicBase10s   : Interval=10000;
+             break;
+        default : Interval=0;
+    };
+    Interval*=ReqData->TimeFactor;
+
+    CJ=NULL;
+    if ((ItemsCount<1) || (ItemsCount>MaxVars) || (Interval==0) ||
+        (SwapWord(PDUH_in->DataLen)<int(8+ItemsCount*sizeof(TReqFunReadItem))))
+        Error=Code7InvalidValue;
+    else
+    {
+        for (c = 0; c < MaxCyclicJobs; c++)
+            if (Cyclic[c].JobID==0)
+            {
+                CJ=&Cyclic[c];
+                break;
+            }
+        if (CJ!=NULL)
+            Error=Code7Ok;
+        else
+            Error=Code7FunNotAvailable; // Too many jobs
+    }
+
+    if (Error==Code7Ok)
+    {
+        // Job ID : never zero and unique within the connection
+        do
+        {
+            if (++CyclicSeq==0)
+                CyclicSeq=1;
+            for (c = 0; c < MaxCyclicJobs; c++)
+                if (Cyclic[c].JobID==CyclicSeq)
+                    break;
+        } while (c<MaxCyclicJobs);
+
+        CJ->JobID     =CyclicSeq;
+        CJ->Interval  =Interval;
+        CJ->ItemsCount=ItemsCount;
+        memcpy(CJ->Items, ReqData->Items, ItemsCount*sizeof(TReqFunReadItem));
+        CyclicCount++;
+        // The answer carries the first data
+        TotalSize=CyclicAnswer(CJ, Answer, grCyclicRes, PDUH_in->Sequence);
+        CJ->Due=SysGetTick()+Interval;
+        isoSendBuffer(&Answer, TotalSize);
+        DoEvent(evcCyclicData,evrNoError,evsCyclicSubscribe,CJ->JobID,ItemsCount,Interval/100);
+    }
+    else
+    {
+        ResParams=PS7ResParams7(pbyte(&Answer)+ResHeaderSize17);
+        Data=pbyte(ResParams)+sizeof(TS7Params7);
+        Answer.Header.P=0x32;
+        Answer.Header.PDUType=PduType_userdata;
+        Answer.Header.AB_EX=0x0000;
+        Answer.Header.Sequence=PDUH_in->Sequence;
+        Answer.Header.ParLen =SwapWord(sizeof(TS7Params7));
+        Answer.Header.DataLen=SwapWord(0x0004);
+        ResParams->Head[0]=ReqParams->Head[0];
+        ResParams->Head[1]=ReqParams->Head[1];
+        ResParams->Head[2]=ReqParams->Head[2];
+        ResParams->Plen  =0x08;
+        ResParams->Uk    =0x12;
+        ResParams->Tg    =grCyclicRes;
+        ResParams->SubFun=ReqParams->SubFun;
+        ResParams->Seq   =0x00;
+        ResParams->resvd =0x0000;
+        ResParams->Err   =SwapWord(Error);
+        Data[0]=0x0A;
+        Data[1]=0x00;
+        Data[2]=0x00;
+        Data[3]=0x00;
+        isoSendBuffer(&Answer, ResHeaderSize17+sizeof(TS7Params7)+4);
+        DoEvent(evcCyclicData,evrInvalidCyclicJob,evsCyclicSubscribe,0,ItemsCount,Interval/100);
+    }
+}
+//------------------------------------------------------------------------------
+void TS7Worker::CyclicUnsubscribe()
+{
+    PS7ReqParams7       ReqParams;
+    PS7ResParams7       ResParams;
+    PReqDataCyclicUnsub ReqData;
+    TS7Answer17         Answer;
+    pbyte               Data;
+    int                 c;
+    byte                JobID;
+
+    ReqParams=PS7ReqParams7(pbyte(PDUH_in)+ReqHeaderSize);
+    ReqData  =PReqDataCyclicUnsub(pbyte(ReqParams)+SwapWord(PDUH_in->ParLen));
+    ResParams=PS7ResParams7(pbyte(&Answer)+ResHeaderSize17);
+    Data     =pbyte(ResParams)+sizeof(TS7Params7);
+
+    JobID=ReqData->JobID;
+    for (c = 0; c < MaxCyclicJobs; c++)
+        if ((JobID!=0) && (Cyclic[c].JobID==JobID))
+            break;
+
+    Answer.Header.P=0x32;
+    Answer.Header.PDUType=PduType_userdata;
+    Answer.Header.AB_EX=0x0000;
+    Answer.Header.Sequence=PDUH_in->Sequence;
+    Answer.Header.ParLen =SwapWord(sizeof(TS7Params7));
+    Answer.Header.DataLen=SwapWord(0x0004);
+    ResParams->Head[0]=ReqParams->Head[0];
+    ResParams->Head[1]=ReqParams->Head[1];
+    ResParams->Head[2]=ReqParams->Head[2];
+    ResParams->Plen  =0x08;
+    ResParams->Uk    =0x12;
+    ResParams->Tg    =grCyclicRes;
+    ResParams->SubFun=ReqParams->SubFun;
+    ResParams->Seq   =JobID;
+    ResParams->resvd =0x0000;
+
+    if (c<MaxCyclicJobs)
+    {
+        Cyclic[c].JobID=0;
+        CyclicCount--;
+        ResParams->Err=0x0000;
+        Data[0]=0xFF;
+        Data[1]=TS_ResOctet;
+    }
+    else
+    {
+        ResParams->Err=SwapWord(Code7InvalidValue);
+        Data[0]=0x0A;
+        Data[1]=0x00;
+    }
+    Data[2]=0x00;
+    Data[3]=0x00;
+    isoSendBuffer(&Answer, ResHeaderSize17+sizeof(TS7Params7)+4);
+    if (c<MaxCyclicJobs)
+        DoEvent(evcCyclicData,evrNoError,evsCyclicUnsubscribe,JobID,0,0);
+    else
+        DoEvent(evcCyclicData,evrInvalidCyclicJob,evsCyclicUnsubscribe,JobID,0,0);
+}
 //==============================================================================
 // BLOCK(S) INFO FUNCTIONS
 //==============================================================================
@@ -1050,7 +1479,7 @@ void TS7Worker::BLK_ListBoT(byte BlockType, bool Start, TCB &CB)
 	      while ((cnt<MaxItems) && (DBCnt<HiBound))
 	      {
 		      DBCnt++;
-		      if (FServer->DB[DBCnt]!=NULL)
+		      if ((DBCnt<HiBound) && (FServer->DB[DBCnt]!=NULL))
 		      {
 			      Data->Items[cnt].BlockNum=SwapWord(FServer->DB[DBCnt]->Number);
 			      Data->Items[cnt].Unknown  =0x22;
@@ -1728,13 +2157,162 @@ bool TS7Worker::PerformSetClock()
     return true;
 }
 //------------------------------------------------------------------------------
+// RESOURCELESS READ CACHE
+//------------------------------------------------------------------------------
+TRWCache::TRWCache()
+{
+	memset(&Entries,0,sizeof(Entries));
+	cs = new TSnapCriticalSection();
+	Gen=0;
+	Seq=0;
+	TTL=0;
+}
+//------------------------------------------------------------------------------
+TRWCache::~TRWCache()
+{
+	for (int c = 0; c < RWCacheSlots; c++)
+		delete[] Entries[c].Data;
+	delete cs;
+}
+//------------------------------------------------------------------------------
+PRWCacheEntry TRWCache::EntryOf(PS7Tag Tag)
+{
+	longword h = longword(Tag->Area)*0x9E3779B1u ^ longword(Tag->DBNumber)*0x85EBCA77u ^
+		longword(Tag->Start)*0xC2B2AE3Du ^ longword(Tag->Size)*0x27D4EB2Fu ^ longword(Tag->WordLen);
+	return &Entries[(h ^ (h >> 16)) % RWCacheSlots];
+}
+//------------------------------------------------------------------------------
+// Timers and counters have their own areas, in the others a bit tag
+// addresses a bit and the rest a byte
+//------------------------------------------------------------------------------
+static void TagRange(PS7Tag Tag, int &Start, int &Size)
+{
+	switch (Tag->WordLen)
+	{
+		case S7WLBit     : Start=Tag->Start >> 3; Size=1; break;
+		case S7WLCounter :
+		case S7WLTimer   : Start=Tag->Start; Size=Tag->Size; break;
+		default          : Start=Tag->Start; Size=Tag->Size*WordLenSize(Tag->WordLen);
+	}
+}
+//------------------------------------------------------------------------------
+bool TRWCache::Overlaps(PRWCacheEntry Entry, PS7Tag Tag)
+{
+	int StartA, SizeA, StartB, SizeB;
+
+	if ((Entry->Size==0) || (Entry->Tag.Area!=Tag->Area) || (Entry->Tag.DBNumber!=Tag->DBNumber))
+		return false;
+	TagRange(&Entry->Tag, StartA, SizeA);
+	TagRange(Tag, StartB, SizeB);
+	return (StartA < StartB+SizeB) && (StartB < StartA+SizeA);
+}
+//------------------------------------------------------------------------------
+bool TRWCache::Get(PS7Tag Tag, void *pData)
+{
+	PRWCacheEntry Entry;
+	longword Time;
+	bool Result = false;
+
+	cs->Enter();
+	Entry=EntryOf(Tag);
+	if ((Entry->Size>0) && (Entry->Gen==Gen) &&
+		(Entry->Tag.Area==Tag->Area) && (Entry->Tag.DBNumber==Tag->DBNumber) &&
+		(Entry->Tag.Start==Tag->Start) && (Entry->Tag.Size==Tag->Size) &&
+		(Entry->Tag.WordLen==Tag->WordLen))
+	{
+		Time=Entry->Time;
+		if (DeltaTime(Time)<TTL)
+		{
+			memcpy(pData, Entry->Data, Entry->Size);
+			Result=true;
+		}
+	}
+	cs->Leave();
+	return Result;
+}
+//------------------------------------------------------------------------------
+int TRWCache::Sequence()
+{
+	int Result;
+	cs->Enter();
+	Result=Seq;
+	cs->Leave();
+	return Result;
+}
+//------------------------------------------------------------------------------
+void TRWCache::Put(PS7Tag Tag, void *pData, int Sequence)
+{
+	PRWCacheEntry Entry;
+	int Size = Tag->Size*WordLenSize(Tag->WordLen);
+
+	if (Size<=0)
+		return;
+	cs->Enter();
+	// A write happened meanwhile, the data could be older than it
+	if (Sequence==Seq)
+	{
+		Entry=EntryOf(Tag);
+		if (Entry->Capacity<Size)
+		{
+			delete[] Entry->Data;
+			Entry->Data=new byte[Size];
+			Entry->Capacity=Size;
+		}
+		memcpy(Entry->Data, pData, Size);
+		Entry->Tag=*Tag;
+		Entry->Size=Size;
+		Entry->Gen=Gen;
+		Entry->Time=SysGetTick();
+	}
+	cs->Leave();
+}
+//------------------------------------------------------------------------------
+void TRWCache::Invalidate(PS7Tag Tag)
+{
+	cs->Enter();
+	Seq++;
+	for (int c = 0; c < RWCacheSlots; c++)
+	{
+		if (Overlaps(&Entries[c], Tag))
+			Entries[c].Size=0;
+	}
+	cs->Leave();
+}
+//------------------------------------------------------------------------------
+void TRWCache::Clear(int Area, int DBNumber)
+{
+	cs->Enter();
+	Seq++;
+	if (Area==0)
+		Gen++;
+	else
+		for (int c = 0; c < RWCacheSlots; c++)
+		{
+			if ((Entries[c].Tag.Area==Area) && ((Area!=S7AreaDB) || (Entries[c].Tag.DBNumber==DBNumber)))
+				Entries[c].Size=0;
+		}
+	cs->Leave();
+}
+//------------------------------------------------------------------------------
 // S7 SERVER CLASS
 //------------------------------------------------------------------------------
 TSnap7Server::TSnap7Server()
 {
 	CSRWHook = new TSnapCriticalSection();
+	RWEventFilters = new TSnapRWLock();
+	CSEventStats = new TSnapCriticalSection();
+	EventFiltersCount=0;
+	EventStatsCount=0;
+	EventsAggregate=false;
 	OnReadEvent=NULL;
-	memset(&DB,0,sizeof(DB));
+	OnRWArea=NULL;
+	OnRWAreaBatch=NULL;
+	OnChanges=NULL;
+	RWAreaConcurrent=false;
+	DBSlots=MaxDB;
+	DB=new PS7Area[DBSlots];
+	memset(DB,0,DBSlots*sizeof(PS7Area));
+	memset(&DBMap,0,sizeof(DBMap));
     memset(&HA,0,sizeof(HA));
     DBCount=0;
     DBLimit=0;
@@ -1748,7 +2326,12 @@ TSnap7Server::TSnap7Server()
 TSnap7Server::~TSnap7Server()
 {
     DisposeAll();
+	for (int c = 0; c < DBMapPages; c++)
+		delete[] DBMap[c];
+	delete[] DB;
 	delete CSRWHook;
+	delete RWEventFilters;
+	delete CSEventStats;
 }
 //------------------------------------------------------------------------------
 PWorkerSocket TSnap7Server::CreateWorkerSocket(socket_t Sock)
@@ -1762,44 +2345,69 @@ PWorkerSocket TSnap7Server::CreateWorkerSocket(socket_t Sock)
 //------------------------------------------------------------------------------
 PS7Area TSnap7Server::FindDB(word DBNumber)
 {
-    int c;
-    int max=DBLimit+1;
+    // Paired with the exchanges of MapDB : a page (or an area) is seen only
+    // once its content is visible, also on weakly ordered CPUs
+    PS7Area *Page = (PS7Area *)SnapAtomicRead((void * volatile *)&DBMap[DBNumber >> 8]);
 
-    for (c=0; c<max; c++)
+    if (Page!=NULL)
+        return PS7Area(SnapAtomicRead((void * volatile *)&Page[DBNumber & 0xFF]));
+    else
+        return NULL;
+}
+//------------------------------------------------------------------------------
+void TSnap7Server::MapDB(word Number, PS7Area TheArea)
+{
+    PS7Area *Page = DBMap[Number >> 8];
+
+    if (Page==NULL)
     {
-        if (DB[c]!=NULL)
-        {
-	        if (DB[c]->Number==DBNumber)
-	        {
-                return DB[c];
-	        }
-	    }
+        // Pages are never released until the server is destroyed, so FindDB
+        // can run without locks
+        Page=new PS7Area[DBMapPageSize];
+        memset(Page, 0, DBMapPageSize*sizeof(PS7Area));
+        SnapAtomicExchange((void * volatile *)&DBMap[Number >> 8], Page);
     }
-    return NULL;
+    SnapAtomicExchange((void * volatile *)&Page[Number & 0xFF], TheArea);
 }
 //------------------------------------------------------------------------------
 int TSnap7Server::IndexOfDB(word DBNumber)
 {
+    PS7Area TheDB = FindDB(DBNumber);
     int c;
     int max=DBLimit+1;
 
+    if (TheDB==NULL)
+        return -1;
     for (c=0; c<max; c++)
     {
-		if (DB[c]!=NULL)
-		{
-			if (DB[c]->Number==DBNumber)
-			{
-				return c;
-			}
-		}
+		if (DB[c]==TheDB)
+			return c;
     }
     return -1;
 }
 //------------------------------------------------------------------------------
+int TSnap7Server::SetMaxDB(int Value)
+{
+    PS7Area *NewDB;
+
+    if ((Value<1) || ((DBCount>0) && (Value<=DBLimit)))
+        return errSrvInvalidParams;
+    NewDB=new PS7Area[Value];
+    memset(NewDB, 0, Value*sizeof(PS7Area));
+    if (DBCount>0)
+        memcpy(NewDB, DB, (DBLimit+1)*sizeof(PS7Area));
+    delete[] DB;
+    DB=NewDB;
+    DBSlots=Value;
+    if (DBLimit>=DBSlots)
+        DBLimit=0;
+    return 0;
+}
+//------------------------------------------------------------------------------
 int TSnap7Server::FindFirstFreeDB()
 {
     int c;
-    for (c=0; c < MaxDB; c++)
+    for (c=0; c < DBSlots; c++)
     {
         if (DB[c]==NULL)
 	        return c;
@@ -1807,6 +2415,46 @@ int TSnap7Server::FindFirstFreeDB()
     return -1;
 }
 //------------------------------------------------------------------------------
+PS7Area TSnap7Server::CreateArea(word Number, void *pUsrData, word Size)
+{
+    PS7Area TheArea;
+    int Blocks = (Size+DirtyBlock-1) / DirtyBlock;
+
+    TheArea =new TS7Area;
+    TheArea->Number=Number;
+    TheArea->rw=new TSnapRWLock();
+    TheArea->cs=new TSnapCriticalSection();
+    TheArea->Epoch=0;
+    TheArea->Readers[0]=0;
+    TheArea->Readers[1]=0;
+    TheArea->PData=pbyte(pUsrData);
+    TheArea->Size=Size;
+    TheArea->Dirty=new byte[(Blocks+7) / 8 + 1];
+    memset(TheArea->Dirty, 0, (Blocks+7) / 8 + 1);
+    TheArea->DirtyLo=Blocks;
+    TheArea->DirtyHi=-1;
+    return TheArea;
+}
+//------------------------------------------------------------------------------
+void TSnap7Server::DeleteArea(PS7Area TheArea)
+{
+    if (TheArea->rw!=NULL)
+        delete TheArea->rw;
+    if (TheArea->cs!=NULL)
+        delete TheArea->cs;
+    delete[] TheArea->Dirty;
+    delete TheArea;
+}
+//------------------------------------------------------------------------------
+PS7Area TSnap7Server::FindArea(int AreaCode, word Index)
+{
+    if ((AreaCode>=srvAreaPE) && (AreaCode<=srvAreaTM))
+        return HA[AreaCode];
+    if (AreaCode==srvAreaDB)
+        return FindDB(Index);
+    return NULL;
+}
+//------------------------------------------------------------------------------
 int TSnap7Server::RegisterDB(word Number, void *pUsrData, word Size)
 {
     PS7Area TheArea;
@@ -1822,12 +2470,9 @@ int TSnap7Server::RegisterDB(word Number, void *pUsrData, word Size)
     if (index==-1)
         return errSrvTooManyDB;
 
-    TheArea =new TS7Area;
-    TheArea->Number=Number;
-    TheArea->cs=new TSnapCriticalSection();
-    TheArea->PData=pbyte(pUsrData);
-    TheArea->Size=Size;
+    TheArea=CreateArea(Number, pUsrData, Size);
     DB[index]=TheArea;
+    MapDB(Number, TheArea);
     DBCount++;
     if (DBLimit<index)
         DBLimit=index;
@@ -1839,7 +2484,7 @@ void TSnap7Server::DisposeAll()
     PS7Area TheDB;
     int c;
     // Unregister DBs
-    for (c = 0; c < MaxDB; c++)
+    for (c = 0; c < DBSlots; c++)
     {
 		if (DB[c]!=NULL)
 		{
@@ -1847,9 +2492,8 @@ void TSnap7Server::DisposeAll()
 			// however we can minimize the risk...
 			TheDB=DB[c];
 			DB[c]=NULL;
-			if (TheDB->cs!=0)
-					delete TheDB->cs;
-			delete TheDB;
+			MapDB(TheDB->Number, NULL);
+			DeleteArea(TheDB);
 		}
     }
     DBCount=0;
@@ -1870,10 +2514,7 @@ int TSnap7Server::RegisterSys(int AreaCode, void *pUsrData, word Size)
 
     if (HA[AreaCode]==0)
     {
-	TheArea=new TS7Area;
-	TheArea->cs=new TSnapCriticalSection();
-	TheArea->PData=pbyte(pUsrData);
-	TheArea->Size=Size;
+	TheArea=CreateArea(0, pUsrData, Size);
 	HA[AreaCode]=TheArea;
 	return 0;
     }
@@ -1892,9 +2533,8 @@ int TSnap7Server::UnregisterDB(word DBNumber)
     // however we can minimize the risk...
     TheDB=DB[index];
     DB[index]=NULL;
-    if (TheDB->cs!=NULL)
-        delete TheDB->cs;
-    delete TheDB;
+    MapDB(DBNumber, NULL);
+    DeleteArea(TheDB);
     DBCount--;
 
     return 0;
@@ -1909,9 +2549,7 @@ int TSnap7Server::UnregisterSys(int AreaCode)
 		// however we can minimize the risk...
 		TheArea=HA[AreaCode];
 		HA[AreaCode]=NULL;
-		if (TheArea->cs!=NULL)
-			 delete TheArea->cs;
-		delete TheArea;
+		DeleteArea(TheArea);
     }
     return 0;
 }
@@ -1937,6 +2575,27 @@ int TSnap7Server::GetParam(int ParamNumber, void *pValue)
 	case p_i32_PDURequest:
 		*Pint32_t(pValue) = ForcePDU;
 		break;
+	case p_i32_ReactorThreads:
+		*Pint32_t(pValue) = ReactorThreads;
+		break;
+	case p_i32_MaxDB:
+		*Pint32_t(pValue) = DBSlots;
+		break;
+	case p_i32_RWAreaConcurrent:
+		*Pint32_t(pValue) = RWAreaConcurrent ? 1 : 0;
+		break;
+	case p_i32_RWCacheTTL:
+		*Pint32_t(pValue) = RWCache.TTL;
+		break;
+	case p_i32_EventsDropped:
+		*Pint32_t(pValue) = EventsDropped();
+		break;
+	case p_i32_EventsAggregate:
+		*Pint32_t(pValue) = EventsAggregate ? 1 : 0;
+		break;
+	case p_i32_EventsConcurrent:
+		*Pint32_t(pValue) = EventsConcurrent ? 1 : 0;
+		break;
 	default: return errSrvInvalidParamNumber;
     }
     return 0;
@@ -1978,6 +2637,41 @@ int TSnap7Server::SetParam(int ParamNumber, void *pValue)
          else
 	         return errSrvCannotChangeParam;
          break;
+	case p_i32_ReactorThreads:
+		if (Status == SrvStopped)
+		{
+			int Threads = *Pint32_t(pValue);
+#ifdef EPOLL_REACTOR
+			if ((Threads < 0) || (Threads > MaxReactors))
+#else
+			if (Threads != 0) // Thread per connection is the only model available
+#endif
+				return errSrvInvalidParams;
+			ReactorThreads = Threads;
+		}
+		else
+			return errSrvCannotChangeParam;
+		break;
+	case p_i32_MaxDB:
+		if (Status == SrvStopped)
+			return SetMaxDB(*Pint32_t(pValue));
+		else
+			return errSrvCannotChangeParam;
+	case p_i32_RWAreaConcurrent:
+		RWAreaConcurrent = *Pint32_t(pValue) != 0;
+		break;
+	case p_i32_RWCacheTTL:
+		if (*Pint32_t(pValue) < 0)
+			return errSrvInvalidParams;
+		RWCache.TTL = *Pint32_t(pValue);
+		RWCache.Clear(0, 0);
+		break;
+	case p_i32_EventsAggregate:
+		EventsAggregate = *Pint32_t(pValue) != 0;
+		break;
+	case p_i32_EventsConcurrent:
+		EventsConcurrent = *Pint32_t(pValue) != 0;
+		break;
 	default: return errSrvInvalidParamNumber;
     }
     return 0;
@@ -2004,13 +2698,13 @@ int TSnap7Server::UnregisterArea(int AreaCode, word Index)
 //------------------------------------------------------------------------------
 int TSnap7Server::LockArea(int AreaCode, word DBNumber)
 {
-  int index;
+  PS7Area TheDB;
 
   if ((AreaCode>=srvAreaPE) && (AreaCode<=srvAreaTM))
   {
       if (HA[AreaCode]!=0)
       {
-		  HA[AreaCode]->cs->Enter();
+		  EnterAreaWrite(HA[AreaCode]);
 		  return 0;
       }
       else
@@ -2019,10 +2713,10 @@ int TSnap7Server::LockArea(int AreaCode, word DBNumber)
   else
       if (AreaCode==srvAreaDB)
       {
-		  index=IndexOfDB(DBNumber);
-		  if (index!=-1)
+		  TheDB=FindDB(DBNumber);
+		  if (TheDB!=NULL)
 	  {
-	      DB[index]->cs->Enter();
+	      EnterAreaWrite(TheDB);
 	      return 0;
 	  }
 	  else
@@ -2034,13 +2728,13 @@ int TSnap7Server::LockArea(int AreaCode, word DBNumber)
 //------------------------------------------------------------------------------
 int TSnap7Server::UnlockArea(int AreaCode, word DBNumber)
 {
-  int index;
+  PS7Area TheDB;
 
   if ((AreaCode>=srvAreaPE) && (AreaCode<=srvAreaTM))
   {
       if (HA[AreaCode]!=0)
       {
-		  HA[AreaCode]->cs->Leave();
+		  LeaveAreaWrite(HA[AreaCode]);
 		  return 0;
       }
       else
@@ -2049,10 +2743,10 @@ int TSnap7Server::UnlockArea(int AreaCode, word DBNumber)
   else
       if (AreaCode==srvAreaDB)
       {
-		  index=IndexOfDB(DBNumber);
-		  if (index!=-1)
+		  TheDB=FindDB(DBNumber);
+		  if (TheDB!=NULL)
 	  {
-	      DB[index]->cs->Leave();
+	      LeaveAreaWrite(TheDB);
 	      return 0;
 	  }
 	  else
@@ -2062,6 +2756,248 @@ int TSnap7Server::UnlockArea(int AreaCode, word DBNumber)
 		  return errSrvInvalidParams;
 }
 //------------------------------------------------------------------------------
+// AREA ACCESS
+//------------------------------------------------------------------------------
+// The readers share the area lock, the writers (clients writes, SetAreaData
+// and LockArea) own it and are serialized by the area cs.
+// PublishArea replaces the whole image swapping PData without taking the
+// area lock, so it never blocks the readers. To know when the old image
+// is no longer used, every reader is counted into Readers[Epoch & 1]: the
+// publisher moves Epoch forward and waits until the readers of the old
+// epoch have finished. A reader that sees Epoch moving while it's being
+// counted simply retries.
+//------------------------------------------------------------------------------
+pbyte TSnap7Server::EnterAreaRead(PS7Area TheArea, int &Slot)
+{
+    int Epoch;
+
+    for (;;)
+    {
+        Epoch=SnapAtomicAdd(&TheArea->Epoch, 0);
+        Slot=Epoch & 0x01;
+        SnapAtomicAdd(&TheArea->Readers[Slot], 1);
+        if (SnapAtomicAdd(&TheArea->Epoch, 0)==Epoch)
+            break;
+        SnapAtomicAdd(&TheArea->Readers[Slot], -1);
+    }
+    TheArea->rw->EnterRead();
+    return pbyte(SnapAtomicRead((void * volatile *)&TheArea->PData));
+}
+//------------------------------------------------------------------------------
+void TSnap7Server::LeaveAreaRead(PS7Area TheArea, int Slot)
+{
+    TheArea->rw->LeaveRead();
+    SnapAtomicAdd(&TheArea->Readers[Slot], -1);
+}
+//------------------------------------------------------------------------------
+pbyte TSnap7Server::EnterAreaWrite(PS7Area TheArea)
+{
+    TheArea->cs->Enter();
+    TheArea->rw->EnterWrite();
+    return pbyte(SnapAtomicRead((void * volatile *)&TheArea->PData));
+}
+//------------------------------------------------------------------------------
+void TSnap7Server::LeaveAreaWrite(PS7Area TheArea)
+{
+    TheArea->rw->LeaveWrite();
+    TheArea->cs->Leave();
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::PublishArea(int AreaCode, word Index, void *pNewData, void **pOldData)
+{
+    PS7Area TheArea;
+    pbyte Source, Target;
+    int Offset, Slice, Slot, Waits;
+    bool Changed = false;
+
+    TheArea=FindArea(AreaCode, Index);
+    if ((TheArea==NULL) || (pNewData==NULL) || (pOldData==NULL))
+        return errSrvInvalidParams;
+
+    TheArea->cs->Enter();
+    // Change tracking : the new image is compared with the current one.
+    // Nobody else can write it now, and the readers don't care.
+    Source=pbyte(pNewData);
+    Target=pbyte(SnapAtomicRead((void * volatile *)&TheArea->PData));
+    for (Offset = 0; Offset < TheArea->Size; Offset+=Slice)
+    {
+        Slice=TheArea->Size-Offset;
+        if (Slice>DirtyBlock)
+            Slice=DirtyBlock;
+        if (memcmp(Target+Offset, Source+Offset, Slice)!=0)
+            Changed=MarkDirty(TheArea, Offset, Slice) || Changed;
+    }
+    *pOldData=SnapAtomicExchange((void * volatile *)&TheArea->PData, pNewData);
+    // Waits for the readers that could still use the old image. They hold
+    // it for a memcpy only, so we yield a few times before really sleeping
+    Slot=(SnapAtomicAdd(&TheArea->Epoch, 1)-1) & 0x01;
+    Waits=0;
+    while (SnapAtomicAdd(&TheArea->Readers[Slot], 0)!=0)
+        SysSleep(++Waits<PublishYields ? 0 : 1);
+    TheArea->cs->Leave();
+    if (Changed)
+        DoChanges();
+    return 0;
+}
+//------------------------------------------------------------------------------
+// CHANGE TRACKING
+//------------------------------------------------------------------------------
+// Every area has a bitmap of DirtyBlock bytes blocks, set by the clients
+// writes and by SetAreaData(), and consumed by GetChanges() which returns
+// the changed ranges. The callback is called only when an area becomes
+// dirty, so, the consumer is notified once until it collects the changes.
+//------------------------------------------------------------------------------
+bool TSnap7Server::MarkDirty(PS7Area TheArea, int Start, int Size)
+{
+    bool WasClean = TheArea->DirtyLo > TheArea->DirtyHi;
+    int Lo, Hi, c;
+
+    if (Size<1)
+        return false;
+    Lo = Start / DirtyBlock;
+    Hi = (Start+Size-1) / DirtyBlock;
+    for (c = Lo; c <= Hi; c++)
+        TheArea->Dirty[c >> 3] |= BitMask[c & 0x07];
+    if (Lo<TheArea->DirtyLo)
+        TheArea->DirtyLo=Lo;
+    if (Hi>TheArea->DirtyHi)
+        TheArea->DirtyHi=Hi;
+    return WasClean;
+}
+//------------------------------------------------------------------------------
+void TSnap7Server::DoChanges()
+{
+    if (!Destroying && (OnChanges != NULL))
+    {
+        try
+        { // callback is outside here, we have to shield it
+            OnChanges(FChangesUsrPtr);
+        } catch (...)
+        {
+        };
+    }
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::GetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    PS7Area TheArea;
+    int Slot;
+
+    TheArea=FindArea(AreaCode, Index);
+    if (TheArea==NULL)
+        return errSrvInvalidParams;
+    if ((Start<0) || (Size<0) || (Start>TheArea->Size) || (Size>TheArea->Size-Start) || ((pUsrData==NULL) && (Size>0)))
+        return errSrvInvalidParams;
+
+    memcpy(pUsrData, EnterAreaRead(TheArea, Slot)+Start, Size);
+    LeaveAreaRead(TheArea, Slot);
+    return 0;
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::SetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    PS7Area TheArea;
+    pbyte Source, Target;
+    int Offset, Slice;
+    bool Changed = false;
+
+    TheArea=FindArea(AreaCode, Index);
+    if (TheArea==NULL)
+        return errSrvInvalidParams;
+    if ((Start<0) || (Size<0) || (Start>TheArea->Size) || (Size>TheArea->Size-Start) || ((pUsrData==NULL) && (Size>0)))
+        return errSrvInvalidParams;
+
+    Source=pbyte(pUsrData);
+    Target=EnterAreaWrite(TheArea)+Start;
+    // Only the blocks really changed are copied and marked
+    Offset=0;
+    while (Offset<Size)
+    {
+        Slice=DirtyBlock - (Start+Offset) % DirtyBlock;
+        if (Slice>Size-Offset)
+            Slice=Size-Offset;
+        if (memcmp(Target+Offset, Source+Offset, Slice)!=0)
+        {
+            memcpy(Target+Offset, Source+Offset, Slice);
+            Changed=MarkDirty(TheArea, Start+Offset, Slice) || Changed;
+        }
+        Offset+=Slice;
+    }
+    LeaveAreaWrite(TheArea);
+    if (Changed)
+        DoChanges();
+    return 0;
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::CollectChanges(int AreaCode, PS7Area TheArea, PSrvChange pChanges, int Count)
+{
+    int Result = 0;
+    int c, Hi;
+    bool Set;
+
+    // The bitmap is guarded by the writers lock, the readers can proceed
+    TheArea->cs->Enter();
+    Hi=TheArea->DirtyHi;
+    c=TheArea->DirtyLo;
+    while ((c<=Hi) && (Result<Count))
+    {
+        Set=(TheArea->Dirty[c >> 3] & BitMask[c & 0x07])!=0;
+        if (Set)
+        {
+            pChanges[Result].Area=AreaCode;
+            pChanges[Result].Index=TheArea->Number;
+            pChanges[Result].Start=c*DirtyBlock;
+            // Adjacent blocks are merged, the last range takes the rest if
+            // there is no more room
+            while ((c<=Hi) && ((Result==Count-1) || (TheArea->Dirty[c >> 3] & BitMask[c & 0x07])!=0))
+                c++;
+            pChanges[Result].Size=c*DirtyBlock-pChanges[Result].Start;
+            if (pChanges[Result].Start+pChanges[Result].Size>TheArea->Size)
+                pChanges[Result].Size=TheArea->Size-pChanges[Result].Start;
+            Result++;
+        }
+        else
+            c++;
+    }
+    memset(TheArea->Dirty, 0, TheArea->DirtyHi / 8 + 1);
+    TheArea->DirtyLo=(TheArea->Size+DirtyBlock-1) / DirtyBlock;
+    TheArea->DirtyHi=-1;
+    TheArea->cs->Leave();
+    return Result;
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::GetChanges(PSrvChange pChanges, int &Count)
+{
+    PS7Area TheArea;
+    int Result = 0;
+    int c;
+
+    if ((pChanges==NULL) || (Count<1))
+        return errSrvInvalidParams;
+    // The areas that don't fit stay dirty, the caller will ask again
+    for (c = srvAreaPE; c <= srvAreaTM && Result<Count; c++)
+    {
+        TheArea=HA[c];
+        if ((TheArea!=NULL) && (TheArea->DirtyLo<=TheArea->DirtyHi))
+            Result+=CollectChanges(c, TheArea, &pChanges[Result], Count-Result);
+    }
+    for (c = 0; c <= DBLimit && Result<Count; c++)
+    {
+        TheArea=DB[c];
+        if ((TheArea!=NULL) && (TheArea->DirtyLo<=TheArea->DirtyHi))
+            Result+=CollectChanges(srvAreaDB, TheArea, &pChanges[Result], Count-Result);
+    }
+    Count=Result;
+    return 0;
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::SetChangesCallBack(pfn_SrvChangesCallBack PCallBack, void *UsrPtr)
+{
+    OnChanges = PCallBack;
+    FChangesUsrPtr = UsrPtr;
+    return 0;
+}
+//------------------------------------------------------------------------------
 int TSnap7Server::SetReadEventsCallBack(pfn_SrvCallBack PCallBack, void *UsrPtr) 
 {
     OnReadEvent = PCallBack;
@@ -2073,7 +3009,39 @@ int TSnap7Server::SetRWAreaCallBack(pfn_RWAreaCallBack PCallBack, void *UsrPtr)
 {
 	OnRWArea = PCallBack;
 	FRWAreaUsrPtr = UsrPtr;
-	ResourceLess = OnRWArea != NULL;
+	ResourceLess = (OnRWArea != NULL) || (OnRWAreaBatch != NULL);
+	return 0;
+}
+//---------------------------------------------------------------------------
+// srvAreaXX <-> S7 area codes of the client requests (and of the data events)
+static const byte S7Code[] = {S7AreaPE, S7AreaPA, S7AreaMK, S7AreaCT, S7AreaTM, S7AreaDB};
+
+static int SrvAreaOf(int S7Area)
+{
+	for (int c = srvAreaPE; c <= srvAreaDB; c++)
+		if (S7Code[c] == S7Area)
+			return c;
+	return -1;
+}
+//---------------------------------------------------------------------------
+int TSnap7Server::InvalidateCache(int AreaCode, word DBNumber)
+{
+	// The cache is keyed by the S7 codes of the client requests
+	if (AreaCode < 0)
+		RWCache.Clear(0, 0);
+	else
+		if (AreaCode <= srvAreaDB)
+			RWCache.Clear(S7Code[AreaCode], DBNumber);
+		else
+			return errSrvUnknownArea;
+	return 0;
+}
+//---------------------------------------------------------------------------
+int TSnap7Server::SetRWAreaBatchCallBack(pfn_RWAreaBatchCallBack PCallBack, void *UsrPtr)
+{
+	OnRWAreaBatch = PCallBack;
+	FRWAreaBatchUsrPtr = UsrPtr;
+	ResourceLess = (OnRWArea != NULL) || (OnRWAreaBatch != NULL);
 	return 0;
 }
 //---------------------------------------------------------------------------
@@ -2083,7 +3051,8 @@ void TSnap7Server::DoReadEvent(int Sender, longword Code, word RetCode, word Par
     TSrvEvent SrvReadEvent;
     if (!Destroying && (OnReadEvent != NULL))
     {
-        CSEvent->Enter();
+        if (!EventsConcurrent)
+            CSEvent->Enter();
 
         time(&SrvReadEvent.EvtTime);
         SrvReadEvent.EvtSender = Sender;
@@ -2100,24 +3069,38 @@ void TSnap7Server::DoReadEvent(int Sender, longword Code, word RetCode, word Par
         } catch (...)
         {
         };
-        CSEvent->Leave();
+        if (!EventsConcurrent)
+            CSEvent->Leave();
     };
 }
 //---------------------------------------------------------------------------
 bool TSnap7Server::DoReadArea(int Sender, int Area, int DBNumber, int Start, int Size, int WordLen, void *pUsrData)
 {
-	TS7Tag Tag;
+	TS7Tag Tag, Key;
 	bool Result = false;
+	bool Cached = RWCache.TTL > 0;
+	int Sequence = 0;
 	if (!Destroying && (OnRWArea != NULL))
 	{
-		CSRWHook->Enter();
+		Key.Area = Area;
+		Key.DBNumber = DBNumber;
+		Key.Start = Start;
+		Key.Size = Size;
+		Key.WordLen = WordLen;
+		// Served without the callback if recently read
+		if (Cached)
+		{
+			if (RWCache.Get(&Key, pUsrData))
+				return true;
+			Sequence = RWCache.Sequence();
+		}
+		// The callback can be called concurrently by the workers if it's able
+		// to handle that (RWAreaConcurrent)
+		if (!RWAreaConcurrent)
+			CSRWHook->Enter();
 		try
 		{ 
-			Tag.Area = Area;
-			Tag.DBNumber = DBNumber;
-			Tag.Start = Start;
-			Tag.Size = Size;
-			Tag.WordLen = WordLen;
+			Tag = Key;
 			// callback is outside here, we have to shield it
 			Result = OnRWArea(FRWAreaUsrPtr, Sender, OperationRead, &Tag, pUsrData) == 0;
 		}
@@ -2125,7 +3108,10 @@ bool TSnap7Server::DoReadArea(int Sender, int Area, int DBNumber, int Start, int
 		{
 			Result = false;
 		};
-		CSRWHook->Leave();
+		if (!RWAreaConcurrent)
+			CSRWHook->Leave();
+		if (Result && Cached)
+			RWCache.Put(&Key, pUsrData, Sequence);
 	}
 	return Result;
 }
@@ -2136,7 +3122,10 @@ bool TSnap7Server::DoWriteArea(int Sender, int Area, int DBNumber, int Start, in
 	bool Result = false;
 	if (!Destroying && (OnRWArea != NULL))
 	{
-		CSRWHook->Enter();
+		// The callback can be called concurrently by the workers if it's able
+		// to handle that (RWAreaConcurrent)
+		if (!RWAreaConcurrent)
+			CSRWHook->Enter();
 		try
 		{ 
 			Tag.Area = Area;
@@ -2151,9 +3140,200 @@ bool TSnap7Server::DoWriteArea(int Sender, int Area, int DBNumber, int Start, in
 		{
 			Result = false;
 		};
-		CSRWHook->Leave();
+		if (!RWAreaConcurrent)
+			CSRWHook->Leave();
+		// Also on error, the data could be partially written
+		if (RWCache.TTL > 0)
+		{
+			Tag.Area = Area;
+			Tag.DBNumber = DBNumber;
+			Tag.Start = Start;
+			Tag.Size = Size;
+			Tag.WordLen = WordLen;
+			RWCache.Invalidate(&Tag);
+		}
 	}
 	return Result;
 }
+//---------------------------------------------------------------------------
+bool TSnap7Server::DoRWAreaBatch(int Sender, int Operation, PSrvRWItem Items, int ItemsCount)
+{
+	TSrvRWItem Miss[MaxVars];
+	TS7Tag Keys[MaxVars];
+	int Index[MaxVars];
+	int c, Count = 0;
+	int Sequence = 0;
+	bool Cached = (RWCache.TTL > 0) && (ItemsCount <= MaxVars);
+	bool Result = false;
 
+	if (!Destroying && (OnRWAreaBatch != NULL))
+	{
+		// Only the reads not cached go to the callback
+		if (Cached && (Operation == OperationRead))
+		{
+			Sequence = RWCache.Sequence();
+			for (c = 0; c < ItemsCount; c++)
+			{
+				if (RWCache.Get(&Items[c].Tag, Items[c].pData))
+					Items[c].Result = 0;
+				else
+				{
+					Keys[Count] = Items[c].Tag;
+					Index[Count] = c;
+					Miss[Count++] = Items[c];
+				}
+			}
+			if (Count == 0)
+				return true;
+		}
+		if (Cached && (Operation == OperationWrite))
+		{
+			for (c = 0; c < ItemsCount; c++)
+				Keys[c] = Items[c].Tag;
+		}
+
+		if (!RWAreaConcurrent)
+			CSRWHook->Enter();
+		try
+		{ // callback is outside here, we have to shield it
+			if (Count > 0)
+				Result = OnRWAreaBatch(FRWAreaBatchUsrPtr, Sender, Operation, Miss, Count) == 0;
+			else
+				Result = OnRWAreaBatch(FRWAreaBatchUsrPtr, Sender, Operation, Items, ItemsCount) == 0;
+		}
+		catch (...)
+		{
+			Result = false;
+		};
+		if (!RWAreaConcurrent)
+			CSRWHook->Leave();
+
+		if (Count > 0)
+		{
+			for (c = 0; c < Count; c++)
+			{
+				Items[Index[c]].Result = Result ? Miss[c].Result : -1;
+				if (Items[Index[c]].Result == 0)
+					RWCache.Put(&Keys[c], Miss[c].pData, Sequence);
+			}
+			// The cached items are served anyway
+			Result = true;
+		}
+		else if (Cached && (Operation == OperationWrite))
+		{
+			// Also on error, the data could be partially written
+			for (c = 0; c < ItemsCount; c++)
+				RWCache.Invalidate(&Keys[c]);
+		}
+	}
+	return Result;
+}
+//------------------------------------------------------------------------------
+// EVENT FILTERS AND AGGREGATION
+//------------------------------------------------------------------------------
+// The masks are checked first, they are the cheapest test. Then, if there
+// are filters, the event must match one of them. Finally, in aggregation
+// mode, the data events are only counted, GetEventStats() collects them.
+//------------------------------------------------------------------------------
+void TSnap7Server::DoEvent(int Sender, longword Code, word RetCode, word Param1,
+  word Param2, word Param3, word Param4)
+{
+    if (Destroying || ((Code & (EventMask | LogMask))==0))
+        return;
+    if ((SnapAtomicAdd(&EventFiltersCount, 0)>0) && !EventPasses(Sender, Code, Param1, Param2))
+        return;
+    if (EventsAggregate && ((Code & (evcDataRead | evcDataWrite))!=0) &&
+        CountEvent(Sender, Code, Param1, Param2, Param4))
+        return;
+    TCustomMsgServer::DoEvent(Sender, Code, RetCode, Param1, Param2, Param3, Param4);
+}
+//------------------------------------------------------------------------------
+// Data events carry Area (S7 code), DB number, Start and Size into the params
+bool TSnap7Server::EventPasses(int Sender, longword Code, word Param1, word Param2)
+{
+    bool Data = (Code & (evcDataRead | evcDataWrite))!=0;
+    int Area = Data ? SrvAreaOf(Param1) : -1;
+    bool Result = false;
+    PSrvEventFilter Filter;
 
+    RWEventFilters->EnterRead();
+    for (int c = 0; c < EventFiltersCount && !Result; c++)
+    {
+        Filter=&EventFilters[c];
+        Result=((Code & Filter->Code)!=0) &&
+               ((Filter->Sender==0) || (Filter->Sender==longword(Sender))) &&
+               (!Data || (Filter->Area<0) || ((Filter->Area==Area) &&
+                 ((Area!=srvAreaDB) || ((Param2>=Filter->DBFrom) && (Param2<=Filter->DBTo)))));
+    }
+    RWEventFilters->LeaveRead();
+    return Result;
+}
+//------------------------------------------------------------------------------
+// Returns false if the table is full, the event is then queued as usual
+bool TSnap7Server::CountEvent(int Sender, longword Code, word Param1, word Param2, word Param4)
+{
+    int Area = SrvAreaOf(Param1);
+    int Index = Area==srvAreaDB ? Param2 : 0;
+    PSrvEventStat Stat = NULL;
+    int c;
+
+    CSEventStats->Enter();
+    for (c = 0; c < EventStatsCount; c++)
+        if ((EventStats[c].Sender==longword(Sender)) && (EventStats[c].Area==Area) && (EventStats[c].Index==Index))
+        {
+            Stat=&EventStats[c];
+            break;
+        }
+    if ((Stat==NULL) && (EventStatsCount<MaxEventStats))
+    {
+        Stat=&EventStats[EventStatsCount++];
+        memset(Stat, 0, sizeof(TSrvEventStat));
+        Stat->Sender=Sender;
+        Stat->Area=Area;
+        Stat->Index=Index;
+    }
+    if (Stat!=NULL)
+    {
+        if (Code==evcDataRead)
+        {
+            Stat->Reads++;
+            Stat->ReadBytes+=Param4;
+        }
+        else
+        {
+            Stat->Writes++;
+            Stat->WriteBytes+=Param4;
+        }
+    }
+    CSEventStats->Leave();
+    return Stat!=NULL;
+}
+//------------------------------------------------------------------------------
+int TSnap7Server::SetEventFilters(PSrvEventFilter pFilters, int Count)
+{
+    if ((Count<0) || (Count>MaxEventFilters) || ((Count>0) && (pFilters==NULL)))
+        return errSrvInvalidParams;
+    RWEventFilters->EnterWrite();
+    if (Count>0)
+        memcpy(EventFilters, pFilters, Count*sizeof(TSrvEventFilter));
+    // Also read outside the lock, as a hint, by DoEvent
+    SnapAtomicAdd(&EventFiltersCount, Count-EventFiltersCount);
+    RWEventFilters->LeaveWrite();
+    return 0;
+}
+//------------------------------------------------------------------------------
+// Copies the counters collected since the last call and resets them
+int TSnap7Server::GetEventStats(PSrvEventStat pStats, int &Count)
+{
+    if ((pStats==NULL) || (Count<1))
+        return errSrvInvalidParams;
+    CSEventStats->Enter();
+    if (Count>EventStatsCount)
+        Count=EventStatsCount;
+    memcpy(pStats, EventStats, Count*sizeof(TSrvEventStat));
+    // The ones that don't fit are kept for the next call
+    memmove(EventStats, &EventStats[Count], (EventStatsCount-Count)*sizeof(TSrvEventStat));
+    EventStatsCount-=Count;
+    CSEventStats->Leave();
+    return 0;
+}
@@ -31,10 +31,16 @@
 #include "s7_isotcp.h"
 //---------------------------------------------------------------------------
 
-// Maximum number of DB, change it to increase/decrease the limit.
-// The DB table size is 12*MaxDB bytes
+// Default maximum number of DB, it can be changed at runtime with the
+// p_i32_MaxDB param. The DB table size is sizeof(pointer)*MaxDB bytes
 
 #define MaxDB 2048    // Like a S7 318
+// DB lookup map : DBMap[Number>>8][Number & 0xFF], pages allocated on demand
+#define DBMapPages 256
+#define DBMapPageSize 256
+// Event filters and aggregation counters (clients x areas)
+#define MaxEventFilters 32
+#define MaxEventStats 256
 #define MinPduSize 240
 #define CPU315PduSize 240
 //---------------------------------------------------------------------------
@@ -58,10 +64,21 @@ const int srvAreaDB = 5;
 typedef struct{
 	word   Number; // Number (only for DB)
 	word   Size;   // Area size (in bytes)
-	pbyte  PData;  // Pointer to area
-	PSnapCriticalSection cs;
+	pbyte volatile PData; // Pointer to area (current image, see PublishArea)
+	PSnapRWLock rw; // Shared by the readers, exclusive for the writers
+	PSnapCriticalSection cs; // Serializes the writers and the publishers
+	volatile int Epoch;      // Readers tracking for PublishArea
+	volatile int Readers[2];
+	pbyte  Dirty;  // Bitmap of the blocks changed since the last GetChanges()
+	int    DirtyLo;// Window of the changed blocks (DirtyLo>DirtyHi : clean)
+	int    DirtyHi;
 }TS7Area, *PS7Area;
 
+// Granularity (bytes) of the change tracking
+const int DirtyBlock = 16;
+// Yields of PublishArea waiting for the readers before sleeping 1 ms a time
+const int PublishYields = 64;
+
 //------------------------------------------------------------------------------
 // ISOTCP WORKER CLASS
 //------------------------------------------------------------------------------
@@ -111,6 +128,15 @@ typedef struct{
   word                DataLength;
 }TCB;
 
+// Cyclic data job
+typedef struct{
+    byte     JobID;      // 0 : free slot
+    longword Interval;   // ms
+    longword Due;        // Tick of the next push
+    int      ItemsCount;
+    TReqFunReadItem Items[MaxVars];
+}TCyclicJob, *PCyclicJob;
+
 class TSnap7Server; // forward declaration
 
 class TS7Worker : public TIsoTcpWorker
@@ -120,12 +146,17 @@ private:
 	int DBCnt;
     byte LastBlk;
     TSZL SZL;
+    TCyclicJob Cyclic[MaxCyclicJobs];
+    int CyclicCount;
+    int CyclicNext;   // ms before the next push (-1 : none)
+    byte CyclicSeq;
     byte BCD(word Value);
     // Checks the consistence of the incoming PDU
     bool CheckPDU_in(int PayloadSize);
     void FillTime(PS7Time PTime);
 protected:
     int DataSizeByte(int WordLength);
+    bool ExecuteSend();
     bool ExecuteRecv();
     void DoEvent(longword Code, word RetCode, word Param1, word Param2,
       word Param3, word Param4);
@@ -144,15 +175,21 @@ protected:
     bool PerformFunctionRead();
     // Subfunctions Read Data
     word ReadArea(PResFunReadItem ResItemData, PReqFunReadItem ReqItemPar,
-    int &PDURemainder,TEv &EV);
+    int &PDURemainder,TEv &EV, PSrvRWItem Item = NULL);
     word RA_NotFound(PResFunReadItem ResItem, TEv &EV);
     word RA_OutOfRange(PResFunReadItem ResItem, TEv &EV);
     word RA_SizeOverPDU(PResFunReadItem ResItem, TEv &EV);
+    // Resourceless batch : all the items of a PDU in one callback
+    bool DecodeTag(PReqFunReadItem ReqItemPar, TS7Tag &Tag, int &Size);
+    void BatchReadItems(PReqFunReadParams ReqParams, int ItemsCount,
+         PSrvRWItem Items, PSrvRWItem *ItemOf, pbyte Scratch);
+    void BatchWriteItems(PReqFunWriteParams ReqParams, TReqFunWriteData &ReqData,
+         int ItemsCount, PSrvRWItem Items, PSrvRWItem *ItemOf);
     // Group Write Area
     bool PerformFunctionWrite();
     // Subfunctions Write Data
     byte WriteArea(PReqFunWriteDataItem ReqItemData, PReqFunWriteItem ReqItemPar,
-         TEv &EV);
+         TEv &EV, PSrvRWItem Item = NULL);
     byte WA_NotFound(TEv &EV);
     byte WA_InvalidTransportSize(TEv &EV);
     byte WA_OutOfRange(TEv &EV);
@@ -167,6 +204,11 @@ protected:
     // Second stage parse : PDU User data
     bool PerformGroupProgrammer();
     bool PerformGroupCyclicData();
+    // Subfunctions Cyclic data
+    void CyclicSubscribe();
+    void CyclicUnsubscribe();
+    int CyclicAnswer(PCyclicJob CJ, TS7Answer17 &Answer, byte Tg, word Sequence);
+    bool CyclicPush(PCyclicJob CJ);
     bool PerformGroupSecurity();
     // Group Block(s) Info
     bool PerformGroupBlockInfo();
@@ -194,6 +236,8 @@ public:
     int FPDULength;
     TS7Worker();
     ~TS7Worker(){};
+    // Pushes the cyclic data due
+    bool ExecuteTimer(int &Next);
 };
 
 typedef TS7Worker *PS7Worker;
@@ -203,27 +247,96 @@ typedef TS7Worker *PS7Worker;
 extern "C"
 {
 	typedef int (S7API *pfn_RWAreaCallBack)(void *usrPtr, int Sender, int Operation, PS7Tag PTag, void *pUsrData);
+	typedef int (S7API *pfn_RWAreaBatchCallBack)(void *usrPtr, int Sender, int Operation, PSrvRWItem Items, int ItemsCount);
+	typedef void (S7API *pfn_SrvChangesCallBack)(void *usrPtr);
 }
 const int OperationRead  = 0;
 const int OperationWrite = 1;
 
+//------------------------------------------------------------------------------
+// RESOURCELESS READ CACHE
+//------------------------------------------------------------------------------
+// Direct mapped, a new tag replaces the one in its slot
+const int RWCacheSlots = 256;
+
+typedef struct{
+	TS7Tag   Tag;
+	longword Time;     // Tick of the store
+	int      Gen;      // Cache generation of the store
+	int      Size;     // Data size, 0 : empty slot
+	int      Capacity;
+	pbyte    Data;
+}TRWCacheEntry, *PRWCacheEntry;
+
+class TRWCache
+{
+private:
+	TRWCacheEntry Entries[RWCacheSlots];
+	PSnapCriticalSection cs;
+	int Gen;  // Clear() makes all the entries stale
+	int Seq;  // Invalidations, a read older than the last one is not stored
+	PRWCacheEntry EntryOf(PS7Tag Tag);
+	bool Overlaps(PRWCacheEntry Entry, PS7Tag Tag);
+public:
+	longword TTL; // ms, 0 : disabled
+	TRWCache();
+	~TRWCache();
+	// Copies the data of Tag if cached and not expired
+	bool Get(PS7Tag Tag, void *pData);
+	// To be taken before reading, then passed to Put
+	int Sequence();
+	void Put(PS7Tag Tag, void *pData, int Sequence);
+	// Drops the entries overlapping Tag (written)
+	void Invalidate(PS7Tag Tag);
+	// Drops the entries of an area (S7AreaXX, 0 : all)
+	void Clear(int Area, int DBNumber);
+};
+typedef TRWCache *PRWCache;
+
 class TSnap7Server : public TCustomMsgServer
 {
 private:
     // Read Callback related
     pfn_SrvCallBack OnReadEvent;
 	pfn_RWAreaCallBack OnRWArea;
-	// Critical section to lock Read/Write Hook Area
+	pfn_RWAreaBatchCallBack OnRWAreaBatch;
+	// Changes callback
+	pfn_SrvChangesCallBack OnChanges;
+	// Critical section to lock Read/Write Hook Area (unless RWAreaConcurrent)
 	PSnapCriticalSection CSRWHook;
+	bool RWAreaConcurrent;
+	// Resourceless read cache (p_i32_RWCacheTTL)
+	TRWCache RWCache;
+	// Event filters, written rarely and read by every worker
+	PSnapRWLock RWEventFilters;
+	TSrvEventFilter EventFilters[MaxEventFilters];
+	volatile int EventFiltersCount;
+	// Event aggregation (p_i32_EventsAggregate)
+	PSnapCriticalSection CSEventStats;
+	TSrvEventStat EventStats[MaxEventStats];
+	int EventStatsCount;
+	bool EventsAggregate;
+	bool EventPasses(int Sender, longword Code, word Param1, word Param2);
+	bool CountEvent(int Sender, longword Code, word Param1, word Param2, word Param4);
 	void *FReadUsrPtr;
 	void *FRWAreaUsrPtr;
+	void *FRWAreaBatchUsrPtr;
+	void *FChangesUsrPtr;
 	void DisposeAll();
+    PS7Area *DBMap[DBMapPages];
     int FindFirstFreeDB();
     int IndexOfDB(word DBNumber);
+    int SetMaxDB(int Value);
+    void MapDB(word Number, PS7Area TheArea);
+    PS7Area CreateArea(word Number, void *pUsrData, word Size);
+    void DeleteArea(PS7Area TheArea);
+    PS7Area FindArea(int AreaCode, word Index);
+    int CollectChanges(int AreaCode, PS7Area TheArea, PSrvChange pChanges, int Count);
 protected:
     int DBCount;
     int DBLimit;
-    PS7Area DB[MaxDB]; // DB
+    int DBSlots;       // DB table size (MaxDB)
+    PS7Area *DB;       // DB table
     PS7Area HA[5];     // MK,PE,PA,TM,CT
     PS7Area FindDB(word DBNumber);
     PWorkerSocket CreateWorkerSocket(socket_t Sock);
@@ -233,11 +346,23 @@ protected:
     int RegisterSys(int AreaCode, void *pUsrData, word Size);
     int UnregisterDB(word DBNumber);
     int UnregisterSys(int AreaCode);
+    // Filters/aggregates the event before queuing it
+    void DoEvent(int Sender, longword Code, word RetCode, word Param1,
+      word Param2, word Param3, word Param4);
     // The Read event
     void DoReadEvent(int Sender, longword Code, word RetCode, word Param1,
       word Param2, word Param3, word Param4);
 	bool DoReadArea(int Sender, int Area, int DBNumber, int Start, int Size, int WordLen, void *pUsrData);
 	bool DoWriteArea(int Sender, int Area, int DBNumber, int Start, int Size, int WordLen, void *pUsrData);
+	bool DoRWAreaBatch(int Sender, int Operation, PSrvRWItem Items, int ItemsCount);
+	// Area access
+	pbyte EnterAreaRead(PS7Area TheArea, int &Slot);
+	void LeaveAreaRead(PS7Area TheArea, int Slot);
+	pbyte EnterAreaWrite(PS7Area TheArea);
+	void LeaveAreaWrite(PS7Area TheArea);
+	// Change tracking (MarkDirty needs the area cs)
+	bool MarkDirty(PS7Area TheArea, int Start, int Size);
+	void DoChanges();
 public:
     int WorkInterval;
     byte CpuStatus;
@@ -250,9 +375,21 @@ public:
     int UnregisterArea(int AreaCode, word Index);
     int LockArea(int AreaCode, word DBNumber);
     int UnlockArea(int AreaCode, word DBNumber);
+    int GetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData);
+    int SetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData);
+    int PublishArea(int AreaCode, word Index, void *pNewData, void **pOldData);
+    // Change tracking
+    int GetChanges(PSrvChange pChanges, int &Count);
+    int SetChangesCallBack(pfn_SrvChangesCallBack PCallBack, void *UsrPtr);
     // Sets Event callback
     int SetReadEventsCallBack(pfn_SrvCallBack PCallBack, void *UsrPtr);
 	int SetRWAreaCallBack(pfn_RWAreaCallBack PCallBack, void *UsrPtr);
+	int SetRWAreaBatchCallBack(pfn_RWAreaBatchCallBack PCallBack, void *UsrPtr);
+	// Drops the cached reads of an area (srvAreaXX, -1 : all)
+	int InvalidateCache(int AreaCode, word DBNumber);
+	// Event filters (Count = 0 : none) and aggregation counters
+	int SetEventFilters(PSrvEventFilter pFilters, int Count);
+	int GetEventStats(PSrvEventStat pStats, int &Count);
     friend class TS7Worker;
 };
 typedef TSnap7Server *PSnap7Server;
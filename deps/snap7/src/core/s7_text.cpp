@@ -475,7 +475,7 @@ char* PDUText(TSrvEvent &Event, char* Result)
 			switch (Event.EvtParam1)
 			{
 				case grCyclicData:
-					strcpy(S, "Function group cyclic data not yet implemented");
+					strcpy(S, "Function group cyclic data : subfunction not implemented");
 					break;
 				case grProgrammer:
 					strcpy(S, "Function group programmer not yet implemented");
@@ -720,6 +720,32 @@ char* SecurityText(TSrvEvent &Event, char* Result)
 	return Result;
 }
 //---------------------------------------------------------------------------
+char* CyclicText(TSrvEvent &Event, char* Result)
+{
+	char S[128];
+	char N[64];
+	if (Event.EvtParam1==evsCyclicSubscribe)
+	{
+		strcpy(S, "Cyclic data subscription, ");
+		strcat(S, IntToString(Event.EvtParam3, N));
+		strcat(S, " items every ");
+		strcat(S, IntToString(Event.EvtParam4*100, N));
+		strcat(S, " ms");
+	}
+	else
+		strcpy(S, "Cyclic data unsubscription");
+	if (Event.EvtRetCode == evrNoError)
+	{
+		strcat(S, ", Job ");
+		strcat(S, IntToString(Event.EvtParam2, N));
+		strcat(S, " --> OK");
+	}
+	else
+		strcat(S, " --> REFUSED");
+	strcpy(Result, S);
+	return Result;
+}
+//---------------------------------------------------------------------------
 char* EvtSrvText(TSrvEvent &Event, char* Result, int TextLen)
 {
 	char S[256];
@@ -772,6 +798,9 @@ char* EvtSrvText(TSrvEvent &Event, char* Result, int TextLen)
 			case evcSecurity: 
 				strcat(S, SecurityText(Event,C));
 				break;
+			case evcCyclicData: 
+				strcat(S, CyclicText(Event,C));
+				break;
 			default:
 				strcat(S, "Unknown event (");
 				strcat(S, IntToString(Event.EvtCode, C));
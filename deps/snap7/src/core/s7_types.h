@@ -103,7 +103,7 @@ const longword evcDownload            = 0x00800000;
 const longword evcDirectory           = 0x01000000;
 const longword evcSecurity            = 0x02000000;
 const longword evcControl             = 0x04000000;
-const longword evcReserved_08000000   = 0x08000000;
+const longword evcCyclicData          = 0x08000000;
 const longword evcReserved_10000000   = 0x10000000;
 const longword evcReserved_20000000   = 0x20000000;
 const longword evcReserved_40000000   = 0x40000000;
@@ -120,6 +120,8 @@ const word evsGetClock                = 0x0001;
 const word evsSetClock                = 0x0002;
 const word evsSetPassword             = 0x0001;
 const word evsClrPassword             = 0x0002;
+const word evsCyclicSubscribe         = 0x0001;
+const word evsCyclicUnsubscribe       = 0x0002;
 // Event Result
 const word evrNoError                 = 0;
 const word evrFragmentRejected        = 0x0001;
@@ -139,6 +141,7 @@ const word evrCannotUpload            = 0x000E;
 const word evrCannotDownload          = 0x000F;
 const word evrUploadInvalidID         = 0x0010;
 const word evrResNotFound             = 0x0011;
+const word evrInvalidCyclicJob        = 0x0012;
 
   // Async mode
 const int amPolling   = 0;
@@ -170,6 +173,15 @@ const int p_i32_BSendTimeout    = 12;
 const int p_i32_BRecvTimeout    = 13;
 const int p_u32_RecoveryTime    = 14;
 const int p_u32_KeepAliveTime   = 15;
+const int p_i32_ReactorThreads  = 16;
+const int p_i32_AmQRequest      = 17;
+const int p_i32_SocketHandle    = 18; // read only
+const int p_i32_MaxDB           = 19;
+const int p_i32_RWAreaConcurrent= 20; // 1 : RWArea callback not serialized
+const int p_i32_RWCacheTTL      = 21; // ms, 0 : resourceless read cache off
+const int p_i32_EventsDropped   = 22; // read only
+const int p_i32_EventsAggregate = 23; // 1 : data events counted (GetEventStats)
+const int p_i32_EventsConcurrent= 24; // 1 : event callbacks not serialized
 
 // Bool param is passed as int32_t : 0->false, 1->true
 // String param (only set) is passed as pointer
@@ -276,6 +288,41 @@ typedef struct{
 	int WordLen;
 }TS7Tag, *PS7Tag;
 
+// Changed range of a server area
+typedef struct{
+	int Area;     // srvAreaXX
+	int Index;    // DB number (only for DB)
+	int Start;
+	int Size;
+}TSrvChange, *PSrvChange;
+
+// Item of a batched Read/Write callback, one for each item of the PDU
+typedef struct{
+	TS7Tag Tag;
+	void  *pData;  // Read : data to fill, Write : data sent by the client
+	int    Result; // Set by the callback, 0 : Ok, otherwise the item is refused
+}TSrvRWItem, *PSrvRWItem;
+
+// Server event filter, once set an event must match one of them to pass
+typedef struct{
+	longword Code;    // evcXXX mask
+	int      Area;    // srvAreaXX, -1 : any (only for data events)
+	word     DBFrom;  // DB range (only for srvAreaDB)
+	word     DBTo;
+	longword Sender;  // IPv4 address, 0 : any
+}TSrvEventFilter, *PSrvEventFilter;
+
+// Data events of a client on an area (p_i32_EventsAggregate)
+typedef struct{
+	longword Sender;
+	int      Area;       // srvAreaXX
+	int      Index;      // DB number (only for DB)
+	longword Reads;
+	longword Writes;
+	longword ReadBytes;
+	longword WriteBytes;
+}TSrvEventStat, *PSrvEventStat;
+
 // Incoming header, it will be mapped onto IsoPDU payload
 typedef struct {
 	byte    P;        // Telegram ID, always 32
@@ -784,6 +831,61 @@ const byte   grBSend       = 0x46;
 const byte   grClock       = 0x47;
 const byte   grSecurity    = 0x45;
 
+//==============================================================================
+//                            GROUP CYCLIC DATA
+//==============================================================================
+// The client subscribes a set of read items with an interval, the answer
+// carries the job ID (into Seq) and the first data, then the server pushes
+// the data of the job every interval until it's unsubscribed or the
+// connection is closed.
+const byte   grCyclicRes   = 0x82; // Type response, group cyclic data
+const byte   grCyclicPush  = 0x02; // Type push, group cyclic data
+
+const byte SFun_CyclicMem   = 0x01;   // Cyclic transfer of memory areas
+const byte SFun_CyclicUnsub = 0x04;   // Unsubscribe a cyclic job
+
+const int  MaxCyclicJobs    = 8;      // Cyclic jobs per connection
+
+// Interval time base
+const byte CyclicBase100ms  = 0x00;
+const byte CyclicBase1s     = 0x01;
+const byte CyclicBase10s    = 0x02;
+
+typedef TReqFunTypedParams TReqFunCyclic;
+typedef TReqFunCyclic* PReqFunCyclic;
+
+typedef struct {
+	byte    RetVal;     // 0xFF for request
+	byte    TSize;      // 0x09 Transport size (octet)
+	word    Length;     // Data length from here
+	word    ItemsCount;
+	byte    TimeBase;   // see CyclicBaseXXX
+	byte    TimeFactor; // Interval = TimeBase * TimeFactor
+	TReqFunReadItem Items[MaxVars];
+}TReqDataCyclic;
+
+typedef TReqDataCyclic* PReqDataCyclic;
+
+typedef struct {
+	byte    RetVal;     // 0xFF for request
+	byte    TSize;      // 0x09 Transport size (octet)
+	word    Length;     // 2
+	byte    Function;   // 0x01
+	byte    JobID;
+}TReqDataCyclicUnsub;
+
+typedef TReqDataCyclicUnsub* PReqDataCyclicUnsub;
+
+// Answer and pushes : the items follow in the same format of a read answer
+typedef struct {
+	byte    RetVal;     // 0xFF
+	byte    TSize;      // 0x09 Transport size (octet)
+	word    Length;     // Data length from here
+	word    ItemsCount;
+}TResDataCyclic;
+
+typedef TResDataCyclic* PResDataCyclic;
+
 //==============================================================================
 //                             GROUP SECURITY
 //==============================================================================
@@ -184,6 +184,38 @@ int S7API Cli_WriteMultiVars(S7Object Client, PS7DataItem Item, int ItemsCount)
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Cli_ReadTagList(S7Object Client, PS7DataItem Item, int ItemsCount)
+{
+    if (Client)
+        return PSnap7Client(Client)->ReadTagList(Item, ItemsCount);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_SubscribeCyclic(S7Object Client, PS7DataItem Item, int ItemsCount, int Interval, int *JobID)
+{
+    if (Client)
+        return PSnap7Client(Client)->SubscribeCyclic(Item, ItemsCount, Interval, *JobID);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_UnsubscribeCyclic(S7Object Client, int JobID)
+{
+    if (Client)
+        return PSnap7Client(Client)->UnsubscribeCyclic(JobID);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Cli_CheckCyclic(S7Object Client, int *JobID, int Timeout)
+{
+    if (Client)
+        return PSnap7Client(Client)->CheckCyclic(*JobID, Timeout);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Cli_DBRead(S7Object Client, int DBNumber, int Start, int Size, void *pUsrData)
 {
     if (Client)
@@ -866,6 +898,38 @@ int S7API Srv_UnlockArea(S7Object Server, int AreaCode, word Index)
         return errLibInvalidObject;
 }
 //---------------------------------------------------------------------------
+int S7API Srv_GetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    if (Server)
+        return PSnap7Server(Server)->GetAreaData(AreaCode, Index, Start, Size, pUsrData);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_SetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    if (Server)
+        return PSnap7Server(Server)->SetAreaData(AreaCode, Index, Start, Size, pUsrData);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_PublishArea(S7Object Server, int AreaCode, word Index, void *pNewData, void **pOldData)
+{
+    if (Server)
+        return PSnap7Server(Server)->PublishArea(AreaCode, Index, pNewData, pOldData);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_GetChanges(S7Object Server, TSrvChange *pChanges, int &Count)
+{
+    if (Server)
+        return PSnap7Server(Server)->GetChanges(pChanges, Count);
+    else
+        return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
 int S7API Srv_GetStatus(S7Object Server, int &ServerStatus, int &CpuStatus, int &ClientsCount)
 {
     if (Server)
@@ -999,6 +1063,46 @@ int S7API Srv_SetRWAreaCallback(S7Object Server, pfn_RWAreaCallBack pCallback, v
 	else
 		return errLibInvalidObject;
 }
+//---------------------------------------------------------------------------
+int S7API Srv_SetRWAreaBatchCallback(S7Object Server, pfn_RWAreaBatchCallBack pCallback, void *usrPtr)
+{
+	if (Server)
+		return PSnap7Server(Server)->SetRWAreaBatchCallBack(pCallback, usrPtr);
+	else
+		return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_InvalidateCache(S7Object Server, int AreaCode, word DBNumber)
+{
+	if (Server)
+		return PSnap7Server(Server)->InvalidateCache(AreaCode, DBNumber);
+	else
+		return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_SetChangesCallback(S7Object Server, pfn_SrvChangesCallBack pCallback, void *usrPtr)
+{
+	if (Server)
+		return PSnap7Server(Server)->SetChangesCallBack(pCallback, usrPtr);
+	else
+		return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_SetEventFilters(S7Object Server, TSrvEventFilter *pFilters, int Count)
+{
+	if (Server)
+		return PSnap7Server(Server)->SetEventFilters(pFilters, Count);
+	else
+		return errLibInvalidObject;
+}
+//---------------------------------------------------------------------------
+int S7API Srv_GetEventStats(S7Object Server, TSrvEventStat *pStats, int &Count)
+{
+	if (Server)
+		return PSnap7Server(Server)->GetEventStats(pStats, Count);
+	else
+		return errLibInvalidObject;
+}
 //***************************************************************************
 // PARTNER
 //***************************************************************************
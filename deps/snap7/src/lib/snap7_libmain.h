@@ -55,6 +55,11 @@ EXPORTSPEC int S7API Cli_ReadArea(S7Object Client, int Area, int DBNumber, int S
 EXPORTSPEC int S7API Cli_WriteArea(S7Object Client, int Area, int DBNumber, int Start, int Amount, int WordLen, void *pUsrData);
 EXPORTSPEC int S7API Cli_ReadMultiVars(S7Object Client, PS7DataItem Item, int ItemsCount);
 EXPORTSPEC int S7API Cli_WriteMultiVars(S7Object Client, PS7DataItem Item, int ItemsCount);
+EXPORTSPEC int S7API Cli_ReadTagList(S7Object Client, PS7DataItem Item, int ItemsCount);
+// Cyclic data
+EXPORTSPEC int S7API Cli_SubscribeCyclic(S7Object Client, PS7DataItem Item, int ItemsCount, int Interval, int *JobID);
+EXPORTSPEC int S7API Cli_UnsubscribeCyclic(S7Object Client, int JobID);
+EXPORTSPEC int S7API Cli_CheckCyclic(S7Object Client, int *JobID, int Timeout);
 // Data I/O Lean functions
 EXPORTSPEC int S7API Cli_DBRead(S7Object Client, int DBNumber, int Start, int Size, void *pUsrData);
 EXPORTSPEC int S7API Cli_DBWrite(S7Object Client, int DBNumber, int Start, int Size, void *pUsrData);
@@ -153,6 +158,10 @@ EXPORTSPEC int S7API Srv_RegisterArea(S7Object Server, int AreaCode, word Index,
 EXPORTSPEC int S7API Srv_UnregisterArea(S7Object Server, int AreaCode, word Index);
 EXPORTSPEC int S7API Srv_LockArea(S7Object Server, int AreaCode, word Index);
 EXPORTSPEC int S7API Srv_UnlockArea(S7Object Server, int AreaCode, word Index);
+EXPORTSPEC int S7API Srv_GetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData);
+EXPORTSPEC int S7API Srv_SetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData);
+EXPORTSPEC int S7API Srv_PublishArea(S7Object Server, int AreaCode, word Index, void *pNewData, void **pOldData);
+EXPORTSPEC int S7API Srv_GetChanges(S7Object Server, TSrvChange *pChanges, int &Count);
 // Events
 EXPORTSPEC int S7API Srv_ClearEvents(S7Object Server);
 EXPORTSPEC int S7API Srv_PickEvent(S7Object Server, TSrvEvent *pEvent, int &EvtReady);
@@ -162,6 +171,11 @@ EXPORTSPEC int S7API Srv_SetEventsCallback(S7Object Server, pfn_SrvCallBack pCal
 EXPORTSPEC int S7API Srv_SetReadEventsCallback(S7Object Server, pfn_SrvCallBack pCallback, void *usrPtr);
 EXPORTSPEC int S7API Srv_EventText(TSrvEvent &Event, char *Text, int TextLen);
 EXPORTSPEC int S7API Srv_SetRWAreaCallback(S7Object Server, pfn_RWAreaCallBack pCallback, void *usrPtr);
+EXPORTSPEC int S7API Srv_SetRWAreaBatchCallback(S7Object Server, pfn_RWAreaBatchCallBack pCallback, void *usrPtr);
+EXPORTSPEC int S7API Srv_InvalidateCache(S7Object Server, int AreaCode, word DBNumber);
+EXPORTSPEC int S7API Srv_SetChangesCallback(S7Object Server, pfn_SrvChangesCallBack pCallback, void *usrPtr);
+EXPORTSPEC int S7API Srv_SetEventFilters(S7Object Server, TSrvEventFilter *pFilters, int Count);
+EXPORTSPEC int S7API Srv_GetEventStats(S7Object Server, TSrvEventStat *pStats, int &Count);
 // Misc
 EXPORTSPEC int S7API Srv_GetStatus(S7Object Server, int &ServerStatus, int &CpuStatus, int &ClientsCount);
 EXPORTSPEC int S7API Srv_SetCpuStatus(S7Object Server, int CpuStatus);
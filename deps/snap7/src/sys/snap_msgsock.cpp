@@ -237,7 +237,7 @@ int TMsgSocket::WaitingData()
 //---------------------------------------------------------------------------
 int TMsgSocket::WaitForData(int Size, int Timeout)
 {
-    longword Elapsed;
+    longword Elapsed, Delta;
 
     // Check for connection active
     if (CanRead(0) && (WaitingData()==0))
@@ -248,15 +248,40 @@ int TMsgSocket::WaitForData(int Size, int Timeout)
     // Enter main loop
     if (LastTcpError==0)
     {
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+        // The socket becomes readable only when "Size" bytes are buffered
+        int LowAt = Size;
+        setsockopt(FSocket, SOL_SOCKET, SO_RCVLOWAT, (char*)&LowAt, sizeof(LowAt));
+#endif
         Elapsed =SysGetTick();
         while((WaitingData()<Size) && (LastTcpError==0))
         {
             // Checks timeout
-            if (DeltaTime(Elapsed)>=(longword)(Timeout))
+            Delta=DeltaTime(Elapsed);
+            if (Delta>=(longword)(Timeout))
                 LastTcpError =WSAETIMEDOUT;
             else
-                SysSleep(1);
+            {
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+                if (CanRead(Timeout-Delta) && (WaitingData()<Size))
+                    LastTcpError=WSAECONNRESET; // Readable before the low mark : peer closed
+#else
+                // Winsock ignores SO_RCVLOWAT : sleep into select() until
+                // something arrives, a partial packet is polled
+                if (WaitingData()==0)
+                {
+                    if (CanRead(Timeout-Delta) && (WaitingData()==0))
+                        LastTcpError=WSAECONNRESET;
+                }
+                else
+                    SysSleep(1);
+#endif
+            }
         }
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+        LowAt = 1;
+        setsockopt(FSocket, SOL_SOCKET, SO_RCVLOWAT, (char*)&LowAt, sizeof(LowAt));
+#endif
     }
     if(LastTcpError==WSAECONNRESET)
             Connected =false;
@@ -283,52 +308,73 @@ int TMsgSocket::SockCheck(int SockResult)
   return LastTcpError;
 }
 //---------------------------------------------------------------------------
-bool TMsgSocket::CanWrite(int Timeout)
+// Waits until the socket is readable (or writable) within Timeout ms
+// (-1 = no timeout, poll() only).
+// A signal doesn't abort the wait, it's resumed for the time left.
+// poll() is used where available since select() can't handle descriptors
+// >= FD_SETSIZE (a busy server reaches them), Winsock has no such limit.
+bool TMsgSocket::WaitSocket(bool Read, int Timeout)
 {
+    longword Elapsed, Delta;
+    int Left, x, Error;
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+    struct pollfd PollFd;
+#else
     timeval TimeV;
-    int64_t x;
     fd_set FDset;
+#endif
 
 	if(FSocket == INVALID_SOCKET)
 		return false;
 
-    TimeV.tv_usec = (Timeout % 1000) * 1000;
-    TimeV.tv_sec = Timeout / 1000;
+    Elapsed=SysGetTick();
+    Left=Timeout;
+    for (;;)
+    {
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+        PollFd.fd=FSocket;
+        PollFd.events=Read ? POLLIN : POLLOUT;
+        PollFd.revents=0;
+        x = poll(&PollFd, 1, Left);
+#else
+        TimeV.tv_usec = (Left % 1000) * 1000;
+        TimeV.tv_sec = Left / 1000;
 
-    FD_ZERO(&FDset);
-    FD_SET(FSocket, &FDset);
+        FD_ZERO(&FDset);
+        FD_SET(FSocket, &FDset);
 
-    x = select(FSocket + 1, NULL, &FDset, NULL, &TimeV); //<-Ignore this warning in 64bit Visual Studio
-    if (x==(int)SOCKET_ERROR) 
-    {
-        LastTcpError = GetLastSocketError();
-        x=0;
+        if (Read)
+            x = int(select(int(FSocket) + 1, &FDset, NULL, NULL, &TimeV));
+        else
+            x = int(select(int(FSocket) + 1, NULL, &FDset, NULL, &TimeV));
+#endif
+        if (x!=(int)SOCKET_ERROR)
+            return (x > 0);
+
+        Error=GetLastSocketError();
+        if (Error!=WSAEINTR)
+        {
+            LastTcpError = Error;
+            return false;
+        }
+        if (Timeout>=0)
+        {
+            Delta=DeltaTime(Elapsed);
+            if (Delta>=(longword)(Timeout))
+                return false;
+            Left=Timeout-int(Delta);
+        }
     }
-    return (x > 0);
+}
+//---------------------------------------------------------------------------
+bool TMsgSocket::CanWrite(int Timeout)
+{
+    return WaitSocket(false, Timeout);
 }
 //---------------------------------------------------------------------------
 bool TMsgSocket::CanRead(int Timeout)
 {
-    timeval TimeV;
-    int64_t x;
-    fd_set FDset;
-
-	if(FSocket == INVALID_SOCKET)
-		return false;
-
-	TimeV.tv_usec = (Timeout % 1000) * 1000;
-    TimeV.tv_sec = Timeout / 1000;
-
-    FD_ZERO(&FDset);
-    FD_SET(FSocket, &FDset);
-
-    x = select(FSocket + 1, &FDset, NULL, NULL, &TimeV); //<-Ignore this warning in 64bit Visual Studio
-    if (x==(int)SOCKET_ERROR)
-    {
-       LastTcpError = GetLastSocketError();
-       x=0;
-    }
-    return (x > 0);
+    return WaitSocket(true, Timeout);
 }
 //---------------------------------------------------------------------------
 #ifdef NON_BLOCKING_CONNECT
@@ -339,8 +385,6 @@ int TMsgSocket::SckConnect()
 {
 	int n, flags, err;
 	socklen_t len;
-	fd_set rset, wset;
-	struct timeval tval;
 
  	SetSin(RemoteSin, RemoteAddress, RemotePort);
 
@@ -356,44 +400,31 @@ int TMsgSocket::SckConnect()
 							LastTcpError = GetLastSocketError();
 						}
 						else {
-							// still connecting ... 
-							FD_ZERO(&rset);
-							FD_SET(FSocket, &rset);
-							wset = rset;
-							tval.tv_sec = PingTimeout / 1000;
-							tval.tv_usec = (PingTimeout % 1000) * 1000;
-
-							n = select(FSocket+1, &rset, &wset, NULL, 
-							           (PingTimeout ? &tval : NULL));
-							if (n == 0) {
-								// timeout
-								LastTcpError = WSAEHOSTUNREACH;
+							// still connecting ... (no timeout if PingTimeout is 0)
+							if (!WaitSocket(false, PingTimeout ? PingTimeout : -1)) {
+								if (LastTcpError == 0)
+									LastTcpError = WSAEHOSTUNREACH; // timeout
 							}
 							else {
-								if (FD_ISSET(FSocket, &rset) || FD_ISSET(FSocket, &wset)) {
-									err = 0;
-									len = sizeof(err);						
-									if (getsockopt(
-									      FSocket, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
-										if (err) {
-											 LastTcpError = err;
+								err = 0;
+								len = sizeof(err);
+								if (getsockopt(
+								      FSocket, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
+									if (err) {
+										 LastTcpError = err;
+									}
+									else {
+										if (fcntl(FSocket, F_SETFL, flags) != -1) {
+											GetLocal();
+											ClientHandle = LocalSin.sin_addr.s_addr;
 										}
 										else {
-											if (fcntl(FSocket, F_SETFL, flags) != -1) {
-												GetLocal();
-												ClientHandle = LocalSin.sin_addr.s_addr;
-											}
-											else {
-												LastTcpError = GetLastSocketError();
-											}
+											LastTcpError = GetLastSocketError();
 										}
 									}
-									else {
-										LastTcpError = GetLastSocketError();
-									}
 								}
 								else {
-									LastTcpError = -1;
+									LastTcpError = GetLastSocketError();
 								}
 							}
 						} // still connecting
@@ -548,6 +579,91 @@ int TMsgSocket::SendPacket(void *Data, int Size)
     return Result;
 }
 //---------------------------------------------------------------------------
+int TMsgSocket::SendPacketV(PMsgVector Vector, int Count)
+{
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+    struct iovec Iov[MaxMsgVectors];
+    struct msghdr Msg;
+    int BytesSent, Error, First, Last, c;
+
+    // Same as SendPacket, but a single sendmsg() gathers all the buffers,
+    // a partial send (socket buffer full) is resumed where it stopped
+    LastTcpError=0;
+    Last=0;
+    for (c = 0; c < Count; c++)
+    {
+        if (Vector[c].Size>0)
+        {
+            Iov[Last].iov_base=Vector[c].Data;
+            Iov[Last].iov_len =Vector[c].Size;
+            Last++;
+        }
+    }
+    First=0;
+    while ((First<Last) && (LastTcpError==0))
+    {
+        if (SendTimeout>0)
+        {
+            if (!CanWrite(SendTimeout))
+            {
+                LastTcpError = WSAETIMEDOUT;
+                return LastTcpError;
+            }
+        }
+        memset(&Msg, 0, sizeof(Msg));
+        Msg.msg_iov   =&Iov[First];
+        Msg.msg_iovlen=Last-First;
+        BytesSent=sendmsg(FSocket, &Msg, MSG_NOSIGNAL);
+        if (BytesSent>=0)
+        {
+            // Skips the buffers sent and adjusts the partial one
+            while ((First<Last) && (BytesSent>=int(Iov[First].iov_len)))
+                BytesSent-=int(Iov[First++].iov_len);
+            if (First<Last)
+            {
+                Iov[First].iov_base=(char*)Iov[First].iov_base+BytesSent;
+                Iov[First].iov_len-=BytesSent;
+            }
+        }
+        else
+        {
+            Error=GetLastSocketError();
+            if ((Error!=WSAEINTR) && (Error!=WSAEWOULDBLOCK))
+                LastTcpError = Error;
+        }
+    }
+    return LastTcpError;
+#else
+    WSABUF Buf[MaxMsgVectors];
+    DWORD BytesSent;
+    int Last, c;
+
+    LastTcpError=0;
+    Last=0;
+    for (c = 0; c < Count; c++)
+    {
+        if (Vector[c].Size>0)
+        {
+            Buf[Last].buf=(char*)Vector[c].Data;
+            Buf[Last].len=Vector[c].Size;
+            Last++;
+        }
+    }
+    if (SendTimeout>0)
+    {
+        if (!CanWrite(SendTimeout))
+        {
+            LastTcpError = WSAETIMEDOUT;
+            return LastTcpError;
+        }
+    }
+    // On a blocking socket WSASend returns when all the buffers are sent
+    if (WSASend(FSocket, Buf, Last, &BytesSent, 0, NULL, NULL)!=0)
+        SockCheck(SOCKET_ERROR);
+    return LastTcpError;
+#endif
+}
+//---------------------------------------------------------------------------
 bool TMsgSocket::PacketReady(int Size)
 {
 	return (WaitingData()>=Size);
@@ -579,25 +695,122 @@ int TMsgSocket::Receive(void *Data, int BufSize, int &SizeRecvd)
 //---------------------------------------------------------------------------
 int TMsgSocket::RecvPacket(void *Data, int Size)
 {
-    int BytesRead;
-    WaitForData(Size, RecvTimeout);
-    if (LastTcpError==0)
+    int BytesRead, Error;
+    int Received = 0;
+    longword Elapsed, Delta;
+
+    // Blocks into select() and extracts the data as soon as they arrive,
+    // the whole packet must be received within RecvTimeout
+    LastTcpError=0;
+    Elapsed=SysGetTick();
+    while ((Received<Size) && (LastTcpError==0))
     {
-        BytesRead=recv(FSocket, (char*)Data, Size, MSG_NOSIGNAL);
-        if (BytesRead==0)
-            LastTcpError = WSAECONNRESET;  // Connection reset by Peer
+        Delta=DeltaTime(Elapsed);
+        if (Delta>(longword)(RecvTimeout))
+            LastTcpError = WSAETIMEDOUT;
         else
-            if (BytesRead<0)
-                LastTcpError = GetLastSocketError();
+            if (CanRead(RecvTimeout-Delta))
+            {
+                BytesRead=recv(FSocket, (char*)Data+Received, Size-Received, MSG_NOSIGNAL);
+                if (BytesRead>0)
+                    Received+=BytesRead;
+                else
+                    if (BytesRead==0)
+                        LastTcpError = WSAECONNRESET;  // Connection reset by Peer
+                    else
+                    {
+                        Error=GetLastSocketError();
+                        if ((Error!=WSAEINTR) && (Error!=WSAEWOULDBLOCK))
+                            LastTcpError = Error;
+                    }
+            }
+            else
+                if (LastTcpError==0)
+                    LastTcpError = WSAETIMEDOUT;
     }
-    else // After the timeout the bytes waiting were less then we expected
-        if (LastTcpError==WSAETIMEDOUT)
-            Purge();
+
+    // After the timeout the bytes received were less then we expected
+    if (LastTcpError==WSAETIMEDOUT)
+        Purge();
+
+    if (LastTcpError==WSAECONNRESET)
+        Connected =false;
+
+    return LastTcpError;
+}
+//---------------------------------------------------------------------------
+int TMsgSocket::RecvPacketV(PMsgVector Vector, int Count)
+{
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+    struct iovec Iov[MaxMsgVectors];
+    int BytesRead, Error, First, Last, c;
+    longword Elapsed, Delta;
+
+    // Same as RecvPacket, but a single readv() fills all the buffers
+    LastTcpError=0;
+    Last=0;
+    for (c = 0; c < Count; c++)
+    {
+        if (Vector[c].Size>0)
+        {
+            Iov[Last].iov_base=Vector[c].Data;
+            Iov[Last].iov_len =Vector[c].Size;
+            Last++;
+        }
+    }
+    First=0;
+    Elapsed=SysGetTick();
+    while ((First<Last) && (LastTcpError==0))
+    {
+        Delta=DeltaTime(Elapsed);
+        if (Delta>(longword)(RecvTimeout))
+            LastTcpError = WSAETIMEDOUT;
+        else
+            if (CanRead(RecvTimeout-Delta))
+            {
+                BytesRead=readv(FSocket, &Iov[First], Last-First);
+                if (BytesRead>0)
+                {
+                    // Skips the buffers filled and adjusts the partial one
+                    while ((First<Last) && (BytesRead>=int(Iov[First].iov_len)))
+                        BytesRead-=int(Iov[First++].iov_len);
+                    if (First<Last)
+                    {
+                        Iov[First].iov_base=(char*)Iov[First].iov_base+BytesRead;
+                        Iov[First].iov_len-=BytesRead;
+                    }
+                }
+                else
+                    if (BytesRead==0)
+                        LastTcpError = WSAECONNRESET;  // Connection reset by Peer
+                    else
+                    {
+                        Error=GetLastSocketError();
+                        if ((Error!=WSAEINTR) && (Error!=WSAEWOULDBLOCK))
+                            LastTcpError = Error;
+                    }
+            }
+            else
+                if (LastTcpError==0)
+                    LastTcpError = WSAETIMEDOUT;
+    }
+
+    if (LastTcpError==WSAETIMEDOUT)
+        Purge();
 
     if (LastTcpError==WSAECONNRESET)
         Connected =false;
 
     return LastTcpError;
+#else
+    int c;
+    // Plain sequence of receives
+    LastTcpError=0;
+    for (c = 0; (c < Count) && (LastTcpError==0); c++)
+        if (Vector[c].Size>0)
+            RecvPacket(Vector[c].Data, Vector[c].Size);
+    return LastTcpError;
+#endif
 }
 //---------------------------------------------------------------------------
 int TMsgSocket::PeekPacket(void *Data, int Size)
@@ -623,10 +836,34 @@ int TMsgSocket::PeekPacket(void *Data, int Size)
     return LastTcpError;
 }
 //---------------------------------------------------------------------------
+int TMsgSocket::PeekQueued(void *Data, int Size)
+{
+    int BytesRead;
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+    BytesRead=recv(FSocket, (char*)Data, Size, MSG_PEEK | MSG_DONTWAIT | MSG_NOSIGNAL);
+#else
+    if (WaitingData()<Size)
+        return 0;
+    BytesRead=recv(FSocket, (char*)Data, Size, MSG_PEEK | MSG_NOSIGNAL);
+#endif
+    return BytesRead>0 ? BytesRead : 0;
+}
+//---------------------------------------------------------------------------
+int TMsgSocket::BytesMissing()
+{
+    return 0;
+}
+//---------------------------------------------------------------------------
 bool TMsgSocket::Execute()
 {
     return true;
 }
+//---------------------------------------------------------------------------
+bool TMsgSocket::ExecuteTimer(int &Next)
+{
+    Next=-1;
+    return true;
+}
 //==============================================================================
 // PING
 //==============================================================================
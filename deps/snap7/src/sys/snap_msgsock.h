@@ -43,6 +43,10 @@
 #ifdef NON_BLOCKING_CONNECT
     #include <fcntl.h>
 #endif
+#if defined(PLATFORM_UNIX) || defined(OS_OSX)
+    #include <sys/uio.h>
+    #include <poll.h>
+#endif
 //----------------------------------------------------------------------------
 /*
   In Windows sizeof socket varies depending of the platform :
@@ -69,6 +73,13 @@ typedef int socket_t;
 #define  SD_SEND         0x01
 #define  SD_BOTH         0x02
 #define  MaxPacketSize   65536
+#define  MaxMsgVectors   64
+
+// Buffer descriptor for scattered packets
+typedef struct {
+    void *Data;
+    int  Size;
+} TMsgVector, *PMsgVector;
 
 //----------------------------------------------------------------------------
 // For other platform we need to re-define next constants
@@ -241,6 +252,7 @@ private:
         void DestroySocket();
         void SetSocketOptions();
         bool CanWrite(int Timeout);
+        bool WaitSocket(bool Read, int Timeout);
         void GetLocal();
         void GetRemote();
         void SetSin(sockaddr_in &sin, char *Address, u_short Port);
@@ -254,8 +266,6 @@ protected:
         void CreateSocket();
         // Called when a socket is assigned externally
         void GotSocket();
-        // Returns how many bytes are ready to be read in the winsock buffer
-        int WaitingData();
         // Waits until there at least "size" bytes ready to be read or until receive timeout occurs
         int WaitForData(int Size, int Timeout);
         // Clear socket input buffer
@@ -290,6 +300,8 @@ public:
         virtual ~TMsgSocket();
         // Returns true if "something" can be read during the Timeout interval..
         bool CanRead(int Timeout);
+        // Returns how many bytes are ready to be read in the winsock buffer
+        int WaitingData();
         // Connects to a peer (using RemoteAddress and RemotePort)
         int SckConnect(); // (client-side)
         // Disconnects from a peer (gracefully)
@@ -309,15 +321,27 @@ public:
         bool Ping(sockaddr_in Addr);
         // Sends a packet
         int SendPacket(void *Data,  int Size);
+        // Sends a packet gathered from several buffers (max MaxMsgVectors)
+        int SendPacketV(PMsgVector Vector, int Count);
         // Returns true if a Packet at least of "Size" bytes is ready to be read
         bool PacketReady(int Size);
         // Receives everything
         int Receive(void *Data, int BufSize, int & SizeRecvd);
         // Receives a packet of size specified.
         int RecvPacket(void *Data, int Size);
+        // Receives a packet scattered into several buffers (max MaxMsgVectors)
+        int RecvPacketV(PMsgVector Vector, int Count);
         // Peeks a packet of size specified without extract it from the socket queue
         int PeekPacket(void *Data, int Size);
+        // Peeks up to Size bytes already queued, without waiting, returns the bytes peeked
+        int PeekQueued(void *Data, int Size);
+        // Bytes that must still arrive before a whole message can be received
+        // without waiting (0 : a message is complete or we cannot know)
+        virtual int BytesMissing();
         virtual bool Execute();
+        // Timed activity of a server worker, it isn't driven by incoming data.
+        // Next receives the ms before the next call is needed (-1 : none)
+        virtual bool ExecuteTimer(int &Next);
 };
 
 typedef TMsgSocket *PMsgSocket;
@@ -31,68 +31,88 @@
 
 TMsgEventQueue::TMsgEventQueue(const int Capacity, const int BlockSize) 
 {
-    FCapacity = Capacity;
-    Max = FCapacity - 1;
+    // Rounded up to a power of 2, the slot is the ticket & Mask
+    FCapacity = 1;
+    while (FCapacity < Capacity)
+        FCapacity <<= 1;
+    Mask = FCapacity - 1;
     FBlockSize = BlockSize;
     Buffer = new byte[FCapacity * FBlockSize];
-    Flush();
+    Seq = new int[FCapacity];
+    for (int c = 0; c < FCapacity; c++)
+        Seq[c] = c;
+    IndexIn = 0;
+    IndexOut = 0;
+    FDropped = 0;
 }
 //---------------------------------------------------------------------------
 TMsgEventQueue::~TMsgEventQueue() 
 {
     delete[] Buffer;
+    delete[] Seq;
 }
 //---------------------------------------------------------------------------
 void TMsgEventQueue::Flush() 
 {
-    IndexIn = 0;
-    IndexOut = 0;
+    pbyte Dummy = new byte[FBlockSize];
+    while (Extract(Dummy));
+    delete[] Dummy;
 }
 //---------------------------------------------------------------------------
-void TMsgEventQueue::Insert(void *lpdata) 
+bool TMsgEventQueue::Insert(void *lpdata) 
 {
-    pbyte PBlock;
-    if (!Full())
+    int Ticket, Slot, Dif;
+
+    Ticket = SnapAtomicAdd(&IndexIn, 0);
+    for (;;)
     {
-        // Calc offset
-        if (IndexIn < Max) IndexIn++;
-        else IndexIn = 0;
-        PBlock = Buffer + uintptr_t(IndexIn * FBlockSize);
-        memcpy(PBlock, lpdata, FBlockSize);
-    };
+        Slot = Ticket & Mask;
+        // (differences wrap around, so they are computed unsigned)
+        Dif = int(longword(SnapAtomicAdd(&Seq[Slot], 0)) - longword(Ticket));
+        if (Dif == 0)
+        {
+            // The slot is free, let's take the ticket
+            int Prev = SnapAtomicCompareExchange(&IndexIn, Ticket, int(longword(Ticket) + 1));
+            if (Prev == Ticket)
+                break;
+            Ticket = Prev;
+        }
+        else if (Dif < 0)
+        {
+            // The consumer has still to extract the previous round : full
+            SnapAtomicAdd(&FDropped, 1);
+            return false;
+        }
+        else
+            Ticket = SnapAtomicAdd(&IndexIn, 0);
+    }
+    memcpy(Buffer + uintptr_t(Slot * FBlockSize), lpdata, FBlockSize);
+    // Hands the slot to the consumer (Seq = Ticket + 1)
+    SnapAtomicAdd(&Seq[Slot], 1);
+    return true;
 }
 //---------------------------------------------------------------------------
 bool TMsgEventQueue::Extract(void *lpdata) 
 {
-    int IdxOut;
-    pbyte PBlock;
+    int Slot = IndexOut & Mask;
 
-    if (!Empty())
-    {
-        // stores IndexOut
-        IdxOut = IndexOut;
-        if (IdxOut < Max) IdxOut++;
-        else IdxOut = 0;
-        PBlock = Buffer + uintptr_t(IdxOut * FBlockSize);
-        // moves data
-        memcpy(lpdata, PBlock, FBlockSize);
-        // Updates IndexOut
-        IndexOut = IdxOut;
-        return true;
-    }
-    else
+    if (Empty())
         return false;
+    memcpy(lpdata, Buffer + uintptr_t(Slot * FBlockSize), FBlockSize);
+    IndexOut = int(longword(IndexOut) + 1);
+    // Hands the slot to the producer of the next round (Seq = Ticket + Capacity)
+    SnapAtomicAdd(&Seq[Slot], FCapacity - 1);
+    return true;
 }
 //---------------------------------------------------------------------------
 bool TMsgEventQueue::Empty() 
 {
-    return (IndexIn == IndexOut);
+    return SnapAtomicAdd(&Seq[IndexOut & Mask], 0) != int(longword(IndexOut) + 1);
 }
 //---------------------------------------------------------------------------
-bool TMsgEventQueue::Full() 
+int TMsgEventQueue::Dropped() 
 {
-    int IdxOut = IndexOut; // To avoid troubles if IndexOut changes during next line
-    return ( (IdxOut == IndexIn + 1) || ((IndexIn == Max) && (IdxOut == 0)));
+    return SnapAtomicAdd(&FDropped, 0);
 }
 //---------------------------------------------------------------------------
 // WORKER THREAD
@@ -175,6 +195,203 @@ void TMsgListenerThread::Execute()
         };
     }
 }
+#ifdef EPOLL_REACTOR
+//---------------------------------------------------------------------------
+// REACTOR THREAD
+//---------------------------------------------------------------------------
+TMsgReactorThread::TMsgReactorThread(TCustomMsgServer *Server)
+{
+    FServer = Server;
+    FreeOnTerminate = false;
+    Count = 0;
+    for (int c = 0; c < MaxWorkers; c++)
+    {
+        Socks[c] = INVALID_SOCKET;
+        LowMarks[c] = 1;
+    }
+    TimerDue = 0;
+    TimerSet = false;
+    FEpoll = epoll_create(MaxWorkers);
+}
+//---------------------------------------------------------------------------
+TMsgReactorThread::~TMsgReactorThread()
+{
+    if (FEpoll != -1)
+        close(FEpoll);
+}
+//---------------------------------------------------------------------------
+bool TMsgReactorThread::Add(int Index, socket_t Sock)
+{
+    epoll_event Event;
+
+    if (FEpoll == -1)
+        return false;
+    memset(&Event, 0, sizeof (Event));
+    // Level triggered : pipelined PDUs are not lost. EPOLLRDHUP tells a peer
+    // that closed after a partial message, which stays readable forever
+    Event.events = EPOLLIN | EPOLLRDHUP;
+    // We need both the slot (to find the worker) and the socket (to remove it)
+    Event.data.u64 = (uint64_t(Sock) << 32) | uint32_t(Index);
+    Socks[Index] = Sock;
+    LowMarks[Index] = 1;
+    if (epoll_ctl(FEpoll, EPOLL_CTL_ADD, Sock, &Event) == 0)
+    {
+        Count++;
+        return true;
+    }
+    Socks[Index] = INVALID_SOCKET;
+    return false;
+}
+//---------------------------------------------------------------------------
+void TMsgReactorThread::CloseSession(int Index, socket_t Sock, bool Exception)
+{
+    PWorkerSocket WorkerSocket = FServer->Sessions[Index];
+    epoll_event Event; // kernels < 2.6.9 want a non-null pointer
+
+    epoll_ctl(FEpoll, EPOLL_CTL_DEL, Sock, &Event);
+    Socks[Index] = INVALID_SOCKET;
+    if (!FServer->Destroying)
+    {
+        if (Exception)
+        {
+            WorkerSocket->ForceClose();
+            FServer->DoEvent(WorkerSocket->ClientHandle, evcClientException, 0, 0, 0, 0, 0);
+        }
+        else
+            FServer->DoEvent(WorkerSocket->ClientHandle, evcClientDisconnected, 0, 0, 0, 0, 0);
+    }
+    delete WorkerSocket;
+    FServer->LockList();
+    FServer->Sessions[Index] = NULL;
+    FServer->ClientsCount--;
+    Count--;
+    FServer->UnlockList();
+}
+//---------------------------------------------------------------------------
+// A worker receives a message with blocking reads, a peer which sent only a
+// part of it would stall all the sessions of the reactor. In that case the
+// kernel keeps buffering it : the socket low mark is raised to the size
+// missing and, since epoll honours SO_RCVLOWAT, we are not waked up again
+// until the message is complete (or the peer closes, then the session is
+// closed since the message can't be completed anymore).
+//---------------------------------------------------------------------------
+bool TMsgReactorThread::MessageReady(int Index, socket_t Sock, PMsgSocket WorkerSocket)
+{
+    int Missing, LowAt;
+
+    Missing = WorkerSocket->BytesMissing();
+    LowAt = Missing > 0 ? WorkerSocket->WaitingData() + Missing : 1;
+    if (LowAt != LowMarks[Index])
+    {
+        setsockopt(Sock, SOL_SOCKET, SO_RCVLOWAT, (char*)&LowAt, sizeof (LowAt));
+        LowMarks[Index] = LowAt;
+    }
+    return Missing == 0;
+}
+//---------------------------------------------------------------------------
+void TMsgReactorThread::Schedule(int Next)
+{
+    longword Due;
+
+    if (Next < 0)
+        return;
+    Due = SysGetTick() + Next;
+    if (!TimerSet || (int(Due - TimerDue) < 0))
+    {
+        TimerDue = Due;
+        TimerSet = true;
+    }
+}
+//---------------------------------------------------------------------------
+void TMsgReactorThread::ExecuteTimers()
+{
+    PWorkerSocket WorkerSocket;
+    int Index, Next;
+    bool Exception, Alive;
+
+    TimerSet = false;
+    for (Index = 0; Index < MaxWorkers && !Terminated; Index++)
+    {
+        if (Socks[Index] == INVALID_SOCKET)
+            continue;
+        WorkerSocket = FServer->Sessions[Index];
+        if (WorkerSocket == NULL)
+            continue;
+        Exception = false;
+        try
+        {
+            Alive = WorkerSocket->ExecuteTimer(Next);
+        } catch (...)
+        {
+            Alive = false;
+            Exception = true;
+        }
+        if (Alive)
+            Schedule(Next);
+        else
+            CloseSession(Index, Socks[Index], Exception);
+    }
+}
+//---------------------------------------------------------------------------
+void TMsgReactorThread::Execute()
+{
+    epoll_event Events[64];
+    PWorkerSocket WorkerSocket;
+    int c, Ready, Index, Wait, Next;
+    socket_t Sock;
+    bool Exception, Alive, HangUp;
+
+    while (!Terminated && !FServer->Destroying)
+    {
+        // The timeout gives us the chance to check Terminated and to execute
+        // the timed activities
+        Wait = RcInterval;
+        if (TimerSet)
+        {
+            Next = int(TimerDue - SysGetTick());
+            if (Next < Wait)
+                Wait = Next > 0 ? Next : 0;
+        }
+        Ready = epoll_wait(FEpoll, Events, 64, Wait);
+        for (c = 0; c < Ready && !Terminated; c++)
+        {
+            Index = int(Events[c].data.u64 & 0xFFFFFFFF);
+            Sock = socket_t(Events[c].data.u64 >> 32);
+            WorkerSocket = FServer->Sessions[Index];
+            if (WorkerSocket == NULL)
+                continue;
+            HangUp = (Events[c].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+            if (!MessageReady(Index, Sock, WorkerSocket))
+            {
+                if (HangUp)
+                    CloseSession(Index, Sock, false);
+                continue;
+            }
+            Exception = false;
+            try
+            {
+                // The message is complete, so the worker won't wait into the socket
+                Alive = WorkerSocket->Execute();
+                // Its reads leave the low mark at 1
+                LowMarks[Index] = 1;
+                // The request could have changed its timed activities
+                if (Alive)
+                    Alive = WorkerSocket->ExecuteTimer(Next);
+            } catch (...)
+            {
+                Alive = false;
+                Exception = true;
+            }
+            if (Alive)
+                Schedule(Next);
+            else
+                CloseSession(Index, Sock, Exception);
+        }
+        if (TimerSet && (int(TimerDue - SysGetTick()) <= 0))
+            ExecuteTimers();
+    }
+}
+#endif
 //---------------------------------------------------------------------------
 // TCP SERVER
 //---------------------------------------------------------------------------
@@ -195,7 +412,14 @@ TCustomMsgServer::TCustomMsgServer()
     ClientsCount = 0;
     LocalBind = 0;
     MaxClients = MaxWorkers;
+    ReactorThreads = 0;
+    EventsConcurrent = false;
     OnEvent = NULL;
+#ifdef EPOLL_REACTOR
+    memset(Sessions, 0, sizeof (Sessions));
+    memset(Reactors, 0, sizeof (Reactors));
+    FReactorCount = 0;
+#endif
 }
 //---------------------------------------------------------------------------
 TCustomMsgServer::~TCustomMsgServer() 
@@ -223,7 +447,11 @@ int TCustomMsgServer::FirstFree()
     int i;
     for (i = 0; i < MaxWorkers; i++)
     {
+#ifdef EPOLL_REACTOR
+        if ((Workers[i] == 0) && (Sessions[i] == 0))
+#else
         if (Workers[i] == 0)
+#endif
             return i;
     }
     return -1;
@@ -244,6 +472,11 @@ int TCustomMsgServer::StartListener()
         LocalBind = SockListener->LocalBind;
         // Listen
         Result = SockListener->SckListen();
+#ifdef EPOLL_REACTOR
+        // The reactors must be ready before the first client arrives
+        if (Result == 0)
+            Result = StartReactors();
+#endif
         if (Result == 0)
         {
             // Creates the Listener thread
@@ -265,6 +498,13 @@ void TCustomMsgServer::TerminateAll()
     longword Elapsed;
     bool Timeout;
 
+#ifdef EPOLL_REACTOR
+    if (FReactorCount > 0)
+    {
+        TerminateReactors();
+        return;
+    }
+#endif
     if (ClientsCount > 0)
     {
         for (c = 0; c < MaxWorkers; c++)
@@ -287,6 +527,107 @@ void TCustomMsgServer::TerminateAll()
     }
 }
 //---------------------------------------------------------------------------
+#ifdef EPOLL_REACTOR
+int TCustomMsgServer::StartReactors()
+{
+    int c, Result;
+    FReactorCount = ReactorThreads;
+    if (FReactorCount > MaxReactors)
+        FReactorCount = MaxReactors;
+    for (c = 0; c < FReactorCount; c++)
+    {
+        Reactors[c] = new TMsgReactorThread(this);
+        if (!Reactors[c]->Valid())
+        {
+            Result = errno;
+            // Nobody is started yet : there is nothing to terminate or to join
+            for (; c >= 0; c--)
+            {
+                delete Reactors[c];
+                Reactors[c] = NULL;
+            }
+            FReactorCount = 0;
+            return Result;
+        }
+    }
+    for (c = 0; c < FReactorCount; c++)
+        Reactors[c]->Start();
+    return 0;
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::TerminateReactors()
+{
+    PWorkerSocket WorkerSocket;
+    int c, cnt = 0;
+
+    for (c = 0; c < FReactorCount; c++)
+        Reactors[c]->Terminate();
+    for (c = 0; c < FReactorCount; c++)
+    {
+        if (Reactors[c]->WaitFor(WkTimeout) != WAIT_OBJECT_0)
+        {
+            Reactors[c]->Kill(); // a worker is hanged
+            cnt++;
+        }
+        delete Reactors[c];
+        Reactors[c] = NULL;
+    }
+    FReactorCount = 0;
+    // Now nobody else touches the sessions
+    for (c = 0; c < MaxWorkers; c++)
+    {
+        WorkerSocket = Sessions[c];
+        if (WorkerSocket != NULL)
+        {
+            Sessions[c] = NULL;
+            if (!Destroying)
+                DoEvent(WorkerSocket->ClientHandle, evcClientTerminated, 0, 0, 0, 0, 0);
+            delete WorkerSocket;
+        }
+    }
+    ClientsCount = 0;
+    if (cnt > 0)
+        DoEvent(0, evcClientsDropped, 0, cnt, 0, 0, 0);
+}
+//---------------------------------------------------------------------------
+void TCustomMsgServer::IncomingReactor(socket_t Sock)
+{
+    int c, idx;
+    PMsgReactorThread Reactor;
+    PWorkerSocket WorkerSocket;
+
+    LockList();
+    idx = FirstFree();
+    if (idx >= 0)
+    {
+        // The less loaded reactor gets the new client
+        Reactor = Reactors[0];
+        for (c = 1; c < FReactorCount; c++)
+            if (Reactors[c]->Count < Reactor->Count)
+                Reactor = Reactors[c];
+
+        WorkerSocket = CreateWorkerSocket(Sock);
+        Sessions[idx] = WorkerSocket;
+        ClientsCount++;
+        if (Reactor->Add(idx, Sock))
+            DoEvent(WorkerSocket->ClientHandle, evcClientAdded, 0, 0, 0, 0, 0);
+        else
+        {
+            Sessions[idx] = NULL;
+            ClientsCount--;
+            DoEvent(WorkerSocket->ClientHandle, evcClientNoRoom, 0, 0, 0, 0, 0);
+            delete WorkerSocket;
+        }
+    }
+    else
+    {
+        DoEvent(Msg_GetSockAddr(Sock), evcClientNoRoom, 0, 0, 0, 0, 0);
+        Msg_CloseSocket(Sock);
+    }
+    UnlockList();
+}
+#endif
+//---------------------------------------------------------------------------
 void TCustomMsgServer::KillAll() 
 {
     int c, cnt = 0;
@@ -329,10 +670,10 @@ void TCustomMsgServer::DoEvent(int Sender, longword Code, word RetCode, word Par
     bool GoLog = (Code & LogMask) != 0;
     bool GoEvent = (Code & EventMask) != 0;
 
+    // The queue is lock free, the workers only wait each other for the
+    // callback, and not even there if EventsConcurrent
     if (!Destroying && (GoLog || GoEvent))
     {
-        CSEvent->Enter();
-
         time(&SrvEvent.EvtTime);
         SrvEvent.EvtSender = Sender;
         SrvEvent.EvtCode = Code;
@@ -342,18 +683,23 @@ void TCustomMsgServer::DoEvent(int Sender, longword Code, word RetCode, word Par
         SrvEvent.EvtParam3 = Param3;
         SrvEvent.EvtParam4 = Param4;
 
+        // Queued before the callback, which may be a wake up of the consumer
+        if (GoLog)
+            FEventQueue->Insert(&SrvEvent);
+
         if (GoEvent && (OnEvent != NULL))
+        {
+            if (!EventsConcurrent)
+                CSEvent->Enter();
             try
             { // callback is outside here, we have to shield it
                 OnEvent(FUsrPtr, &SrvEvent, sizeof (TSrvEvent));
             } catch (...)
             {
             };
-
-        if (GoLog)
-            FEventQueue->Insert(&SrvEvent);
-
-        CSEvent->Leave();
+            if (!EventsConcurrent)
+                CSEvent->Leave();
+        };
     };
 }
 //---------------------------------------------------------------------------
@@ -373,6 +719,13 @@ void TCustomMsgServer::Incoming(socket_t Sock)
 
     if (CanAccept(Sock))
     {
+#ifdef EPOLL_REACTOR
+        if (FReactorCount > 0)
+        {
+            IncomingReactor(Sock);
+            return;
+        }
+#endif
         LockList();
         // First position available in the thread buffer
         idx = FirstFree();
@@ -478,9 +831,12 @@ bool TCustomMsgServer::EventEmpty()
 //---------------------------------------------------------------------------
 void TCustomMsgServer::EventsFlush() 
 {
-    CSEvent->Enter();
     FEventQueue->Flush();
-    CSEvent->Leave();
+}
+//---------------------------------------------------------------------------
+int TCustomMsgServer::EventsDropped() 
+{
+    return FEventQueue->Dropped();
 }
 //---------------------------------------------------------------------------
 
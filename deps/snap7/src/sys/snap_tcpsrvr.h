@@ -29,9 +29,20 @@
 #include "snap_msgsock.h"
 #include "snap_threads.h"
 //---------------------------------------------------------------------------
+// Reactor mode : a few event-loop threads multiplex all the client sockets
+// instead of having a thread per connection (Linux only, it needs epoll)
+//---------------------------------------------------------------------------
+#if defined(PLATFORM_UNIX) && defined(__linux__)
+    #define EPOLL_REACTOR
+#endif
+#ifdef EPOLL_REACTOR
+    #include <sys/epoll.h>
+#endif
+//---------------------------------------------------------------------------
 
-#define MaxWorkers 1024
-#define MaxEvents  1500
+#define MaxWorkers  1024
+#define MaxEvents   1500
+#define MaxReactors 16
 
 const int SrvStopped = 0;
 const int SrvRunning = 1;
@@ -61,6 +72,7 @@ const longword errSrvCannotStart      = 0x00100000;
 
 const longword ThTimeout   = 2000; // Thread timeout
 const longword WkTimeout   = 3000; // Workers termination timeout
+const int      RcInterval  = 100;  // Reactor wait interval
 
 #pragma pack(1)
 
@@ -84,23 +96,31 @@ typedef void (S7API *pfn_SrvCallBack)(void * usrPtr, PSrvEvent PEvent, int Size)
 //---------------------------------------------------------------------------
 // EVENTS QUEUE
 //---------------------------------------------------------------------------
+// Bounded lock-free ring : many threads Insert() (the workers), only one
+// thread Extract()s, Empty()s and Flush()es (the consumer).
+// Every slot has a sequence number that tells whose turn it is : a producer
+// owns the slot when it equals its ticket, the consumer when it equals the
+// ticket + 1. When the ring is full the event is dropped and counted.
 class TMsgEventQueue
 {
 private:
-        int   IndexIn;   // <-- insert index
-        int   IndexOut;  // --> extract index
-        int   Max;       // Buffer upper bound [0..Max]
-        int   FCapacity; // Queue capacity
+        volatile int IndexIn;  // <-- next insert ticket (producers)
+        int   IndexOut;        // --> next extract ticket (consumer)
+        int   Mask;            // FCapacity - 1
+        int   FCapacity;       // Queue capacity (power of 2)
+        volatile int *Seq;     // Slot sequence numbers
         pbyte Buffer;
         int   FBlockSize;
+        volatile int FDropped;
 public:
         TMsgEventQueue(const int Capacity, const int BlockSize);
         ~TMsgEventQueue();
         void Flush();
-        void Insert(void *lpdata);
+        bool Insert(void *lpdata);
         bool Extract(void *lpdata);
         bool Empty();
-        bool Full();
+        // Events lost because the queue was full
+        int Dropped();
 };
 typedef TMsgEventQueue *PMsgEventQueue;
 
@@ -139,6 +159,36 @@ public:
 };
 typedef TMsgListenerThread *PMsgListenerThread;
 
+//---------------------------------------------------------------------------
+// REACTOR THREAD
+//---------------------------------------------------------------------------
+// It waits on an epoll set and executes the workers whose socket is readable.
+// The timed activities of its workers (see ExecuteTimer) are executed when due.
+#ifdef EPOLL_REACTOR
+class TMsgReactorThread : public TSnapThread
+{
+private:
+        TCustomMsgServer *FServer;
+        int FEpoll;
+        socket_t Socks[MaxWorkers]; // Sockets handled (INVALID_SOCKET : not ours)
+        int LowMarks[MaxWorkers];   // SO_RCVLOWAT raised to wait a partial message
+        longword TimerDue;          // Tick of the next timed activity
+        bool TimerSet;
+        void Schedule(int Next);
+        void ExecuteTimers();
+        void CloseSession(int Index, socket_t Sock, bool Exception);
+        bool MessageReady(int Index, socket_t Sock, PMsgSocket WorkerSocket);
+public:
+        int Count; // Sockets handled by this reactor
+        TMsgReactorThread(TCustomMsgServer *Server);
+        ~TMsgReactorThread();
+        bool Valid() { return FEpoll != -1; };
+        bool Add(int Index, socket_t Sock);
+        void Execute();
+};
+typedef TMsgReactorThread *PMsgReactorThread;
+#endif
+
 //---------------------------------------------------------------------------
 // TCP SERVER
 //---------------------------------------------------------------------------
@@ -165,12 +215,24 @@ private:
         void LockList();
         void UnlockList();
         int FirstFree();
+#ifdef EPOLL_REACTOR
+        // Reactor threads (only in reactor mode)
+        PMsgReactorThread Reactors[MaxReactors];
+        int FReactorCount;
+        int StartReactors();
+        void TerminateReactors();
+        void IncomingReactor(socket_t Sock);
+#endif
 protected:
         bool Destroying;
-        // Critical section to lock Event activities
+        // Critical section to serialize the event callbacks (unless EventsConcurrent)
         PSnapCriticalSection CSEvent;
 	    // Workers list
         void *Workers[MaxWorkers];
+#ifdef EPOLL_REACTOR
+        // Worker sockets driven by the reactors (only in reactor mode)
+        PWorkerSocket Sessions[MaxWorkers];
+#endif
         // Terminates all worker threads
         virtual void TerminateAll();
         // Kills all worker threads that are unresponsive
@@ -190,6 +252,9 @@ protected:
 public:
         friend class TMsgWorkerThread;
         friend class TMsgListenerThread;
+#ifdef EPOLL_REACTOR
+        friend class TMsgReactorThread;
+#endif
         word LocalPort;
         longword LocalBind;
         longword LogMask;
@@ -197,6 +262,10 @@ public:
         int Status;
         int ClientsCount;
         int MaxClients;
+        // 0 : a thread per connection (default), >0 : epoll event-loop threads
+        int ReactorThreads;
+        // true : the event callbacks are not serialized, they must be thread safe
+        bool EventsConcurrent;
         TCustomMsgServer();
         virtual ~TCustomMsgServer();
         // Starts the server
@@ -206,12 +275,14 @@ public:
         void Stop();
         // Sets Event callback
         int SetEventsCallBack(pfn_SrvCallBack PCallBack, void *UsrPtr);
-        // Pick an event from the circular queue
+        // Pick an event from the circular queue (single consumer)
         bool PickEvent(void *pEvent);
         // Returns true if (the Event queue is empty
         bool EventEmpty();
-        // Flushes Event queue
+        // Flushes Event queue (same thread of PickEvent)
         void EventsFlush();
+        // Events lost because the queue was full
+        int EventsDropped();
 };
 
 //---------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 #include "snap_sysutils.h"
 #include <thread.h>
 #include <synch.h>
+#include <atomic.h>
 //---------------------------------------------------------------------------
 
 class TSnapCriticalSection {
@@ -64,6 +65,71 @@ public:
 };
 typedef TSnapCriticalSection *PSnapCriticalSection;
 
+//---------------------------------------------------------------------------
+// Many readers or one writer
+class TSnapRWLock {
+private:
+    rwlock_t rw;
+public:
+
+    TSnapRWLock() {
+        rwlock_init(&rw, USYNC_THREAD, 0);
+    };
+
+    ~TSnapRWLock() {
+        rwlock_destroy(&rw);
+    };
+
+    void EnterRead() {
+        rw_rdlock(&rw);
+    };
+
+    void LeaveRead() {
+        rw_unlock(&rw);
+    };
+
+    void EnterWrite() {
+        rw_wrlock(&rw);
+    };
+
+    void LeaveWrite() {
+        rw_unlock(&rw);
+    };
+};
+typedef TSnapRWLock *PSnapRWLock;
+
+//---------------------------------------------------------------------------
+// Atomic helpers, all of them are full barriers
+inline int SnapAtomicAdd(volatile int *Value, int Delta) {
+    int Result;
+    membar_enter();
+    Result = int(atomic_add_int_nv((volatile uint_t *)Value, Delta));
+    membar_exit();
+    return Result;
+}
+
+inline void *SnapAtomicExchange(void * volatile *Target, void *Value) {
+    void *Result;
+    membar_enter();
+    Result = atomic_swap_ptr(Target, Value);
+    membar_exit();
+    return Result;
+}
+
+inline void *SnapAtomicRead(void * volatile *Source) {
+    void *Result = *Source;
+    membar_consumer();
+    return Result;
+}
+
+inline int SnapAtomicCompareExchange(volatile int *Target, int Comperand, int Value) {
+    int Result;
+    membar_enter();
+    Result = int(atomic_cas_uint((volatile uint_t *)Target, uint_t(Comperand), uint_t(Value)));
+    membar_exit();
+    return Result;
+}
+
 //---------------------------------------------------------------------------
 const longword WAIT_OBJECT_0 = 0x00000000L;
 const longword WAIT_ABANDONED = 0x00000080L;
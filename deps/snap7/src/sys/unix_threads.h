@@ -82,6 +82,79 @@ public:
 };
 typedef TSnapCriticalSection *PSnapCriticalSection;
 
+//---------------------------------------------------------------------------
+// Many readers or one writer
+class TSnapRWLock
+{
+private:
+    pthread_rwlock_t rw;
+public:
+
+    TSnapRWLock()
+    {
+#ifdef __GLIBC__
+        // glibc prefers the readers by default, i.e. a continuous polling
+        // would starve the writers
+        pthread_rwlockattr_t rwAttr;
+        pthread_rwlockattr_init(&rwAttr);
+        pthread_rwlockattr_setkind_np(&rwAttr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        pthread_rwlock_init(&rw, &rwAttr);
+        pthread_rwlockattr_destroy(&rwAttr);
+#else
+        pthread_rwlock_init(&rw, 0);
+#endif
+    };
+
+    ~TSnapRWLock()
+    {
+        pthread_rwlock_destroy(&rw);
+    };
+
+    void EnterRead()
+    {
+        pthread_rwlock_rdlock(&rw);
+    };
+
+    void LeaveRead()
+    {
+        pthread_rwlock_unlock(&rw);
+    };
+
+    void EnterWrite()
+    {
+        pthread_rwlock_wrlock(&rw);
+    };
+
+    void LeaveWrite()
+    {
+        pthread_rwlock_unlock(&rw);
+    };
+};
+typedef TSnapRWLock *PSnapRWLock;
+
+//---------------------------------------------------------------------------
+// Atomic helpers, all of them are full barriers
+inline int SnapAtomicAdd(volatile int *Value, int Delta)
+{
+    return __sync_add_and_fetch(Value, Delta);
+}
+
+inline void *SnapAtomicExchange(void * volatile *Target, void *Value)
+{
+    __sync_synchronize();
+    return __sync_lock_test_and_set(Target, Value);
+}
+
+inline void *SnapAtomicRead(void * volatile *Source)
+{
+    return __sync_val_compare_and_swap(Source, (void *)0, (void *)0);
+}
+
+inline int SnapAtomicCompareExchange(volatile int *Target, int Comperand, int Value)
+{
+    return __sync_val_compare_and_swap(Target, Comperand, Value);
+}
+
 //---------------------------------------------------------------------------
 const longword WAIT_OBJECT_0 = 0x00000000L;
 const longword WAIT_ABANDONED = 0x00000080L;
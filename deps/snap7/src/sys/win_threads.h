@@ -67,6 +67,67 @@ public:
 };
 typedef TSnapCriticalSection *PSnapCriticalSection;
 //---------------------------------------------------------------------------
+// Many readers or one writer (Slim Reader/Writer lock, Vista or later)
+class TSnapRWLock
+{
+private:
+    SRWLOCK rw;
+public:
+
+    TSnapRWLock()
+    {
+        InitializeSRWLock(&rw);
+    };
+
+    ~TSnapRWLock()
+    {
+    };
+
+    void EnterRead()
+    {
+        AcquireSRWLockShared(&rw);
+    };
+
+    void LeaveRead()
+    {
+        ReleaseSRWLockShared(&rw);
+    };
+
+    void EnterWrite()
+    {
+        AcquireSRWLockExclusive(&rw);
+    };
+
+    void LeaveWrite()
+    {
+        ReleaseSRWLockExclusive(&rw);
+    };
+};
+typedef TSnapRWLock *PSnapRWLock;
+//---------------------------------------------------------------------------
+// Atomic helpers, all of them are full barriers
+inline int SnapAtomicAdd(volatile int *Value, int Delta)
+{
+    return InterlockedExchangeAdd((volatile LONG *)Value, Delta) + Delta;
+}
+
+inline void *SnapAtomicExchange(void * volatile *Target, void *Value)
+{
+    return InterlockedExchangePointer(Target, Value);
+}
+
+inline void *SnapAtomicRead(void * volatile *Source)
+{
+    void *Result = *Source;
+    MemoryBarrier();
+    return Result;
+}
+
+inline int SnapAtomicCompareExchange(volatile int *Target, int Comperand, int Value)
+{
+    return InterlockedCompareExchange((volatile LONG *)Target, Value, Comperand);
+}
+//---------------------------------------------------------------------------
 
 class TSnapEvent 
 {
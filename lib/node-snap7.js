@@ -15,10 +15,18 @@ snap7.S7Client.prototype.DBWrite = function (dbNumber, start, size, buf, cb) {
     return this.WriteArea(this.S7AreaDB, dbNumber, start, size, this.S7WLByte, buf, cb);
 }
 
+snap7.S7Client.prototype.DBReadInto = function (dbNumber, start, size, buf, offset, cb) {
+    return this.ReadAreaInto(this.S7AreaDB, dbNumber, start, size, this.S7WLByte, buf, offset, cb);
+}
+
 snap7.S7Client.prototype.MBRead = function (start, size, cb) {
     return this.ReadArea(this.S7AreaMK, 0, start, size, this.S7WLByte, cb);
 }
 
+snap7.S7Client.prototype.MBReadInto = function (start, size, buf, offset, cb) {
+    return this.ReadAreaInto(this.S7AreaMK, 0, start, size, this.S7WLByte, buf, offset, cb);
+}
+
 snap7.S7Client.prototype.MBWrite = function (start, size, buf, cb) {
     return this.WriteArea(this.S7AreaMK, 0, start, size, this.S7WLByte, buf, cb);
 }
@@ -27,6 +35,10 @@ snap7.S7Client.prototype.EBRead = function (start, size, cb) {
     return this.ReadArea(this.S7AreaPE, 0, start, size, this.S7WLByte, cb);
 }
 
+snap7.S7Client.prototype.EBReadInto = function (start, size, buf, offset, cb) {
+    return this.ReadAreaInto(this.S7AreaPE, 0, start, size, this.S7WLByte, buf, offset, cb);
+}
+
 snap7.S7Client.prototype.EBWrite = function (start, size, buf, cb) {
     return this.WriteArea(this.S7AreaPE, 0, start, size, this.S7WLByte, buf, cb);
 }
@@ -35,6 +47,10 @@ snap7.S7Client.prototype.ABRead = function (start, size, cb) {
     return this.ReadArea(this.S7AreaPA, 0, start, size, this.S7WLByte, cb);
 }
 
+snap7.S7Client.prototype.ABReadInto = function (start, size, buf, offset, cb) {
+    return this.ReadAreaInto(this.S7AreaPA, 0, start, size, this.S7WLByte, buf, offset, cb);
+}
+
 snap7.S7Client.prototype.ABWrite = function (start, size, buf, cb) {
     return this.WriteArea(this.S7AreaPA, 0, start, size, this.S7WLByte, buf, cb);
 }
@@ -55,5 +71,33 @@ snap7.S7Client.prototype.CTWrite = function (start, size, buf, cb) {
     return this.WriteArea(this.S7AreaCT, 0, start, size, this.S7WLCounter, buf, cb);
 }
 
+// Decodes the i-th item of a packed multi-variable read to a result object
+snap7.S7Client.prototype.ItemAt = function (packed, i) {
+    var count = (packed.Items.length - 1) / 2;
+    var result = packed.Items[count + 1 + i];
+    return {
+        Result: result,
+        Data: result === 0 ? packed.Data.subarray(packed.Items[i], packed.Items[i + 1]) : null
+    };
+}
+
+// Decodes the i-th event of an 'events' emission to an 'event' object
+snap7.S7Server.prototype.EventAt = function (events, i) {
+    var sender = events.sender[i];
+    return {
+        EvtTime: new Date(events.time[i]),
+        EvtSender: [sender >>> 24, (sender >>> 16) & 0xFF, (sender >>> 8) & 0xFF, sender & 0xFF].join('.'),
+        EvtCode: events.code[i],
+        EvtRetCode: events.retCode[i],
+        EvtParam1: events.param1[i],
+        EvtParam2: events.param2[i],
+        EvtParam3: events.param3[i],
+        EvtParam4: events.param4[i]
+    };
+}
+
 snap7.S7Server.super_ = events.EventEmitter;
 Object.setPrototypeOf(snap7.S7Server.prototype, events.EventEmitter.prototype);
+
+snap7.S7Client.super_ = events.EventEmitter;
+Object.setPrototypeOf(snap7.S7Client.prototype, events.EventEmitter.prototype);
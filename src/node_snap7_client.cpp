@@ -59,6 +59,10 @@ NAN_MODULE_INIT(S7Client::Init) {
       tpl
     , "ReadArea"
     , S7Client::ReadArea);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "ReadAreaInto"
+    , S7Client::ReadAreaInto);
   Nan::SetPrototypeMethod(
       tpl
     , "WriteArea"
@@ -67,6 +71,24 @@ NAN_MODULE_INIT(S7Client::Init) {
       tpl
     , "ReadMultiVars"
     , S7Client::ReadMultiVars);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "ReadTagList"
+    , S7Client::ReadTagList);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "PrepareTagSet"
+    , S7Client::PrepareTagSet);
+
+  // Cyclic data functions
+  Nan::SetPrototypeMethod(
+      tpl
+    , "SubscribeCyclic"
+    , S7Client::SubscribeCyclic);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "UnsubscribeCyclic"
+    , S7Client::UnsubscribeCyclic);
   Nan::SetPrototypeMethod(
       tpl
     , "WriteMultiVars"
@@ -193,6 +215,10 @@ NAN_MODULE_INIT(S7Client::Init) {
       tpl
     , "ExecTime"
     , S7Client::ExecTime);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "GetQueueStats"
+    , S7Client::GetQueueStats);
   Nan::SetPrototypeMethod(
       tpl
     , "LastError"
@@ -515,6 +541,23 @@ NAN_MODULE_INIT(S7Client::Init) {
     , Nan::New<v8::Integer>(S7WLTimer)
     , v8::ReadOnly);
 
+  // Job priority classes
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("PriorityControl").ToLocalChecked()
+    , Nan::New<v8::Integer>(PRIORITY_CONTROL)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("PriorityInteractive").ToLocalChecked()
+    , Nan::New<v8::Integer>(PRIORITY_INTERACTIVE)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("PriorityBulk").ToLocalChecked()
+    , Nan::New<v8::Integer>(PRIORITY_BULK)
+    , v8::ReadOnly);
+
   // Block type
   Nan::SetPrototypeTemplate(
       tpl
@@ -667,6 +710,11 @@ NAN_MODULE_INIT(S7Client::Init) {
     , Nan::New<v8::String>("PDURequest").ToLocalChecked()
     , Nan::New<v8::Integer>(p_i32_PDURequest)
     , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("AmQRequest").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_AmQRequest)
+    , v8::ReadOnly);
   Nan::SetPrototypeTemplate(
       tpl
     , Nan::New<v8::String>("MaxClients").ToLocalChecked()
@@ -695,6 +743,8 @@ NAN_MODULE_INIT(S7Client::Init) {
 
   constructor.Reset(tpl);
   Nan::Set(target, name, Nan::GetFunction(tpl).ToLocalChecked());
+
+  S7TagSet::Init();
 }
 
 NAN_METHOD(S7Client::New) {
@@ -711,16 +761,443 @@ NAN_METHOD(S7Client::New) {
   }
 }
 
-S7Client::S7Client() {
+S7Client::S7Client()
+  : cyclic_reset(false), submitted(NULL), completed(NULL)
+  , io_thread_stop(false) {
   snap7Client = new TS7Client();
-  uv_mutex_init(&mutex);
+  io_thread_started = false;
+  pending = 0;
+  uv_sem_init(&io_sem, 0);
+  uv_mutex_init(&io_mutex);
+
+  for (int i = 0; i < PRIORITY_CLASSES; i++) {
+    ready_head[i] = ready_tail[i] = NULL;
+    queue_stats[i].queued = 0;
+    queue_stats[i].executed = 0;
+    queue_stats[i].wait_total = 0;
+    queue_stats[i].wait_max = 0;
+    queue_stats[i].shared = 0;
+  }
+
+  memset(cyclic_jobs, 0, sizeof(cyclic_jobs));
+  cyclic_poll = NULL;
+  cyclic_polling = false;
+  cyclic_checking = false;
+  cyclic_failed = false;
+  cyclic_count = 0;
+
+  completion_async = new uv_async_t;
+  completion_async->data = this;
+  uv_async_init(uv_default_loop(), completion_async
+    , S7Client::HandleCompletion);
+  uv_unref(reinterpret_cast<uv_handle_t *>(completion_async));
 }
 
 S7Client::~S7Client() {
+  // The object is kept alive while jobs are pending, so the thread is idle
+  if (io_thread_started) {
+    io_thread_stop = true;
+    uv_sem_post(&io_sem);
+    uv_thread_join(&io_thread);
+  }
   snap7Client->Disconnect();
   delete snap7Client;
+  ClearCyclicJobs();
   constructor.Reset();
-  uv_mutex_destroy(&mutex);
+  uv_sem_destroy(&io_sem);
+  uv_mutex_destroy(&io_mutex);
+  uv_close(reinterpret_cast<uv_handle_t *>(completion_async)
+    , S7Client::CloseCallback);
+}
+
+void S7Client::CloseCallback(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t *>(handle);
+}
+
+void S7Client::PushWorker(std::atomic<IOWorker*> *list, IOWorker *worker) {
+  IOWorker *head = list->load(std::memory_order_relaxed);
+  do {
+    worker->next = head;
+  } while (!list->compare_exchange_weak(head, worker
+    , std::memory_order_release, std::memory_order_relaxed));
+}
+
+IOWorker *S7Client::TakeWorkers(std::atomic<IOWorker*> *list) {
+  IOWorker *head = list->exchange(NULL, std::memory_order_acquire);
+  IOWorker *fifo = NULL;
+
+  // Reverse the LIFO list to preserve the submission order
+  while (head != NULL) {
+    IOWorker *next = head->next;
+    head->next = fifo;
+    fifo = head;
+    head = next;
+  }
+  return fifo;
+}
+
+JobPriority S7Client::PriorityOf(DataIOFunction caller) {
+  switch (caller) {
+  // Writes and commands, they must not wait for the polls
+  case CONNECT:
+  case CONNECTTO:
+  case WRITEAREA:
+  case WRITEMULTI:
+  case TAGSETWRITE:
+  case PLCSTOP:
+  case PLCHOTSTART:
+  case PLCCOLDSTART:
+  case SETPLCDATETIME:
+  case SETPLCSYSTEMDATETIME:
+  case SETSESSIONPW:
+  case CLEARSESSIONPW:
+  case SUBSCRIBECYCLIC:
+  case UNSUBSCRIBECYCLIC:
+      return PRIORITY_CONTROL;
+  // Block transfers and the long running jobs
+  case DBGET:
+  case DBFILL:
+  case UPLOAD:
+  case FULLUPLOAD:
+  case DOWNLOAD:
+  case DELETEBLOCK:
+  case LISTBLOCKS:
+  case LISTBLOCKSOFTYPE:
+  case GETAGBLOCKINFO:
+  case READSZL:
+  case READSZLLIST:
+  case COMPRESS:
+  case COPYRAMTOROM:
+      return PRIORITY_BULK;
+  default:
+      return PRIORITY_INTERACTIVE;
+  }
+}
+
+void S7Client::QueueWorker(IOWorker *worker) {
+  // While jobs run the pushes are collected after each of them
+  if (cyclic_polling) {
+    uv_poll_stop(cyclic_poll);
+    cyclic_polling = false;
+  }
+
+  if (!io_thread_started) {
+    uv_thread_create(&io_thread, S7Client::IOThread, this);
+    io_thread_started = true;
+  }
+
+  // Keep the object and the event loop alive until the last job completes
+  if (pending++ == 0) {
+    Ref();
+    uv_ref(reinterpret_cast<uv_handle_t *>(completion_async));
+  }
+
+  worker->priority = PriorityOf(worker->caller);
+  worker->submit_time = uv_hrtime();
+  queue_stats[worker->priority].queued++;
+
+  PushWorker(&submitted, worker);
+  uv_sem_post(&io_sem);
+}
+
+// Sorts the jobs submitted up to now into their class
+void S7Client::SortWorkers() {
+  IOWorker *worker = TakeWorkers(&submitted);
+
+  while (worker != NULL) {
+    IOWorker *next = worker->next;
+    worker->next = NULL;
+    if (ready_tail[worker->priority] != NULL) {
+      ready_tail[worker->priority]->next = worker;
+    } else {
+      ready_head[worker->priority] = worker;
+    }
+    ready_tail[worker->priority] = worker;
+    worker = next;
+  }
+}
+
+// Picks the first job of the most urgent class
+IOWorker *S7Client::NextWorker() {
+  IOWorker *worker;
+
+  SortWorkers();
+  for (int i = 0; i < PRIORITY_CLASSES; i++) {
+    worker = ready_head[i];
+    if (worker != NULL) {
+      ready_head[i] = worker->next;
+      if (ready_head[i] == NULL)
+        ready_tail[i] = NULL;
+
+      JobQueueStats &stats = queue_stats[i];
+      uint64_t wait = uv_hrtime() - worker->submit_time;
+      stats.queued--;
+      stats.executed++;
+      stats.wait_total += wait;
+      if (wait > stats.wait_max)
+        stats.wait_max = wait;
+      return worker;
+    }
+  }
+  return NULL;
+}
+
+// Jobs after which a read can give other data : the writes, the block
+// and PLC commands, a new connection
+static bool ChangesData(DataIOFunction caller) {
+  switch (caller) {
+  case DBFILL:
+  case DOWNLOAD:
+  case DELETEBLOCK:
+      return true;
+  default:
+      return S7Client::PriorityOf(caller) == PRIORITY_CONTROL;
+  }
+}
+
+// Byte range of a READAREA job into the area, false if it cannot be shared
+static bool ReadRange(int start, int amount, int wordLen, int &lo, int &hi) {
+  switch (wordLen) {
+  case S7WLBit:
+      return false;
+  case S7WLCounter:
+  case S7WLTimer:
+      // Start is the index of the first element
+      lo = start * 2;
+      break;
+  default:
+      lo = start;
+  }
+  hi = lo + amount * S7Client::GetByteCountFromWordLen(wordLen);
+  return true;
+}
+
+// Single-flight reads : the queued READAREA(INTO) jobs that ask for the same
+// area, DB and word length as the one just executed, and for a range it
+// contains, are answered with its data instead of asking the PLC again.
+// A read submitted after a job that is still queued and can change the
+// data (see ChangesData) must see its effect, so it's left alone. Returns the jobs answered, in submission order.
+IOWorker *S7Client::ShareRead(IOWorker *reader) {
+  IOWorker *prev = NULL, *worker, *next;
+  IOWorker *shared_head = NULL, *shared_tail = NULL;
+  int lo, hi, wlo, whi;
+  uint64_t limit = UINT64_MAX;
+
+  if (!ReadRange(reader->int3, reader->int4, reader->int5, lo, hi))
+    return NULL;
+
+  // The oldest queued job that can change the data read, of any class
+  SortWorkers();
+  for (int i = 0; i < PRIORITY_CLASSES; i++) {
+    for (worker = ready_head[i]; worker != NULL; worker = worker->next) {
+      if (ChangesData(worker->caller) && worker->submit_time < limit)
+        limit = worker->submit_time;
+    }
+  }
+
+  JobQueueStats &stats = queue_stats[PRIORITY_INTERACTIVE];
+  for (worker = ready_head[PRIORITY_INTERACTIVE]; worker != NULL
+      ; worker = next) {
+    next = worker->next;
+    if ((worker->caller != READAREA && worker->caller != READAREAINTO) ||
+        worker->submit_time >= limit ||
+        worker->int1 != reader->int1 || worker->int2 != reader->int2 ||
+        worker->int5 != reader->int5 ||
+        !ReadRange(worker->int3, worker->int4, worker->int5, wlo, whi) ||
+        wlo < lo || whi > hi) {
+      prev = worker;
+      continue;
+    }
+
+    // Out of the queue
+    if (prev != NULL) {
+      prev->next = next;
+    } else {
+      ready_head[PRIORITY_INTERACTIVE] = next;
+    }
+    if (ready_tail[PRIORITY_INTERACTIVE] == worker)
+      ready_tail[PRIORITY_INTERACTIVE] = prev;
+
+    worker->returnValue = reader->returnValue;
+    if (reader->returnValue == 0) {
+      memcpy(worker->pData, static_cast<char*>(reader->pData) + (wlo - lo)
+        , whi - wlo);
+    }
+
+    uint64_t wait = uv_hrtime() - worker->submit_time;
+    stats.queued--;
+    stats.executed++;
+    stats.shared++;
+    stats.wait_total += wait;
+    if (wait > stats.wait_max)
+      stats.wait_max = wait;
+
+    worker->next = NULL;
+    if (shared_tail != NULL) {
+      shared_tail->next = worker;
+    } else {
+      shared_head = worker;
+    }
+    shared_tail = worker;
+  }
+  return shared_head;
+}
+
+void S7Client::IOThread(void *arg) {
+  S7Client *s7client = static_cast<S7Client*>(arg);
+
+  // One job at a time, so a job submitted meanwhile can overtake the
+  // ones of a less urgent class
+  while (true) {
+    IOWorker *worker = s7client->NextWorker();
+    if (worker == NULL) {
+      uv_sem_wait(&s7client->io_sem);
+      if (s7client->io_thread_stop)
+        break;
+      continue;
+    }
+
+    uv_mutex_lock(&s7client->io_mutex);
+    worker->Execute();
+    uv_mutex_unlock(&s7client->io_mutex);
+    // Before completing it, its buffer is released by the callback
+    IOWorker *shared = (worker->caller == READAREA ||
+      worker->caller == READAREAINTO) ? s7client->ShareRead(worker) : NULL;
+    PushWorker(&s7client->completed, worker);
+    while (shared != NULL) {
+      IOWorker *next = shared->next;
+      PushWorker(&s7client->completed, shared);
+      shared = next;
+    }
+    uv_async_send(s7client->completion_async);
+  }
+}
+
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+void S7Client::HandleCompletion(uv_async_t* handle) {
+#else
+void S7Client::HandleCompletion(uv_async_t* handle, int status) {
+#endif
+  Nan::HandleScope scope;
+  S7Client *s7client = static_cast<S7Client*>(handle->data);
+  bool absorbed = false;
+
+  IOWorker *worker = TakeWorkers(&s7client->completed);
+  while (worker != NULL) {
+    IOWorker *next = worker->next;
+    // Any job could have received pushes in place of its answer
+    absorbed = absorbed || (worker->caller != CHECKCYCLIC);
+    worker->WorkComplete();
+    worker->Destroy();
+
+    if (--s7client->pending == 0) {
+      uv_unref(reinterpret_cast<uv_handle_t *>(handle));
+      s7client->Unref();
+    }
+    worker = next;
+  }
+
+  if (s7client->cyclic_count > 0 && !s7client->cyclic_checking) {
+    if (absorbed) {
+      s7client->QueueCyclicCheck();
+    } else if (s7client->pending == 0 && !s7client->cyclic_failed &&
+        !s7client->cyclic_polling) {
+      uv_poll_start(s7client->cyclic_poll, UV_READABLE
+        , S7Client::HandleCyclicPoll);
+      s7client->cyclic_polling = true;
+    }
+  }
+}
+
+void S7Client::OpenCyclicPoll() {
+  int sock;
+
+  // The poll keeps the object and the event loop alive while subscribed
+  snap7Client->GetParam(p_i32_SocketHandle, &sock);
+  cyclic_poll = new uv_poll_t;
+  cyclic_poll->data = this;
+  uv_poll_init_socket(uv_default_loop(), cyclic_poll
+    , static_cast<uv_os_sock_t>(sock));
+  cyclic_polling = false;
+  cyclic_failed = false;
+  Ref();
+}
+
+void S7Client::CloseCyclicPoll() {
+  uv_close(reinterpret_cast<uv_handle_t *>(cyclic_poll)
+    , S7Client::ClosePollCallback);
+  cyclic_poll = NULL;
+  cyclic_polling = false;
+  Unref();
+}
+
+void S7Client::ClosePollCallback(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_poll_t *>(handle);
+}
+
+void S7Client::HandleCyclicPoll(uv_poll_t* handle, int status, int) {
+  Nan::HandleScope scope;
+  S7Client *s7client = static_cast<S7Client*>(handle->data);
+
+  uv_poll_stop(handle);
+  s7client->cyclic_polling = false;
+  if (status == 0)
+    s7client->QueueCyclicCheck();
+}
+
+void S7Client::QueueCyclicCheck() {
+  cyclic_checking = true;
+  QueueWorker(new IOWorker(NULL, this, CHECKCYCLIC));
+}
+
+SyncCall::SyncCall(S7Client *s7client) : s7client(s7client) {
+  uv_mutex_lock(&s7client->io_mutex);
+}
+
+SyncCall::~SyncCall() {
+  uv_mutex_unlock(&s7client->io_mutex);
+  // Pushes received in place of the answer are not signaled by the poll
+  // anymore, as for an async job
+  if (s7client->cyclic_count > 0 && !s7client->cyclic_checking)
+    s7client->QueueCyclicCheck();
+}
+
+// The connection is gone (or renewed) and the subscriptions with it
+void S7Client::DropCyclicJobs() {
+  if (cyclic_count > 0) {
+    CloseCyclicPoll();
+    cyclic_count = 0;
+  }
+  // The I/O thread releases them before its next job
+  cyclic_reset = true;
+}
+
+void S7Client::ClearCyclicJobs() {
+  for (int i = 0; i < MaxCyclicJobs; i++) {
+    if (cyclic_jobs[i].JobID != 0)
+      FreeDataItems(cyclic_jobs[i].Items, cyclic_jobs[i].Count);
+  }
+  memset(cyclic_jobs, 0, sizeof(cyclic_jobs));
+}
+
+PS7DataItem S7Client::CopyDataItems(PS7DataItem Items, int len) {
+  PS7DataItem Copy = new TS7DataItem[len];
+  int size;
+
+  for (int i = 0; i < len; i++) {
+    Copy[i] = Items[i];
+    size = Items[i].Amount * GetByteCountFromWordLen(Items[i].WordLen);
+    Copy[i].pdata = new char[size];
+    memcpy(Copy[i].pdata, Items[i].pdata, size);
+  }
+  return Copy;
+}
+
+void S7Client::FreeDataItems(PS7DataItem Items, int len) {
+  for (int i = 0; i < len; i++) {
+    delete[] static_cast<char*>(Items[i].pdata);
+  }
+  delete[] Items;
 }
 
 int S7Client::GetByteCountFromWordLen(int WordLen) {
@@ -752,12 +1229,14 @@ void S7Client::FreeCallbackSZL(char *data, void *hint) {
 NAN_METHOD(S7Client::Connect) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
+  s7client->DropCyclicJobs();
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int ret = s7client->snap7Client->Connect();
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, CONNECT));
+    s7client->QueueWorker(new IOWorker(callback, s7client, CONNECT));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -773,8 +1252,10 @@ NAN_METHOD(S7Client::ConnectTo) {
     return Nan::ThrowTypeError("Wrong arguments");
   }
 
+  s7client->DropCyclicJobs();
   Nan::Utf8String *remAddress = new Nan::Utf8String(info[0]);
   if (!info[3]->IsFunction()) {
+    SyncCall sync(s7client);
     int ret = s7client->snap7Client->ConnectTo(
         **remAddress
       , Nan::To<int32_t>(info[1]).FromJust()
@@ -783,7 +1264,7 @@ NAN_METHOD(S7Client::ConnectTo) {
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[3].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, CONNECTTO
+    s7client->QueueWorker(new IOWorker(callback, s7client, CONNECTTO
       , remAddress, Nan::To<int32_t>(info[1]).FromJust(), Nan::To<int32_t>(info[2]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
@@ -824,6 +1305,8 @@ NAN_METHOD(S7Client::SetConnectionType) {
 NAN_METHOD(S7Client::Disconnect) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
+  s7client->DropCyclicJobs();
+  SyncCall sync(s7client);
   int ret = s7client->snap7Client->Disconnect();
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
@@ -860,19 +1343,23 @@ NAN_METHOD(S7Client::SetParam) {
 
 // Data I/O Main functions
 void IOWorker::Execute() {
-  uv_mutex_lock(&s7client->mutex);
+  if (s7client->cyclic_reset.exchange(false))
+    s7client->ClearCyclicJobs();
 
   switch (caller) {
   case CONNECTTO:
       returnValue = s7client->snap7Client->ConnectTo(
           **static_cast<Nan::Utf8String*>(pData), int1, int2);
+      s7client->ClearCyclicJobs();
       break;
 
   case CONNECT:
       returnValue = s7client->snap7Client->Connect();
+      s7client->ClearCyclicJobs();
       break;
 
   case READAREA:
+  case READAREAINTO:
       returnValue = s7client->snap7Client->ReadArea(int1, int2, int3, int4
         , int5, pData);
       break;
@@ -887,11 +1374,86 @@ void IOWorker::Execute() {
           static_cast<PS7DataItem>(pData), int1);
       break;
 
+  case READTAGLIST:
+      returnValue = s7client->snap7Client->ReadTagList(
+          static_cast<PS7DataItem>(pData), int1);
+      break;
+
   case WRITEMULTI:
       returnValue = s7client->snap7Client->WriteMultiVars(
           static_cast<PS7DataItem>(pData), int1);
       break;
 
+  case TAGSETREAD:
+      returnValue = static_cast<S7TagSet*>(pData)->ReadItems();
+      break;
+
+  case TAGSETWRITE:
+      returnValue = static_cast<S7TagSet*>(pData)->WriteItems();
+      break;
+
+  case SUBSCRIBECYCLIC:
+      returnValue = s7client->snap7Client->SubscribeCyclic(
+          static_cast<PS7DataItem>(pData), int1, int2, &int3);
+      if (returnValue == 0) {
+        // The items are now updated by the pushes, the caller gets a copy
+        for (int i = 0; i < MaxCyclicJobs; i++) {
+          CyclicJob *job = &s7client->cyclic_jobs[i];
+          if (job->JobID == int3 || job->JobID == 0) {
+            if (job->JobID != 0)
+              S7Client::FreeDataItems(job->Items, job->Count);
+            job->JobID = int3;
+            job->Count = int1;
+            job->Items = static_cast<PS7DataItem>(pData);
+            break;
+          }
+        }
+        pData = S7Client::CopyDataItems(static_cast<PS7DataItem>(pData), int1);
+      }
+      break;
+
+  case UNSUBSCRIBECYCLIC:
+      returnValue = s7client->snap7Client->UnsubscribeCyclic(int1);
+      // The subscription is released even if the PLC refused to stop it
+      int2 = 0;
+      for (int i = 0; i < MaxCyclicJobs; i++) {
+        CyclicJob *job = &s7client->cyclic_jobs[i];
+        if (job->JobID != 0 && job->JobID == int1) {
+          S7Client::FreeDataItems(job->Items, job->Count);
+          memset(job, 0, sizeof(CyclicJob));
+          int2 = 1;
+        }
+      }
+      break;
+
+  case CHECKCYCLIC: {
+      CyclicJob *updates = new CyclicJob[MaxCyclicJobs];
+      int JobID;
+
+      // Collects what the pushes received so far, without waiting
+      int1 = 0;
+      while (int1 < MaxCyclicJobs) {
+        returnValue = s7client->snap7Client->CheckCyclic(&JobID, 0);
+        if (returnValue != 0)
+          break;
+        for (int i = 0; i < MaxCyclicJobs; i++) {
+          CyclicJob *job = &s7client->cyclic_jobs[i];
+          if (job->JobID != 0 && job->JobID == JobID) {
+            updates[int1].JobID = JobID;
+            updates[int1].Count = job->Count;
+            updates[int1].Items = S7Client::CopyDataItems(job->Items
+              , job->Count);
+            int1++;
+            break;
+          }
+        }
+      }
+      if (returnValue == errCliJobTimeout)
+        returnValue = 0;
+      pData = updates;
+      break;
+    }
+
   case PLCSTATUS:
       returnValue = s7client->snap7Client->PlcStatus();
       if ((returnValue == S7CpuStatusUnknown) ||
@@ -1014,8 +1576,6 @@ void IOWorker::Execute() {
         , static_cast<PS7SZL>(pData), &int3);
       break;
   }
-
-  uv_mutex_unlock(&s7client->mutex);
 }
 
 void IOWorker::HandleOKCallback() {
@@ -1032,12 +1592,22 @@ void IOWorker::HandleOKCallback() {
 
   switch (caller) {
   case CONNECTTO:
+      // Subscriptions made while connecting died with the old connection
+      s7client->DropCyclicJobs();
+      delete static_cast<Nan::Utf8String*>(pData);
+      callback->Call(1, argv1, async_resource);
+      break;
+
   case SETSESSIONPW:
       delete static_cast<Nan::Utf8String*>(pData);
       callback->Call(1, argv1, async_resource);
       break;
 
   case CONNECT:
+      s7client->DropCyclicJobs();
+      callback->Call(1, argv1, async_resource);
+      break;
+
   case WRITEAREA:
   case CLEARSESSIONPW:
   case PLCSTOP:
@@ -1066,10 +1636,29 @@ void IOWorker::HandleOKCallback() {
     callback->Call(2, argv2, async_resource);
     break;
 
+  case READAREAINTO:
+    if (returnValue == 0) {
+      argv2[1] = GetFromPersistent("buffer");
+    } else {
+      argv2[1] = Nan::Null();
+    }
+    callback->Call(2, argv2, async_resource);
+    break;
+
   case READMULTI:
+  case READTAGLIST:
       if (returnValue == 0) {
-        argv2[1] = s7client->S7DataItemToArray(static_cast<PS7DataItem>(pData)
-          , int1, true);
+        if (int2 == LAYOUT_PACKED)
+          argv2[1] = s7client->S7DataItemToPacked(
+              static_cast<PS7DataItem>(pData), int1);
+        else
+          argv2[1] = s7client->S7DataItemToArray(
+              static_cast<PS7DataItem>(pData), int1, true);
+      } else if (int2 == LAYOUT_PACKED) {
+        // The items share a single block
+        delete[] static_cast<char*>(static_cast<PS7DataItem>(pData)[0].pdata);
+        delete[] static_cast<PS7DataItem>(pData);
+        argv2[1] = Nan::Null();
       } else {
         for (int i = 0; i < int1; i++) {
           delete[] static_cast<char*>(static_cast<PS7DataItem>(pData)[i].pdata);
@@ -1091,6 +1680,73 @@ void IOWorker::HandleOKCallback() {
       callback->Call(2, argv2, async_resource);
       break;
 
+  case TAGSETREAD:
+  case TAGSETWRITE: {
+      // The set can be used again from within the callback
+      S7TagSet *tagset = static_cast<S7TagSet*>(pData);
+      tagset->busy = false;
+      if (returnValue != 0) {
+        argv2[1] = Nan::Null();
+      } else if (caller == TAGSETWRITE) {
+        argv2[1] = tagset->ResultsToArray(false);
+      } else if (int1 == LAYOUT_PACKED) {
+        argv2[1] = tagset->ResultsToPacked();
+      } else if (int1 == LAYOUT_INTO) {
+        v8::Local<v8::Value> layout = GetFromPersistent("layout");
+        Nan::TypedArrayContents<int32_t> contents(layout);
+        S7Client::PackItems(tagset->items, tagset->count
+          , static_cast<char*>(tagset->items[0].pdata), *contents);
+        argv2[1] = layout;
+      } else {
+        argv2[1] = tagset->ResultsToArray(true);
+      }
+      callback->Call(2, argv2, async_resource);
+      break;
+    }
+
+  case SUBSCRIBECYCLIC: {
+      v8::Local<v8::Value> argv3[3];
+      argv3[0] = argv2[0];
+      if (returnValue == 0) {
+        if (s7client->cyclic_count++ == 0)
+          s7client->OpenCyclicPoll();
+        argv3[1] = Nan::New<v8::Integer>(int3);
+        argv3[2] = s7client->S7DataItemToArray(static_cast<PS7DataItem>(pData)
+          , int1, true);
+      } else {
+        S7Client::FreeDataItems(static_cast<PS7DataItem>(pData), int1);
+        argv3[1] = argv3[2] = Nan::Null();
+      }
+      callback->Call(3, argv3, async_resource);
+      break;
+    }
+
+  case UNSUBSCRIBECYCLIC:
+      if (int2 && s7client->cyclic_count > 0) {
+        if (--s7client->cyclic_count == 0)
+          s7client->CloseCyclicPoll();
+      }
+      callback->Call(1, argv1, async_resource);
+      break;
+
+  case CHECKCYCLIC: {
+      CyclicJob *updates = static_cast<CyclicJob*>(pData);
+
+      s7client->cyclic_checking = false;
+      // Don't spin on a broken connection, the next job will retry
+      s7client->cyclic_failed = returnValue != 0;
+      for (int i = 0; i < int1; i++) {
+        v8::Local<v8::Value> argv[3] = {
+          Nan::New("cyclic").ToLocalChecked(),
+          Nan::New<v8::Integer>(updates[i].JobID),
+          s7client->S7DataItemToArray(updates[i].Items, updates[i].Count, true)
+        };
+        async_resource->runInAsyncScope(s7client->handle(), "emit", 3, argv);
+      }
+      delete[] updates;
+      break;
+    }
+
   case GETPROTECTION:
       if (returnValue == 0) {
         argv2[1] = s7client->S7ProtectionToObject(
@@ -1269,6 +1925,7 @@ NAN_METHOD(S7Client::ReadArea) {
   char *bufferData = new char[size];
 
   if (!info[5]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->ReadArea(
 		Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()
       , Nan::To<int32_t>(info[2]).FromJust(), Nan::To<int32_t>(info[3]).FromJust()
@@ -1288,13 +1945,70 @@ NAN_METHOD(S7Client::ReadArea) {
 
   } else {
     Nan::Callback *callback = new Nan::Callback(info[5].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, READAREA
+    s7client->QueueWorker(new IOWorker(callback, s7client, READAREA
       , bufferData, Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()
       , Nan::To<int32_t>(info[2]).FromJust(), Nan::To<int32_t>(info[3]).FromJust(), Nan::To<int32_t>(info[4]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
 }
 
+NAN_METHOD(S7Client::ReadAreaInto) {
+  S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
+
+  if (info.Length() < 6)
+    return Nan::ThrowTypeError("Wrong number of Arguments");
+
+  if (!info[0]->IsInt32() || !info[1]->IsInt32() ||
+      !info[2]->IsInt32() || !info[3]->IsInt32() ||
+      !info[4]->IsInt32() || !node::Buffer::HasInstance(info[5]))
+    return Nan::ThrowTypeError("Wrong arguments");
+
+  // The offset into the buffer is optional
+  int offset = 0;
+  int cb_index = 6;
+  if (!info[6]->IsFunction()) {
+    if (info[6]->IsInt32()) {
+      offset = Nan::To<int32_t>(info[6]).FromJust();
+    } else if (!info[6]->IsUndefined()) {
+      return Nan::ThrowTypeError("Wrong arguments");
+    }
+    cb_index = 7;
+  }
+
+  int amount = Nan::To<int32_t>(info[3]).FromJust();
+  int byteCount = s7client->GetByteCountFromWordLen(Nan::To<int32_t>(info[4]).FromJust());
+  int size = amount * byteCount;
+  int length = static_cast<int>(node::Buffer::Length(info[5].As<v8::Object>()));
+  if (offset < 0 || size < 0 || offset > length - size)
+    return Nan::ThrowTypeError("Buffer is too small for the data");
+
+  // The data are read straight into the caller's buffer
+  char *bufferData = node::Buffer::Data(info[5].As<v8::Object>()) + offset;
+
+  if (!info[cb_index]->IsFunction()) {
+    SyncCall sync(s7client);
+    int returnValue = s7client->snap7Client->ReadArea(
+        Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()
+      , Nan::To<int32_t>(info[2]).FromJust(), amount
+      , Nan::To<int32_t>(info[4]).FromJust(), bufferData);
+
+    if (returnValue == 0) {
+      info.GetReturnValue().Set(info[5]);
+    } else {
+      info.GetReturnValue().Set(Nan::False());
+    }
+  } else {
+    Nan::Callback *callback = new Nan::Callback(
+      info[cb_index].As<v8::Function>());
+    IOWorker *worker = new IOWorker(callback, s7client, READAREAINTO
+      , bufferData, Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()
+      , Nan::To<int32_t>(info[2]).FromJust(), amount, Nan::To<int32_t>(info[4]).FromJust());
+    worker->SaveToPersistent("buffer", info[5]);
+    s7client->QueueWorker(worker);
+    info.GetReturnValue().SetUndefined();
+  }
+}
+
 NAN_METHOD(S7Client::WriteArea) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
@@ -1307,6 +2021,7 @@ NAN_METHOD(S7Client::WriteArea) {
     return Nan::ThrowTypeError("Wrong arguments");
 
   if (!info[6]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->WriteArea(Nan::To<int32_t>(info[0]).FromJust()
         , Nan::To<int32_t>(info[1]).FromJust(), Nan::To<int32_t>(info[2]).FromJust()
@@ -1314,15 +2029,50 @@ NAN_METHOD(S7Client::WriteArea) {
         , node::Buffer::Data(info[5].As<v8::Object>())) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[6].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, WRITEAREA
+    IOWorker *worker = new IOWorker(callback, s7client, WRITEAREA
       , node::Buffer::Data(info[5].As<v8::Object>()), Nan::To<int32_t>(info[0]).FromJust()
       , Nan::To<int32_t>(info[1]).FromJust(), Nan::To<int32_t>(info[2]).FromJust(), Nan::To<int32_t>(info[3]).FromJust()
-      , Nan::To<int32_t>(info[4]).FromJust()));
+      , Nan::To<int32_t>(info[4]).FromJust());
+    // The data are sent straight from the caller's buffer
+    worker->SaveToPersistent("buffer", info[5]);
+    s7client->QueueWorker(worker);
     info.GetReturnValue().SetUndefined();
   }
 }
 
 NAN_METHOD(S7Client::ReadMultiVars) {
+  S7Client::ReadItems(info, READMULTI);
+}
+
+NAN_METHOD(S7Client::ReadTagList) {
+  S7Client::ReadItems(info, READTAGLIST);
+}
+
+NAN_METHOD(S7Client::SubscribeCyclic) {
+  S7Client::ReadItems(info, SUBSCRIBECYCLIC);
+}
+
+NAN_METHOD(S7Client::UnsubscribeCyclic) {
+  S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
+
+  if (info.Length() < 2) {
+    return Nan::ThrowTypeError("Wrong number of arguments");
+  }
+
+  if (!info[0]->IsInt32() || !info[1]->IsFunction()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+  s7client->QueueWorker(new IOWorker(callback, s7client, UNSUBSCRIBECYCLIC
+    , Nan::To<int32_t>(info[0]).FromJust()));
+  info.GetReturnValue().SetUndefined();
+}
+
+void S7Client::ReadItems(
+    const Nan::FunctionCallbackInfo<v8::Value>& info
+  , DataIOFunction func
+) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (info.Length() < 1) {
@@ -1333,14 +2083,29 @@ NAN_METHOD(S7Client::ReadMultiVars) {
     return Nan::ThrowTypeError("Wrong arguments");
   }
 
+  // Pushed data are delivered by events, so subscribing is async only
+  if ((func == SUBSCRIBECYCLIC) &&
+      (!info[1]->IsInt32() || !info[2]->IsFunction())) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  // An optional boolean asks for the packed result
+  bool packed = false;
+  int cb_index = 1;
+  if ((func != SUBSCRIBECYCLIC) && info[1]->IsBoolean()) {
+    packed = Nan::To<bool>(info[1]).FromJust();
+    cb_index = 2;
+  }
+
   v8::Local<v8::Array> data_arr = v8::Local<v8::Array>::Cast(info[0]);
   int len = data_arr->Length();
   if (len == 0) {
     return Nan::ThrowTypeError("Array needs at least 1 item");
-  } else if (len > MaxVars) {
+  } else if ((func != READTAGLIST) && (len > MaxVars)) {
     std::stringstream err;
     err << "Array exceeds max variables (" << MaxVars
-        << ") that can be transferred with ReadMultiVars()";
+        << ") that can be transferred with "
+        << (func == READMULTI ? "ReadMultiVars()" : "SubscribeCyclic()");
     return Nan::ThrowTypeError(err.str().c_str());
   }
 
@@ -1371,7 +2136,7 @@ NAN_METHOD(S7Client::ReadMultiVars) {
 
   PS7DataItem Items = new TS7DataItem[len];
   v8::Local<v8::Object> data_obj;
-  int byteCount, size;
+  int byteCount, size, total = 0;
 
   for (int i = 0; i < len; i++) {
     data_obj = Nan::To<v8::Object>(Nan::Get(data_arr, i).ToLocalChecked()).ToLocalChecked();
@@ -1389,25 +2154,56 @@ NAN_METHOD(S7Client::ReadMultiVars) {
 
     byteCount = s7client->GetByteCountFromWordLen(Items[i].WordLen);
     size = Items[i].Amount * byteCount;
-    Items[i].pdata = new char[size];
+    if (packed)
+      total += size;
+    else
+      Items[i].pdata = new char[size];
   }
 
-  if (!info[1]->IsFunction()) {
-    int returnValue = s7client->snap7Client->ReadMultiVars(Items, len);
+  // The items are read back to back into a single block
+  if (packed) {
+    char *block = new char[total];
+    for (int i = 0; i < len; i++) {
+      Items[i].pdata = block;
+      block += Items[i].Amount * GetByteCountFromWordLen(Items[i].WordLen);
+    }
+  }
+
+  if (func == SUBSCRIBECYCLIC) {
+    Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
+    s7client->QueueWorker(new IOWorker(callback, s7client, func
+      , Items, len, Nan::To<int32_t>(info[1]).FromJust()));
+    info.GetReturnValue().SetUndefined();
+  } else if (!info[cb_index]->IsFunction()) {
+    SyncCall sync(s7client);
+    int returnValue;
+    if (func == READMULTI)
+      returnValue = s7client->snap7Client->ReadMultiVars(Items, len);
+    else
+      returnValue = s7client->snap7Client->ReadTagList(Items, len);
 
     if (returnValue == 0) {
-      info.GetReturnValue().Set(s7client->S7DataItemToArray(Items, len, true));
+      if (packed)
+        info.GetReturnValue().Set(s7client->S7DataItemToPacked(Items, len));
+      else
+        info.GetReturnValue().Set(s7client->S7DataItemToArray(Items, len
+          , true));
     } else {
-      for (int i = 0; i < len; i++) {
-        delete[] static_cast<char*>(Items[i].pdata);
+      if (packed) {
+        delete[] static_cast<char*>(Items[0].pdata);
+      } else {
+        for (int i = 0; i < len; i++) {
+          delete[] static_cast<char*>(Items[i].pdata);
+        }
       }
       delete[] Items;
       info.GetReturnValue().Set(Nan::False());
     }
   } else {
-    Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, READMULTI
-      , Items, len));
+    Nan::Callback *callback = new Nan::Callback(
+      info[cb_index].As<v8::Function>());
+    s7client->QueueWorker(new IOWorker(callback, s7client, func
+      , Items, len, packed ? LAYOUT_PACKED : LAYOUT_OBJECTS));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -1452,6 +2248,49 @@ v8::Local<v8::Array> S7Client::S7DataItemToArray(
   return scope.Escape(res_arr);
 }
 
+// Layout of len items : their offsets, the total size, their results
+v8::Local<v8::Int32Array> S7Client::NewItemsLayout(int len) {
+  v8::Local<v8::ArrayBuffer> store = v8::ArrayBuffer::New(
+    v8::Isolate::GetCurrent(), (len * 2 + 1) * sizeof(int32_t));
+  return v8::Int32Array::New(store, 0, len * 2 + 1);
+}
+
+void S7Client::PackItems(
+    PS7DataItem Items
+  , int len
+  , char *base
+  , int32_t *layout
+) {
+  for (int i = 0; i < len; i++) {
+    layout[i] = static_cast<int32_t>(static_cast<char*>(Items[i].pdata) - base);
+    layout[len + 1 + i] = Items[i].Result;
+  }
+  layout[len] = layout[len - 1] + Items[len - 1].Amount *
+    S7Client::GetByteCountFromWordLen(Items[len - 1].WordLen);
+}
+
+// The items were read into a single block, it becomes the Data buffer
+v8::Local<v8::Object> S7Client::S7DataItemToPacked(
+    PS7DataItem Items
+  , int len
+) {
+  Nan::EscapableHandleScope scope;
+
+  v8::Local<v8::Int32Array> layout = S7Client::NewItemsLayout(len);
+  Nan::TypedArrayContents<int32_t> contents(layout);
+  char *block = static_cast<char*>(Items[0].pdata);
+  S7Client::PackItems(Items, len, block, *contents);
+
+  v8::Local<v8::Object> res_obj = Nan::New<v8::Object>();
+  Nan::Set(res_obj, Nan::New<v8::String>("Data").ToLocalChecked()
+    , Nan::NewBuffer(block, (*contents)[len], S7Client::FreeCallback
+    , NULL).ToLocalChecked());
+  Nan::Set(res_obj, Nan::New<v8::String>("Items").ToLocalChecked(), layout);
+  delete[] Items;
+
+  return scope.Escape(res_obj);
+}
+
 NAN_METHOD(S7Client::WriteMultiVars) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
@@ -1521,6 +2360,7 @@ NAN_METHOD(S7Client::WriteMultiVars) {
   }
 
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->WriteMultiVars(Items, len);
 
     if (returnValue == 0) {
@@ -1531,18 +2371,464 @@ NAN_METHOD(S7Client::WriteMultiVars) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, WRITEMULTI
+    s7client->QueueWorker(new IOWorker(callback, s7client, WRITEMULTI
       , Items, len));
     info.GetReturnValue().SetUndefined();
   }
 }
 
+NAN_METHOD(S7Client::PrepareTagSet) {
+  S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
+
+  if (info.Length() < 1) {
+    return Nan::ThrowTypeError("Wrong number of arguments");
+  }
+
+  if (!info[0]->IsArray()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  v8::Local<v8::Array> data_arr = v8::Local<v8::Array>::Cast(info[0]);
+  int len = data_arr->Length();
+  if (len == 0) {
+    return Nan::ThrowTypeError("Array needs at least 1 item");
+  }
+
+  v8::Local<v8::String> area_key = Nan::New<v8::String>("Area")
+    .ToLocalChecked();
+  v8::Local<v8::String> wordlen_key = Nan::New<v8::String>("WordLen")
+    .ToLocalChecked();
+  v8::Local<v8::String> dbnumber_key = Nan::New<v8::String>("DBNumber")
+    .ToLocalChecked();
+  v8::Local<v8::String> start_key = Nan::New<v8::String>("Start")
+    .ToLocalChecked();
+  v8::Local<v8::String> amount_key = Nan::New<v8::String>("Amount")
+    .ToLocalChecked();
+
+  S7TagSet *tagset = new S7TagSet(s7client, len);
+  PS7DataItem Items = tagset->items;
+  v8::Local<v8::Value> item, area, wordLen, dbNumber, start, amount;
+
+  for (int i = 0; i < len; i++) {
+    item = Nan::Get(data_arr, i).ToLocalChecked();
+    if (!item->IsObject()) {
+      delete tagset;
+      return Nan::ThrowTypeError("Wrong argument structure");
+    }
+
+    v8::Local<v8::Object> data_obj = Nan::To<v8::Object>(item)
+      .ToLocalChecked();
+    area = Nan::Get(data_obj, area_key).ToLocalChecked();
+    wordLen = Nan::Get(data_obj, wordlen_key).ToLocalChecked();
+    dbNumber = Nan::Get(data_obj, dbnumber_key).ToLocalChecked();
+    start = Nan::Get(data_obj, start_key).ToLocalChecked();
+    amount = Nan::Get(data_obj, amount_key).ToLocalChecked();
+    if (!area->IsInt32() || !wordLen->IsInt32() || !start->IsInt32() ||
+        !amount->IsInt32()) {
+      delete tagset;
+      return Nan::ThrowTypeError("Wrong argument structure");
+    }
+
+    Items[i].Area = Nan::To<int32_t>(area).FromJust();
+    Items[i].WordLen = Nan::To<int32_t>(wordLen).FromJust();
+    Items[i].Start = Nan::To<int32_t>(start).FromJust();
+    Items[i].Amount = Nan::To<int32_t>(amount).FromJust();
+    if (Items[i].Area == S7AreaDB) {
+      if (!dbNumber->IsInt32()) {
+        delete tagset;
+        return Nan::ThrowTypeError("Wrong argument structure");
+      }
+      Items[i].DBNumber = Nan::To<int32_t>(dbNumber).FromJust();
+    } else {
+      Items[i].DBNumber = 0;
+    }
+
+    // Counters and timers are always transferred as such
+    if (Items[i].Area == S7AreaCT)
+      Items[i].WordLen = S7WLCounter;
+    else if (Items[i].Area == S7AreaTM)
+      Items[i].WordLen = S7WLTimer;
+
+    int byteCount = S7Client::GetByteCountFromWordLen(Items[i].WordLen);
+    if (byteCount == 0 || Items[i].Start < 0 || Items[i].Amount < 1) {
+      delete tagset;
+      return Nan::ThrowTypeError("Wrong argument structure");
+    }
+    tagset->offsets[i + 1] = tagset->offsets[i] + Items[i].Amount * byteCount;
+  }
+  tagset->data = new char[tagset->offsets[len]];
+
+  v8::Local<v8::Value> argv[1] = { Nan::New<v8::External>(tagset) };
+  v8::Local<v8::Object> tagset_obj = Nan::NewInstance(
+      Nan::GetFunction(Nan::New(S7TagSet::constructor)).ToLocalChecked()
+    , 1, argv).ToLocalChecked();
+  // The client must outlive its tag sets
+  tagset->owner.Reset(info.Holder());
+
+  v8::Local<v8::Array> offsets_arr = Nan::New<v8::Array>(len);
+  for (int i = 0; i < len; i++) {
+    Nan::Set(offsets_arr, i, Nan::New<v8::Integer>(tagset->offsets[i]));
+  }
+  v8::PropertyAttribute attr = static_cast<v8::PropertyAttribute>(
+    v8::ReadOnly | v8::DontDelete);
+  Nan::DefineOwnProperty(tagset_obj, Nan::New<v8::String>("Count")
+    .ToLocalChecked(), Nan::New<v8::Integer>(len), attr);
+  Nan::DefineOwnProperty(tagset_obj, Nan::New<v8::String>("Size")
+    .ToLocalChecked(), Nan::New<v8::Integer>(tagset->offsets[len]), attr);
+  Nan::DefineOwnProperty(tagset_obj, Nan::New<v8::String>("Offsets")
+    .ToLocalChecked(), offsets_arr, attr);
+
+  info.GetReturnValue().Set(tagset_obj);
+}
+
+Nan::Persistent<v8::FunctionTemplate> S7TagSet::constructor;
+
+void S7TagSet::Init() {
+  v8::Local<v8::FunctionTemplate> tpl;
+  tpl = Nan::New<v8::FunctionTemplate>(S7TagSet::New);
+
+  tpl->SetClassName(Nan::New<v8::String>("S7TagSet").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(
+      tpl
+    , "Read"
+    , S7TagSet::Read);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "ReadInto"
+    , S7TagSet::ReadInto);
+  Nan::SetPrototypeMethod(
+      tpl
+    , "Write"
+    , S7TagSet::Write);
+
+  constructor.Reset(tpl);
+}
+
+NAN_METHOD(S7TagSet::New) {
+  // Only built by S7Client.PrepareTagSet()
+  if (!info.IsConstructCall() || !info[0]->IsExternal()) {
+    return Nan::ThrowTypeError("Use S7Client.PrepareTagSet()");
+  }
+
+  S7TagSet *tagset = static_cast<S7TagSet*>(
+    info[0].As<v8::External>()->Value());
+  tagset->Wrap(info.This());
+  info.GetReturnValue().Set(info.This());
+}
+
+S7TagSet::S7TagSet(S7Client *s7client, int count)
+  : s7client(s7client), count(count) {
+  items = new TS7DataItem[count];
+  offsets = new int[count + 1];
+  offsets[0] = 0;
+  data = NULL;
+  busy = false;
+  plan_pdu = -1;
+  read_multi = false;
+  write_first = new int[count + 1];
+  write_chunks = 0;
+}
+
+S7TagSet::~S7TagSet() {
+  delete[] items;
+  delete[] offsets;
+  delete[] write_first;
+  delete[] data;
+  owner.Reset();
+}
+
+// Points the items to their place into the block
+void S7TagSet::Bind(char *block) {
+  for (int i = 0; i < count; i++) {
+    items[i].pdata = block + offsets[i];
+  }
+}
+
+// Telegram sizes, as built by the Snap7 client
+static const int TagReqHeaderSize = 10;  // Request header
+static const int TagResHeaderSize = 12;  // Answer header (with the error)
+static const int TagParamsSize = 2;  // Function and items count
+static const int TagItemParamSize = 12;  // Address of an item
+static const int TagItemDataSize = 4;  // Header of the data of an item
+
+// The PDU is known only once connected, so the telegrams are planned by the
+// first job and again if a new connection negotiates another PDU
+void S7TagSet::Plan(int pdu) {
+  if (pdu == plan_pdu)
+    return;
+  plan_pdu = pdu;
+
+  // The request and the answer of a ReadMultiVars must fit
+  int request = TagReqHeaderSize + TagParamsSize + count * TagItemParamSize;
+  int answer = TagResHeaderSize + TagParamsSize;
+  for (int i = 0; i < count; i++) {
+    int size = offsets[i + 1] - offsets[i];
+    // Odd items are followed by a fill byte, except the last one
+    answer += TagItemDataSize + size + (i < count - 1 ? size % 2 : 0);
+  }
+  read_multi = count <= MaxVars && request <= pdu && answer <= pdu;
+
+  // The items are written in order, as many as fit each telegram
+  int used = 0, items_in = 0;
+  write_chunks = 0;
+  for (int i = 0; i < count; i++) {
+    int size = offsets[i + 1] - offsets[i];
+    int cost = TagItemParamSize + TagItemDataSize + size;
+    if (items_in > 0)
+      cost += (offsets[i] - offsets[i - 1]) % 2;
+    if (items_in == 0 || items_in == MaxVars || used + cost > pdu) {
+      write_first[write_chunks++] = i;
+      used = TagReqHeaderSize + TagParamsSize + TagItemParamSize +
+        TagItemDataSize + size;
+      items_in = 1;
+    } else {
+      used += cost;
+      items_in++;
+    }
+  }
+  write_first[write_chunks] = count;
+}
+
+// A set that fits a telegram is read at once, else it is planned by
+// ReadTagList, which also splits the items bigger than a PDU
+int S7TagSet::ReadItems() {
+  Plan(s7client->snap7Client->PDULength());
+  if (read_multi)
+    return s7client->snap7Client->ReadMultiVars(items, count);
+  return s7client->snap7Client->ReadTagList(items, count);
+}
+
+// Written by the telegrams planned, an item bigger than a PDU by WriteArea
+// (which splits it). It stops at the first telegram that fails, the items
+// left get its error
+int S7TagSet::WriteItems() {
+  int returnValue = 0;
+  int c;
+
+  Plan(s7client->snap7Client->PDULength());
+  for (c = 0; c < write_chunks && returnValue == 0; c++) {
+    PS7DataItem item = &items[write_first[c]];
+    int len = write_first[c + 1] - write_first[c];
+    if (len == 1 && TagReqHeaderSize + TagParamsSize + TagItemParamSize +
+        TagItemDataSize + offsets[write_first[c] + 1] -
+        offsets[write_first[c]] > plan_pdu) {
+      returnValue = s7client->snap7Client->WriteArea(item->Area
+        , item->DBNumber, item->Start, item->Amount, item->WordLen
+        , item->pdata);
+      item->Result = returnValue;
+    } else {
+      returnValue = s7client->snap7Client->WriteMultiVars(item, len);
+    }
+  }
+  for (int i = write_first[c]; returnValue != 0 && i < count; i++) {
+    items[i].Result = returnValue;
+  }
+  return returnValue;
+}
+
+v8::Local<v8::Array> S7TagSet::ResultsToArray(bool read) {
+  Nan::EscapableHandleScope scope;
+
+  v8::Local<v8::Array> res_arr = Nan::New<v8::Array>(count);
+  v8::Local<v8::String> result_key = Nan::New<v8::String>("Result")
+    .ToLocalChecked();
+  v8::Local<v8::String> data_key = Nan::New<v8::String>("Data")
+    .ToLocalChecked();
+  v8::Local<v8::Object> res_obj;
+
+  // The block is copied once, the Data buffers are views of the copy
+  v8::Local<v8::ArrayBuffer> store;
+  size_t base = 0;
+  if (read) {
+    v8::Local<v8::Uint8Array> block = Nan::CopyBuffer(data, offsets[count])
+      .ToLocalChecked().As<v8::Uint8Array>();
+    store = block->Buffer();
+    base = block->ByteOffset();
+  }
+
+  for (int i = 0; i < count; i++) {
+    res_obj = Nan::New<v8::Object>();
+    Nan::Set(res_obj, result_key, Nan::New<v8::Integer>(items[i].Result));
+
+    if (read) {
+      if (items[i].Result == 0) {
+        Nan::Set(res_obj, data_key, node::Buffer::New(
+            v8::Isolate::GetCurrent()
+          , store
+          , base + offsets[i]
+          , offsets[i + 1] - offsets[i]).ToLocalChecked());
+      } else {
+        Nan::Set(res_obj, data_key, Nan::Null());
+      }
+    }
+    Nan::Set(res_arr, i, res_obj);
+  }
+
+  return scope.Escape(res_arr);
+}
+
+v8::Local<v8::Object> S7TagSet::ResultsToPacked() {
+  Nan::EscapableHandleScope scope;
+
+  v8::Local<v8::Int32Array> layout = S7Client::NewItemsLayout(count);
+  Nan::TypedArrayContents<int32_t> contents(layout);
+  S7Client::PackItems(items, count, data, *contents);
+
+  v8::Local<v8::Object> res_obj = Nan::New<v8::Object>();
+  Nan::Set(res_obj, Nan::New<v8::String>("Data").ToLocalChecked()
+    , Nan::CopyBuffer(data, offsets[count]).ToLocalChecked());
+  Nan::Set(res_obj, Nan::New<v8::String>("Items").ToLocalChecked(), layout);
+
+  return scope.Escape(res_obj);
+}
+
+NAN_METHOD(S7TagSet::Read) {
+  S7TagSet *tagset = ObjectWrap::Unwrap<S7TagSet>(info.Holder());
+
+  if (tagset->busy) {
+    return Nan::ThrowError("A job of this tag set is still pending");
+  }
+
+  // An optional boolean asks for the packed result
+  bool packed = false;
+  int cb_index = 0;
+  if (info[0]->IsBoolean()) {
+    packed = Nan::To<bool>(info[0]).FromJust();
+    cb_index = 1;
+  }
+
+  tagset->Bind(tagset->data);
+  if (!info[cb_index]->IsFunction()) {
+    SyncCall sync(tagset->s7client);
+    if (tagset->ReadItems() != 0) {
+      info.GetReturnValue().Set(Nan::False());
+    } else if (packed) {
+      info.GetReturnValue().Set(tagset->ResultsToPacked());
+    } else {
+      info.GetReturnValue().Set(tagset->ResultsToArray(true));
+    }
+  } else {
+    Nan::Callback *callback = new Nan::Callback(
+      info[cb_index].As<v8::Function>());
+    IOWorker *worker = new IOWorker(callback, tagset->s7client, TAGSETREAD
+      , tagset, packed ? LAYOUT_PACKED : LAYOUT_OBJECTS);
+    worker->SaveToPersistent("tagSet", info.Holder());
+    tagset->busy = true;
+    tagset->s7client->QueueWorker(worker);
+    info.GetReturnValue().SetUndefined();
+  }
+}
+
+NAN_METHOD(S7TagSet::ReadInto) {
+  S7TagSet *tagset = ObjectWrap::Unwrap<S7TagSet>(info.Holder());
+
+  if (info.Length() < 1) {
+    return Nan::ThrowTypeError("Wrong number of arguments");
+  }
+
+  if (!node::Buffer::HasInstance(info[0])) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  if (static_cast<int>(node::Buffer::Length(info[0].As<v8::Object>())) <
+      tagset->offsets[tagset->count]) {
+    return Nan::ThrowTypeError("Buffer is smaller than the tag set");
+  }
+
+  // The layout can be given as well, so that nothing is allocated
+  v8::Local<v8::Value> layout;
+  int cb_index = 1;
+  if (info[1]->IsInt32Array()) {
+    if (static_cast<int>(info[1].As<v8::Int32Array>()->Length()) <
+        tagset->count * 2 + 1) {
+      return Nan::ThrowTypeError("Int32Array is smaller than the layout");
+    }
+    layout = info[1];
+    cb_index = 2;
+  } else {
+    layout = S7Client::NewItemsLayout(tagset->count);
+  }
+
+  if (tagset->busy) {
+    return Nan::ThrowError("A job of this tag set is still pending");
+  }
+
+  // The data are read straight into the caller's buffer
+  char *block = node::Buffer::Data(info[0].As<v8::Object>());
+  tagset->Bind(block);
+  if (!info[cb_index]->IsFunction()) {
+    SyncCall sync(tagset->s7client);
+    if (tagset->ReadItems() == 0) {
+      Nan::TypedArrayContents<int32_t> contents(layout);
+      S7Client::PackItems(tagset->items, tagset->count, block, *contents);
+      info.GetReturnValue().Set(layout);
+    } else {
+      info.GetReturnValue().Set(Nan::False());
+    }
+  } else {
+    Nan::Callback *callback = new Nan::Callback(
+      info[cb_index].As<v8::Function>());
+    IOWorker *worker = new IOWorker(callback, tagset->s7client, TAGSETREAD
+      , tagset, LAYOUT_INTO);
+    worker->SaveToPersistent("tagSet", info.Holder());
+    worker->SaveToPersistent("buffer", info[0]);
+    worker->SaveToPersistent("layout", layout);
+    tagset->busy = true;
+    tagset->s7client->QueueWorker(worker);
+    info.GetReturnValue().SetUndefined();
+  }
+}
+
+NAN_METHOD(S7TagSet::Write) {
+  S7TagSet *tagset = ObjectWrap::Unwrap<S7TagSet>(info.Holder());
+
+  if (info.Length() < 1) {
+    return Nan::ThrowTypeError("Wrong number of arguments");
+  }
+
+  if (!node::Buffer::HasInstance(info[0])) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  if (static_cast<int>(node::Buffer::Length(info[0].As<v8::Object>())) <
+      tagset->offsets[tagset->count]) {
+    return Nan::ThrowTypeError("Buffer is smaller than the tag set");
+  }
+
+  if (tagset->busy) {
+    return Nan::ThrowError("A job of this tag set is still pending");
+  }
+
+  // The data are written straight from the caller's buffer
+  tagset->Bind(node::Buffer::Data(info[0].As<v8::Object>()));
+  if (!info[1]->IsFunction()) {
+    SyncCall sync(tagset->s7client);
+    if (tagset->WriteItems() == 0) {
+      info.GetReturnValue().Set(tagset->ResultsToArray(false));
+    } else {
+      info.GetReturnValue().Set(Nan::False());
+    }
+  } else {
+    Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+    IOWorker *worker = new IOWorker(callback, tagset->s7client, TAGSETWRITE
+      , tagset);
+    worker->SaveToPersistent("tagSet", info.Holder());
+    worker->SaveToPersistent("buffer", info[0]);
+    tagset->busy = true;
+    tagset->s7client->QueueWorker(worker);
+    info.GetReturnValue().SetUndefined();
+  }
+}
+
 // Directory functions
 NAN_METHOD(S7Client::ListBlocks) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   PS7BlocksList BlocksList = new TS7BlocksList;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->ListBlocks(BlocksList);
 
     v8::Local<v8::Object> blocks_list = s7client->S7BlocksListToObject(
@@ -1557,7 +2843,7 @@ NAN_METHOD(S7Client::ListBlocks) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, LISTBLOCKS
+    s7client->QueueWorker(new IOWorker(callback, s7client, LISTBLOCKS
       , BlocksList));
     info.GetReturnValue().SetUndefined();
   }
@@ -1597,6 +2883,7 @@ NAN_METHOD(S7Client::GetAgBlockInfo) {
 
   PS7BlockInfo BlockInfo = new TS7BlockInfo;
   if (!info[2]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetAgBlockInfo(
 		Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), BlockInfo);
 
@@ -1612,7 +2899,7 @@ NAN_METHOD(S7Client::GetAgBlockInfo) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETAGBLOCKINFO
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETAGBLOCKINFO
       , BlockInfo, Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
@@ -1689,6 +2976,7 @@ NAN_METHOD(S7Client::ListBlocksOfType) {
   int BlockNum = sizeof(TS7BlocksOfType) / sizeof(PS7BlocksOfType);
   PS7BlocksOfType BlockList = new TS7BlocksOfType[BlockNum];
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->ListBlocksOfType(
 		Nan::To<int32_t>(info[0]).FromJust(), BlockList, &BlockNum);
 
@@ -1703,7 +2991,7 @@ NAN_METHOD(S7Client::ListBlocksOfType) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, LISTBLOCKSOFTYPE
+    s7client->QueueWorker(new IOWorker(callback, s7client, LISTBLOCKSOFTYPE
       , BlockList, Nan::To<int32_t>(info[0]).FromJust(), BlockNum));
     info.GetReturnValue().SetUndefined();
   }
@@ -1734,6 +3022,7 @@ NAN_METHOD(S7Client::Upload) {
   char *bufferData = new char[Nan::To<int32_t>(info[2]).FromJust()];
   int size = Nan::To<int32_t>(info[2]).FromJust();
   if (!info[3]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->Upload(
 		Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), bufferData, &size);
 
@@ -1751,7 +3040,7 @@ NAN_METHOD(S7Client::Upload) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[3].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, UPLOAD
+    s7client->QueueWorker(new IOWorker(callback, s7client, UPLOAD
       , bufferData, Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), size));
     info.GetReturnValue().SetUndefined();
   }
@@ -1767,6 +3056,7 @@ NAN_METHOD(S7Client::FullUpload) {
   int size = Nan::To<int32_t>(info[2]).FromJust();
   char *bufferData = new char[size];
   if (!info[3]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->FullUpload(
 		Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), bufferData, &size);
 
@@ -1784,7 +3074,7 @@ NAN_METHOD(S7Client::FullUpload) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[3].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, FULLUPLOAD
+    s7client->QueueWorker(new IOWorker(callback, s7client, FULLUPLOAD
       , bufferData, Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), size));
     info.GetReturnValue().SetUndefined();
   }
@@ -1798,12 +3088,13 @@ NAN_METHOD(S7Client::Download) {
   }
 
   if (!info[2]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(s7client->snap7Client->Download(
 		Nan::To<int32_t>(info[0]).FromJust(), node::Buffer::Data(info[1].As<v8::Object>())
       , static_cast<int>(node::Buffer::Length(info[1].As<v8::Object>()))) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, DOWNLOAD
+    s7client->QueueWorker(new IOWorker(callback, s7client, DOWNLOAD
       , node::Buffer::Data(info[1].As<v8::Object>()), Nan::To<int32_t>(info[0]).FromJust()
       , static_cast<int>(node::Buffer::Length(info[1].As<v8::Object>()))));
     info.GetReturnValue().SetUndefined();
@@ -1818,11 +3109,12 @@ NAN_METHOD(S7Client::Delete) {
   }
 
   if (!info[2]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(s7client->snap7Client->Delete(
 		Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, DELETEBLOCK
+    s7client->QueueWorker(new IOWorker(callback, s7client, DELETEBLOCK
       , Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
@@ -1838,6 +3130,7 @@ NAN_METHOD(S7Client::DBGet) {
   int size = 65536;
   char *bufferData = new char[size];
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->DBGet(
 		Nan::To<int32_t>(info[0]).FromJust(), bufferData, &size);
 
@@ -1855,7 +3148,7 @@ NAN_METHOD(S7Client::DBGet) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, DBGET
+    s7client->QueueWorker(new IOWorker(callback, s7client, DBGET
       , bufferData, Nan::To<int32_t>(info[0]).FromJust(), size));
     info.GetReturnValue().SetUndefined();
   }
@@ -1877,11 +3170,12 @@ NAN_METHOD(S7Client::DBFill) {
   }
 
   if (!info[2]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(s7client->snap7Client->DBFill(
 		Nan::To<int32_t>(info[0]).FromJust(), fill) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, DBFILL
+    s7client->QueueWorker(new IOWorker(callback, s7client, DBFILL
       , Nan::To<int32_t>(info[0]).FromJust(), fill));
     info.GetReturnValue().SetUndefined();
   }
@@ -1893,6 +3187,7 @@ NAN_METHOD(S7Client::GetPlcDateTime) {
 
   tm *DateTime = new tm;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetPlcDateTime(DateTime);
     double timestamp = static_cast<double>(mktime(DateTime));
     delete DateTime;
@@ -1903,7 +3198,7 @@ NAN_METHOD(S7Client::GetPlcDateTime) {
       info.GetReturnValue().Set(Nan::False());
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETPLCDATETIME
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETPLCDATETIME
       , DateTime));
     info.GetReturnValue().SetUndefined();
   }
@@ -1938,13 +3233,14 @@ NAN_METHOD(S7Client::SetPlcDateTime) {
   }
 
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     v8::Local<v8::Boolean> ret = Nan::New<v8::Boolean>(
       s7client->snap7Client->SetPlcDateTime(DateTime) == 0);
     delete DateTime;
     info.GetReturnValue().Set(ret);
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, SETPLCDATETIME
+    s7client->QueueWorker(new IOWorker(callback, s7client, SETPLCDATETIME
       , DateTime));
     info.GetReturnValue().SetUndefined();
   }
@@ -1954,11 +3250,12 @@ NAN_METHOD(S7Client::SetPlcSystemDateTime) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->SetPlcSystemDateTime() == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, SETPLCSYSTEMDATETIME));
+    s7client->QueueWorker(new IOWorker(callback, s7client, SETPLCSYSTEMDATETIME));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -1969,6 +3266,7 @@ NAN_METHOD(S7Client::GetOrderCode) {
 
   PS7OrderCode OrderCode = new TS7OrderCode;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetOrderCode(OrderCode);
 
     if (returnValue == 0) {
@@ -1981,7 +3279,7 @@ NAN_METHOD(S7Client::GetOrderCode) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETORDERCODE
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETORDERCODE
       , OrderCode));
     info.GetReturnValue().SetUndefined();
   }
@@ -2009,6 +3307,7 @@ NAN_METHOD(S7Client::GetCpuInfo) {
 
   PS7CpuInfo CpuInfo = new TS7CpuInfo;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetCpuInfo(CpuInfo);
 
     if (returnValue == 0) {
@@ -2021,7 +3320,7 @@ NAN_METHOD(S7Client::GetCpuInfo) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETCPUINFO, CpuInfo));
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETCPUINFO, CpuInfo));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2050,6 +3349,7 @@ NAN_METHOD(S7Client::GetCpInfo) {
 
   PS7CpInfo CpInfo = new TS7CpInfo;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetCpInfo(CpInfo);
 
     if (returnValue == 0) {
@@ -2062,7 +3362,7 @@ NAN_METHOD(S7Client::GetCpInfo) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETCPINFO, CpInfo));
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETCPINFO, CpInfo));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2093,6 +3393,7 @@ NAN_METHOD(S7Client::ReadSZL) {
   PS7SZL SZL = new TS7SZL;
   int size = sizeof(TS7SZL);
   if (!info[2]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->ReadSZL(Nan::To<int32_t>(info[0]).FromJust()
       , Nan::To<int32_t>(info[1]).FromJust(), SZL, &size);
 
@@ -2111,7 +3412,7 @@ NAN_METHOD(S7Client::ReadSZL) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, READSZL, SZL
+    s7client->QueueWorker(new IOWorker(callback, s7client, READSZL, SZL
       , Nan::To<int32_t>(info[0]).FromJust(), Nan::To<int32_t>(info[1]).FromJust(), size));
     info.GetReturnValue().SetUndefined();
   }
@@ -2123,6 +3424,7 @@ NAN_METHOD(S7Client::ReadSZLList) {
   PS7SZLList SZLList = new TS7SZLList;
   int size = sizeof(TS7SZLList);
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->ReadSZLList(SZLList, &size);
 
     if (returnValue == 0) {
@@ -2136,7 +3438,7 @@ NAN_METHOD(S7Client::ReadSZLList) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, READSZLLIST, SZLList
+    s7client->QueueWorker(new IOWorker(callback, s7client, READSZLLIST, SZLList
       , size));
     info.GetReturnValue().SetUndefined();
   }
@@ -2158,11 +3460,12 @@ NAN_METHOD(S7Client::PlcHotStart) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->PlcHotStart() == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, PLCHOTSTART));
+    s7client->QueueWorker(new IOWorker(callback, s7client, PLCHOTSTART));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2171,11 +3474,12 @@ NAN_METHOD(S7Client::PlcColdStart) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->PlcColdStart() == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, PLCCOLDSTART));
+    s7client->QueueWorker(new IOWorker(callback, s7client, PLCCOLDSTART));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2184,11 +3488,12 @@ NAN_METHOD(S7Client::PlcStop) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->PlcStop() == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, PLCSTOP));
+    s7client->QueueWorker(new IOWorker(callback, s7client, PLCSTOP));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2201,11 +3506,12 @@ NAN_METHOD(S7Client::CopyRamToRom) {
   }
 
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->CopyRamToRom(Nan::To<int32_t>(info[0]).FromJust()) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, COPYRAMTOROM
+    s7client->QueueWorker(new IOWorker(callback, s7client, COPYRAMTOROM
       , Nan::To<int32_t>(info[0]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
@@ -2219,11 +3525,12 @@ NAN_METHOD(S7Client::Compress) {
   }
 
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->Compress(Nan::To<int32_t>(info[0]).FromJust()) == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, COMPRESS
+    s7client->QueueWorker(new IOWorker(callback, s7client, COMPRESS
       , Nan::To<int32_t>(info[0]).FromJust()));
     info.GetReturnValue().SetUndefined();
   }
@@ -2235,6 +3542,7 @@ NAN_METHOD(S7Client::GetProtection) {
 
   PS7Protection S7Protection = new TS7Protection;
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->GetProtection(S7Protection);
 
     if (returnValue == 0) {
@@ -2248,7 +3556,7 @@ NAN_METHOD(S7Client::GetProtection) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, GETPROTECTION
+    s7client->QueueWorker(new IOWorker(callback, s7client, GETPROTECTION
       , S7Protection));
     info.GetReturnValue().SetUndefined();
   }
@@ -2283,13 +3591,14 @@ NAN_METHOD(S7Client::SetSessionPassword) {
 
   Nan::Utf8String *password = new Nan::Utf8String(info[0]);
   if (!info[1]->IsFunction()) {
+    SyncCall sync(s7client);
     v8::Local<v8::Boolean> ret = Nan::New<v8::Boolean>(
       s7client->snap7Client->SetSessionPassword(**password) == 0);
     delete password;
     info.GetReturnValue().Set(ret);
   } else {
     Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, SETSESSIONPW
+    s7client->QueueWorker(new IOWorker(callback, s7client, SETSESSIONPW
       , password));
     info.GetReturnValue().SetUndefined();
   }
@@ -2299,11 +3608,12 @@ NAN_METHOD(S7Client::ClearSessionPassword) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     info.GetReturnValue().Set(Nan::New<v8::Boolean>(
       s7client->snap7Client->ClearSessionPassword() == 0));
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, CLEARSESSIONPW));
+    s7client->QueueWorker(new IOWorker(callback, s7client, CLEARSESSIONPW));
     info.GetReturnValue().SetUndefined();
   }
 }
@@ -2320,6 +3630,33 @@ NAN_METHOD(S7Client::ExecTime) {
   }
 }
 
+NAN_METHOD(S7Client::GetQueueStats) {
+  S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
+
+  // One entry for each priority class, times in ms
+  v8::Local<v8::Array> stats_arr = Nan::New<v8::Array>(PRIORITY_CLASSES);
+  for (int i = 0; i < PRIORITY_CLASSES; i++) {
+    JobQueueStats &stats = s7client->queue_stats[i];
+    uint64_t executed = stats.executed;
+    double wait_total = static_cast<double>(stats.wait_total) / 1e6;
+
+    v8::Local<v8::Object> stats_obj = Nan::New<v8::Object>();
+    Nan::Set(stats_obj, Nan::New<v8::String>("Queued").ToLocalChecked()
+      , Nan::New<v8::Integer>(stats.queued));
+    Nan::Set(stats_obj, Nan::New<v8::String>("Executed").ToLocalChecked()
+      , Nan::New<v8::Number>(static_cast<double>(executed)));
+    Nan::Set(stats_obj, Nan::New<v8::String>("AvgWait").ToLocalChecked()
+      , Nan::New<v8::Number>(executed > 0 ? wait_total / executed : 0));
+    Nan::Set(stats_obj, Nan::New<v8::String>("MaxWait").ToLocalChecked()
+      , Nan::New<v8::Number>(static_cast<double>(stats.wait_max) / 1e6));
+    Nan::Set(stats_obj, Nan::New<v8::String>("Shared").ToLocalChecked()
+      , Nan::New<v8::Number>(static_cast<double>(stats.shared)));
+    Nan::Set(stats_arr, i, stats_obj);
+  }
+
+  info.GetReturnValue().Set(stats_arr);
+}
+
 NAN_METHOD(S7Client::LastError) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
@@ -2353,6 +3690,7 @@ NAN_METHOD(S7Client::PlcStatus) {
   S7Client *s7client = ObjectWrap::Unwrap<S7Client>(info.Holder());
 
   if (!info[0]->IsFunction()) {
+    SyncCall sync(s7client);
     int returnValue = s7client->snap7Client->PlcStatus();
     if ((returnValue == S7CpuStatusUnknown) ||
         (returnValue == S7CpuStatusStop) ||
@@ -2363,7 +3701,7 @@ NAN_METHOD(S7Client::PlcStatus) {
     }
   } else {
     Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
-    Nan::AsyncQueueWorker(new IOWorker(callback, s7client, PLCSTATUS));
+    s7client->QueueWorker(new IOWorker(callback, s7client, PLCSTATUS));
     info.GetReturnValue().SetUndefined();
   }
 }
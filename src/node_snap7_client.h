@@ -9,6 +9,7 @@
 #include <snap7.h>
 #include <node.h>
 #include <nan.h>
+#include <atomic>
 
 namespace node_snap7 {
 
@@ -18,9 +19,38 @@ enum DataIOFunction { READAREA = 1, WRITEAREA, READMULTI, WRITEMULTI
   , SETPLCSYSTEMDATETIME, GETPLCDATETIME, COMPRESS, COPYRAMTOROM
   , SETPLCDATETIME, DBFILL, DBGET, DELETEBLOCK, DOWNLOAD, FULLUPLOAD
   , UPLOAD, LISTBLOCKSOFTYPE, GETAGBLOCKINFO, LISTBLOCKS, CONNECT
-  , CONNECTTO, READSZLLIST, READSZL
+  , CONNECTTO, READSZLLIST, READSZL, READTAGLIST, SUBSCRIBECYCLIC
+  , UNSUBSCRIBECYCLIC, CHECKCYCLIC, TAGSETREAD, TAGSETWRITE, READAREAINTO
 };
 
+// Priority classes of the async jobs : the most urgent class runs first,
+// the jobs of the same class run in submission order
+enum JobPriority { PRIORITY_CONTROL = 0, PRIORITY_INTERACTIVE, PRIORITY_BULK
+  , PRIORITY_CLASSES
+};
+
+// Result of a multi-variable read : an array of {Result, Data} objects, or
+// the data of all the items in one buffer described by an Int32Array
+enum ResultLayout { LAYOUT_OBJECTS = 0, LAYOUT_PACKED, LAYOUT_INTO };
+
+// Queue statistics of a priority class, times in ns
+struct JobQueueStats {
+  std::atomic<int> queued;  // Submitted, not started yet
+  std::atomic<uint64_t> executed;
+  std::atomic<uint64_t> wait_total;
+  std::atomic<uint64_t> wait_max;
+  std::atomic<uint64_t> shared;  // Answered by an identical/wider read
+};
+
+// A cyclic data subscription, or a snapshot of its data
+struct CyclicJob {
+  int JobID;
+  int Count;
+  PS7DataItem Items;
+};
+
+class IOWorker;
+
 class S7Client : public Nan::ObjectWrap {
  public:
   S7Client();
@@ -36,9 +66,15 @@ class S7Client : public Nan::ObjectWrap {
   static NAN_METHOD(SetParam);
   // Data I/O Main functions
   static NAN_METHOD(ReadArea);
+  static NAN_METHOD(ReadAreaInto);
   static NAN_METHOD(WriteArea);
   static NAN_METHOD(ReadMultiVars);
+  static NAN_METHOD(ReadTagList);
   static NAN_METHOD(WriteMultiVars);
+  static NAN_METHOD(PrepareTagSet);
+  // Cyclic data functions
+  static NAN_METHOD(SubscribeCyclic);
+  static NAN_METHOD(UnsubscribeCyclic);
   // Directory functions
   static NAN_METHOD(ListBlocks);
   static NAN_METHOD(GetAgBlockInfo);
@@ -78,12 +114,19 @@ class S7Client : public Nan::ObjectWrap {
   static NAN_METHOD(PDULength);
   static NAN_METHOD(PlcStatus);
   static NAN_METHOD(Connected);
+  static NAN_METHOD(GetQueueStats);
 
   static NAN_METHOD(ErrorText);
   // Internal Helper functions
   static int GetByteCountFromWordLen(int WordLen);
+  static void ReadItems(const Nan::FunctionCallbackInfo<v8::Value>& info
+    , DataIOFunction func);
   v8::Local<v8::Array> S7DataItemToArray(PS7DataItem Items, int len
     , bool readMulti);
+  v8::Local<v8::Object> S7DataItemToPacked(PS7DataItem Items, int len);
+  static v8::Local<v8::Int32Array> NewItemsLayout(int len);
+  static void PackItems(PS7DataItem Items, int len, char *base
+    , int32_t *layout);
   v8::Local<v8::Object> S7ProtectionToObject(PS7Protection S7Protection);
   v8::Local<v8::Object> S7CpInfoToObject(PS7CpInfo CpInfo);
   v8::Local<v8::Object> S7CpuInfoToObject(PS7CpuInfo CpuInfo);
@@ -94,18 +137,125 @@ class S7Client : public Nan::ObjectWrap {
     , int count);
   v8::Local<v8::Array> S7SZLListToArray(PS7SZLList SZLList, int count);
 
+  static PS7DataItem CopyDataItems(PS7DataItem Items, int len);
+  static void FreeDataItems(PS7DataItem Items, int len);
+
   static void FreeCallback(char *data, void* hint);
   static void FreeCallbackSZL(char *data, void* hint);
 
+  // Async jobs are executed by the client's own I/O thread, by priority
+  void QueueWorker(IOWorker *worker);
+  static JobPriority PriorityOf(DataIOFunction caller);
 
-  uv_mutex_t mutex;
   TS7Client *snap7Client;
 
+  // Cyclic subscriptions, owned by the I/O thread
+  CyclicJob cyclic_jobs[MaxCyclicJobs];
+  std::atomic<bool> cyclic_reset;
+  void ClearCyclicJobs();
+
  private:
+  friend class IOWorker;
+  friend class SyncCall;
   ~S7Client();
+  static void IOThread(void *arg);
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+  static void HandleCompletion(uv_async_t* handle);
+#else
+  static void HandleCompletion(uv_async_t* handle, int status);
+#endif
+  static void CloseCallback(uv_handle_t* handle);
+  static void HandleCyclicPoll(uv_poll_t* handle, int status, int events);
+  static void ClosePollCallback(uv_handle_t* handle);
+  void OpenCyclicPoll();
+  void CloseCyclicPoll();
+  void DropCyclicJobs();
+  void QueueCyclicCheck();
+  static void PushWorker(std::atomic<IOWorker*> *list, IOWorker *worker);
+  static IOWorker *TakeWorkers(std::atomic<IOWorker*> *list);
+  void SortWorkers();
+  IOWorker *NextWorker();
+  IOWorker *ShareRead(IOWorker *reader);
+
+  // Lock-free LIFO lists, drained in FIFO order by their consumer
+  std::atomic<IOWorker*> submitted;
+  std::atomic<IOWorker*> completed;
+  // Submitted jobs sorted by class, owned by the I/O thread
+  IOWorker *ready_head[PRIORITY_CLASSES];
+  IOWorker *ready_tail[PRIORITY_CLASSES];
+  JobQueueStats queue_stats[PRIORITY_CLASSES];
+  std::atomic<bool> io_thread_stop;
+  bool io_thread_started;
+  uv_thread_t io_thread;
+  uv_sem_t io_sem;
+  // Held by the I/O thread for each job and by the blocking calls : one
+  // thread at a time drives the connection
+  uv_mutex_t io_mutex;
+  uv_async_t *completion_async;
+  int pending;
+
+  // Pushed data are collected by a CHECKCYCLIC job, queued when the socket
+  // is readable while the client is idle or after any other job
+  uv_poll_t *cyclic_poll;
+  bool cyclic_polling;
+  bool cyclic_checking;
+  bool cyclic_failed;
+  int cyclic_count;
+
   static Nan::Persistent<v8::FunctionTemplate> constructor;
 };
 
+// Scope of a blocking call : it waits for the job the I/O thread is
+// executing, and the I/O thread waits for it
+class SyncCall {
+ public:
+  explicit SyncCall(S7Client *s7client);
+  ~SyncCall();
+
+ private:
+  S7Client *s7client;
+};
+
+// A list of variables validated once, read or written as a whole : the
+// items are laid out back to back into a single data block
+class S7TagSet : public Nan::ObjectWrap {
+ public:
+  S7TagSet(S7Client *s7client, int count);
+  static void Init();
+  static NAN_METHOD(New);
+  static NAN_METHOD(Read);
+  static NAN_METHOD(ReadInto);
+  static NAN_METHOD(Write);
+
+  // Called by the I/O thread, or by the JS thread if blocking
+  int ReadItems();
+  int WriteItems();
+  v8::Local<v8::Array> ResultsToArray(bool read);
+  v8::Local<v8::Object> ResultsToPacked();
+  void Bind(char *block);
+  void Plan(int pdu);
+
+  S7Client *s7client;
+  PS7DataItem items;
+  int count;
+  int *offsets;  // count + 1 offsets, the last one is the size
+  char *data;
+  bool busy;  // A job is queued, one at a time
+
+  // Telegrams planned for the PDU negotiated
+  int plan_pdu;
+  bool read_multi;  // The whole set fits a ReadMultiVars telegram
+  int *write_first;  // First item of each write telegram, then count
+  int write_chunks;
+  Nan::Persistent<v8::Object> owner;
+
+  static Nan::Persistent<v8::FunctionTemplate> constructor;
+
+ private:
+  friend class S7Client;
+  ~S7TagSet();
+};
+
 class IOWorker : public Nan::AsyncWorker {
  public:
   // No args
@@ -148,11 +298,15 @@ class IOWorker : public Nan::AsyncWorker {
   ~IOWorker() {}
 
  private:
+  friend class S7Client;
   void Execute();
   void HandleOKCallback();
 
+  IOWorker *next;
   S7Client *s7client;
   DataIOFunction caller;
+  JobPriority priority;
+  uint64_t submit_time;
   void *pData;
   int int1, int2, int3, int4, int5, returnValue;
 };
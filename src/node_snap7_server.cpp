@@ -7,47 +7,117 @@
 
 namespace node_snap7 {
 
-static uv_async_t event_async_g;
-static uv_async_t rw_async_g;
-static uv_mutex_t mutex_rw;
-static uv_mutex_t mutex_event;
-static uv_sem_t sem_rw;
-static std::deque<TSrvEvent> event_list_g;
-
-static struct rw_event_baton_t {
-  int Sender;
-  int Operation;
-  TS7Tag Tag;
-  void *pUsrData;
-} rw_event_baton_g;
-
-void S7API EventCallBack(void *usrPtr, PSrvEvent PEvent, int Size) {
-  uv_mutex_lock(&mutex_event);
-  event_list_g.push_back(*PEvent);
-  uv_mutex_unlock(&mutex_event);
-
-  uv_async_send(&event_async_g);
+// The event is already in the server's lock-free queue (the log mask
+// follows the events mask), just wake up the loop to drain it. Thread safe,
+// so the workers call it concurrently (p_i32_EventsConcurrent)
+void S7API EventCallBack(void *usrPtr, PSrvEvent, int) {
+  uv_async_send(static_cast<S7Server*>(usrPtr)->event_async);
+}
+
+void S7API ChangesCallBack(void *usrPtr) {
+  uv_async_send(static_cast<S7Server*>(usrPtr)->changes_async);
+}
+
+// Called concurrently by the server workers (p_i32_RWAreaConcurrent), every
+// worker queues its own request and waits for its own answer
+static int QueueRWRequest(S7Server *s7server, TRWRequest &request) {
+  request.done = false;
+  request.result = 0;
+
+  uv_mutex_lock(&s7server->mutex_rw);
+  if (s7server->rw_closing) {
+    uv_mutex_unlock(&s7server->mutex_rw);
+    return -1;
+  }
+  request.id = s7server->rw_next_id++;
+  s7server->rw_pending[request.id] = &request;
+  s7server->rw_queue.push_back(request.id);
+  uv_async_send(s7server->rw_async);
+
+  while (!request.done) {
+    uv_cond_wait(&s7server->cond_rw, &s7server->mutex_rw);
+  }
+  uv_mutex_unlock(&s7server->mutex_rw);
+
+  return request.result;
 }
 
 int S7API RWAreaCallBack(void *usrPtr, int Sender, int Operation, PS7Tag PTag
   , void *pUsrData
 ) {
-  uv_mutex_lock(&mutex_rw);
-  rw_event_baton_g.Sender = Sender;
-  rw_event_baton_g.Operation = Operation;
-  rw_event_baton_g.Tag = *PTag;
-  rw_event_baton_g.pUsrData = pUsrData;
+  TRWRequest request;
+  request.Sender = Sender;
+  request.Operation = Operation;
+  request.Tag = *PTag;
+  request.pUsrData = pUsrData;
+  request.Items = NULL;
+  request.ItemsCount = 0;
+
+  return QueueRWRequest(static_cast<S7Server*>(usrPtr), request);
+}
 
-  uv_async_send(&rw_async_g);
+int S7API RWAreaBatchCallBack(void *usrPtr, int Sender, int Operation
+  , PSrvRWItem Items, int ItemsCount
+) {
+  TRWRequest request;
+  request.Sender = Sender;
+  request.Operation = Operation;
+  request.pUsrData = NULL;
+  request.Items = Items;
+  request.ItemsCount = ItemsCount;
+
+  return QueueRWRequest(static_cast<S7Server*>(usrPtr), request);
+}
 
-  uv_sem_wait(&sem_rw);
-  uv_mutex_unlock(&mutex_rw);
+static v8::Local<v8::Object> NewTagObject(const TS7Tag &Tag) {
+  v8::Local<v8::Object> rw_tag_obj = Nan::New<v8::Object>();
+  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Area").ToLocalChecked()
+    , Nan::New<v8::Integer>(Tag.Area));
+  Nan::Set(rw_tag_obj, Nan::New<v8::String>("DBNumber").ToLocalChecked()
+    , Nan::New<v8::Integer>(Tag.DBNumber));
+  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Start").ToLocalChecked()
+    , Nan::New<v8::Integer>(Tag.Start));
+  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Size").ToLocalChecked()
+    , Nan::New<v8::Integer>(Tag.Size));
+  Nan::Set(rw_tag_obj, Nan::New<v8::String>("WordLen").ToLocalChecked()
+    , Nan::New<v8::Integer>(Tag.WordLen));
+  return rw_tag_obj;
+}
+
+static void FreeAsync(uv_handle_t *handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
 
-  return 0;
+static void FreeTimer(uv_handle_t *handle) {
+  delete reinterpret_cast<uv_timer_t*>(handle);
 }
 
 Nan::Persistent<v8::FunctionTemplate> S7Server::constructor;
 
+static void FreeBufferInfo(TBufferInfo &bufferInfo) {
+  if (bufferInfo.pinned != NULL) {
+    bufferInfo.pinned->Reset();
+    delete bufferInfo.pinned;
+#if V8_MAJOR_VERSION >= 8
+    bufferInfo.store.reset();
+#endif
+  } else {
+    delete[] bufferInfo.pBuffer;
+  }
+  delete[] bufferInfo.pBack;
+}
+
+// LockArea() was called by the JS thread itself for this area
+static bool LockedByUs(S7Server *s7server, int area, int index) {
+  std::map<int, std::map<int, TBufferInfo> >::iterator it =
+    s7server->area2buffer.find(area);
+  if (it == s7server->area2buffer.end()) {
+    return false;
+  }
+  std::map<int, TBufferInfo>::iterator entry = it->second.find(index);
+  return entry != it->second.end() && entry->second.locked;
+}
+
 NAN_MODULE_INIT(S7Server::Init) {
   Nan::HandleScope scope;
 
@@ -85,6 +155,18 @@ NAN_MODULE_INIT(S7Server::Init) {
     tpl
     , "SetResourceless"
     , S7Server::SetResourceless);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "SetEventsBatch"
+    , S7Server::SetEventsBatch);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "SetEventFilters"
+    , S7Server::SetEventFilters);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "SetEventsAggregate"
+    , S7Server::SetEventsAggregate);
   Nan::SetPrototypeMethod(
     tpl
     , "RegisterArea"
@@ -93,6 +175,10 @@ NAN_MODULE_INIT(S7Server::Init) {
     tpl
     , "UnregisterArea"
     , S7Server::UnregisterArea);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "InvalidateCache"
+    , S7Server::InvalidateCache);
   Nan::SetPrototypeMethod(
     tpl
     , "LockArea"
@@ -105,10 +191,18 @@ NAN_MODULE_INIT(S7Server::Init) {
     tpl
     , "SetArea"
     , S7Server::SetArea);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "PublishArea"
+    , S7Server::PublishArea);
   Nan::SetPrototypeMethod(
     tpl
     , "GetArea"
     , S7Server::GetArea);
+  Nan::SetPrototypeMethod(
+    tpl
+    , "GetAreaInto"
+    , S7Server::GetAreaInto);
   Nan::SetPrototypeMethod(
     tpl
     , "SetEventMask"
@@ -340,6 +434,11 @@ NAN_MODULE_INIT(S7Server::Init) {
     , Nan::New<v8::String>("evcControl").ToLocalChecked()
     , Nan::New<v8::Uint32>(evcControl)
     , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("evcCyclicData").ToLocalChecked()
+    , Nan::New<v8::Uint32>(evcCyclicData)
+    , v8::ReadOnly);
 
   // Masks to enable/disable all events
   Nan::SetPrototypeTemplate(
@@ -409,6 +508,16 @@ NAN_MODULE_INIT(S7Server::Init) {
     , Nan::New<v8::String>("evsClrPassword").ToLocalChecked()
     , Nan::New<v8::Integer>(evsClrPassword)
     , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("evsCyclicSubscribe").ToLocalChecked()
+    , Nan::New<v8::Integer>(evsCyclicSubscribe)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("evsCyclicUnsubscribe").ToLocalChecked()
+    , Nan::New<v8::Integer>(evsCyclicUnsubscribe)
+    , v8::ReadOnly);
 
   // Event params : functions group
   Nan::SetPrototypeTemplate(
@@ -580,6 +689,11 @@ NAN_MODULE_INIT(S7Server::Init) {
     , Nan::New<v8::String>("evrResNotFound").ToLocalChecked()
     , Nan::New<v8::Integer>(evrResNotFound)
     , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+      tpl
+    , Nan::New<v8::String>("evrInvalidCyclicJob").ToLocalChecked()
+    , Nan::New<v8::Integer>(evrInvalidCyclicJob)
+    , v8::ReadOnly);
 
   // Server parameter
   Nan::SetPrototypeTemplate(
@@ -602,6 +716,31 @@ NAN_MODULE_INIT(S7Server::Init) {
     , Nan::New<v8::String>("MaxClients").ToLocalChecked()
     , Nan::New<v8::Integer>(p_i32_MaxClients)
     , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+    tpl
+    , Nan::New<v8::String>("ReactorThreads").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_ReactorThreads)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+    tpl
+    , Nan::New<v8::String>("MaxDB").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_MaxDB)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+    tpl
+    , Nan::New<v8::String>("RWAreaConcurrent").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_RWAreaConcurrent)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+    tpl
+    , Nan::New<v8::String>("RWCacheTTL").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_RWCacheTTL)
+    , v8::ReadOnly);
+  Nan::SetPrototypeTemplate(
+    tpl
+    , Nan::New<v8::String>("EventsDropped").ToLocalChecked()
+    , Nan::New<v8::Integer>(p_i32_EventsDropped)
+    , v8::ReadOnly);
 
   // CPU status codes
   Nan::SetPrototypeTemplate(
@@ -659,36 +798,91 @@ S7Server::S7Server(v8::Local<v8::Object> resource)
   : async_resource("S7Server:emit", resource) {
   lastError = 0;
   snap7Server = new TS7Server();
-
-  event_async_g.data = rw_async_g.data = this;
-
-  uv_async_init(uv_default_loop(), &event_async_g, S7Server::HandleEvent);
-  uv_async_init(uv_default_loop(), &rw_async_g, S7Server::HandleReadWriteEvent);
-
-  uv_unref(reinterpret_cast<uv_handle_t *>(&event_async_g));
-  uv_unref(reinterpret_cast<uv_handle_t *>(&rw_async_g));
+  rw_next_id = 0;
+  rw_closing = false;
+  events_batch = false;
+
+  // Closed asynchronously, they outlive the server object
+  event_async = new uv_async_t;
+  rw_async = new uv_async_t;
+  changes_async = new uv_async_t;
+  event_async->data = rw_async->data = changes_async->data = this;
+
+  uv_async_init(uv_default_loop(), event_async, S7Server::HandleEvent);
+  uv_async_init(uv_default_loop(), rw_async, S7Server::HandleReadWriteEvent);
+  uv_async_init(uv_default_loop(), changes_async, S7Server::HandleChanges);
+
+  uv_unref(reinterpret_cast<uv_handle_t *>(event_async));
+  uv_unref(reinterpret_cast<uv_handle_t *>(rw_async));
+  uv_unref(reinterpret_cast<uv_handle_t *>(changes_async));
+
+  stats_timer = new uv_timer_t;
+  stats_timer->data = this;
+  uv_timer_init(uv_default_loop(), stats_timer);
+  uv_unref(reinterpret_cast<uv_handle_t *>(stats_timer));
   uv_mutex_init(&mutex);
   uv_mutex_init(&mutex_rw);
-  uv_mutex_init(&mutex_event);
-  uv_sem_init(&sem_rw, 0);
+  uv_cond_init(&cond_rw);
 
-  snap7Server->SetEventsCallback(&EventCallBack, NULL);
+  int concurrent = 1;
+  snap7Server->SetParam(p_i32_EventsConcurrent, &concurrent);
+  snap7Server->SetLogMask(snap7Server->GetEventsMask());
+  snap7Server->SetEventsCallback(&EventCallBack, this);
+  snap7Server->SetChangesCallback(&ChangesCallBack, this);
 }
 
 S7Server::~S7Server() {
-  snap7Server->Stop();
+  StopServer();
   delete snap7Server;
 
-  constructor.Reset();
+  std::map<int, std::map<int, TBufferInfo> >::iterator area;
+  std::map<int, TBufferInfo>::iterator index;
+  for (area = area2buffer.begin(); area != area2buffer.end(); ++area) {
+    for (index = area->second.begin(); index != area->second.end(); ++index) {
+      FreeBufferInfo(index->second);
+    }
+  }
 
-  uv_close(reinterpret_cast<uv_handle_t *>(&event_async_g), 0);
-  uv_close(reinterpret_cast<uv_handle_t *>(&rw_async_g), 0);
-  uv_sem_destroy(&sem_rw);
-  uv_mutex_destroy(&mutex_event);
+  uv_close(reinterpret_cast<uv_handle_t *>(event_async), FreeAsync);
+  uv_close(reinterpret_cast<uv_handle_t *>(rw_async), FreeAsync);
+  uv_close(reinterpret_cast<uv_handle_t *>(changes_async), FreeAsync);
+  uv_timer_stop(stats_timer);
+  uv_close(reinterpret_cast<uv_handle_t *>(stats_timer), FreeTimer);
+  uv_cond_destroy(&cond_rw);
   uv_mutex_destroy(&mutex_rw);
   uv_mutex_destroy(&mutex);
 }
 
+// Answers with an error every readWrite request still waiting, the workers
+// blocked on them would never join otherwise
+void S7Server::ReleasePendingRW() {
+  std::map<unsigned int, TRWRequest*>::iterator it;
+
+  uv_mutex_lock(&mutex_rw);
+  for (it = rw_pending.begin(); it != rw_pending.end(); ++it) {
+    it->second->result = -1;
+    it->second->done = true;
+  }
+  rw_pending.clear();
+  rw_queue.clear();
+  uv_cond_broadcast(&cond_rw);
+  uv_mutex_unlock(&mutex_rw);
+}
+
+int S7Server::StopServer() {
+  uv_mutex_lock(&mutex_rw);
+  rw_closing = true;
+  uv_mutex_unlock(&mutex_rw);
+  ReleasePendingRW();
+
+  int ret = snap7Server->Stop();
+
+  uv_mutex_lock(&mutex_rw);
+  rw_closing = false;
+  uv_mutex_unlock(&mutex_rw);
+  return ret;
+}
+
 int S7Server::GetByteCountFromWordLen(int WordLen) {
   switch (WordLen) {
   case S7WLBit:
@@ -709,26 +903,132 @@ int S7Server::GetByteCountFromWordLen(int WordLen) {
 NAN_METHOD(S7Server::RWBufferCallback) {
   Nan::HandleScope scope;
 
-  if (rw_event_baton_g.Operation == OperationRead) {
+  // data is [server, request id]
+  v8::Local<v8::Object> data = info.Data().As<v8::Object>();
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(
+    Nan::Get(data, 0).ToLocalChecked().As<v8::Object>());
+  unsigned int id = Nan::To<uint32_t>(
+    Nan::Get(data, 1).ToLocalChecked()).FromJust();
+
+  uv_mutex_lock(&s7server->mutex_rw);
+  std::map<unsigned int, TRWRequest*>::iterator it;
+  it = s7server->rw_pending.find(id);
+  if (it == s7server->rw_pending.end()) {
+    // Already answered or released by Stop()
+    uv_mutex_unlock(&s7server->mutex_rw);
+    return;
+  }
+  TRWRequest *request = it->second;
+
+  if (request->Operation == OperationRead) {
     if (!node::Buffer::HasInstance(info[0])) {
+      uv_mutex_unlock(&s7server->mutex_rw);
       return Nan::ThrowTypeError("Wrong argument");
     }
 
     int byteCount, size;
-    byteCount = S7Server::GetByteCountFromWordLen(rw_event_baton_g.Tag.WordLen);
-    size = byteCount * rw_event_baton_g.Tag.Size;
+    byteCount = S7Server::GetByteCountFromWordLen(request->Tag.WordLen);
+    size = byteCount * request->Tag.Size;
 
-    if (node::Buffer::Length(info[0].As<v8::Object>()) < size) {
+    if (node::Buffer::Length(info[0].As<v8::Object>())
+      < static_cast<size_t>(size)) {
+      uv_mutex_unlock(&s7server->mutex_rw);
       return Nan::ThrowTypeError("Buffer length too small");
     }
 
     memcpy(
-        rw_event_baton_g.pUsrData
+        request->pUsrData
       , node::Buffer::Data(info[0].As<v8::Object>())
       , size);
   }
 
-  uv_sem_post(&sem_rw);
+  s7server->rw_pending.erase(it);
+  request->done = true;
+  uv_cond_broadcast(&s7server->cond_rw);
+  uv_mutex_unlock(&s7server->mutex_rw);
+}
+
+NAN_METHOD(S7Server::RWBatchCallback) {
+  Nan::HandleScope scope;
+
+  // data is [server, request id, item buffers]
+  v8::Local<v8::Object> data = info.Data().As<v8::Object>();
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(
+    Nan::Get(data, 0).ToLocalChecked().As<v8::Object>());
+  unsigned int id = Nan::To<uint32_t>(
+    Nan::Get(data, 1).ToLocalChecked()).FromJust();
+  v8::Local<v8::Array> buffers = Nan::Get(data, 2).ToLocalChecked()
+    .As<v8::Array>();
+
+  // Optional results, one for each item : a Buffer with the data to read,
+  // false to refuse the item, anything else to keep the item buffer
+  v8::Local<v8::Array> results;
+  bool hasResults = info[0]->IsArray();
+  if (hasResults) {
+    results = info[0].As<v8::Array>();
+  } else if (!info[0]->IsUndefined()) {
+    return Nan::ThrowTypeError("Wrong argument");
+  }
+
+  // The results are read before taking mutex_rw : a getter or a Proxy runs
+  // JS code, which could call back into the server and deadlock
+  uint32_t count = buffers->Length();
+  std::vector<v8::Local<v8::Value> > sources(count);
+  for (uint32_t i = 0; i < count; i++) {
+    v8::Local<v8::Value> result = Nan::Undefined();
+    if (hasResults && !Nan::Get(results, i).ToLocal(&result)) {
+      // The getter threw, the request stays pending
+      return;
+    }
+    if (!result->IsFalse() && !node::Buffer::HasInstance(result)) {
+      result = Nan::Get(buffers, i).ToLocalChecked();
+    }
+    sources[i] = result;
+  }
+
+  uv_mutex_lock(&s7server->mutex_rw);
+  std::map<unsigned int, TRWRequest*>::iterator it;
+  it = s7server->rw_pending.find(id);
+  if (it == s7server->rw_pending.end()) {
+    // Already answered or released by Stop()
+    uv_mutex_unlock(&s7server->mutex_rw);
+    return;
+  }
+  TRWRequest *request = it->second;
+
+  // Check everything before touching the items, a throw leaves the request
+  // pending
+  for (uint32_t i = 0; request->Operation == OperationRead && i < count; i++) {
+    if (sources[i]->IsFalse())
+      continue;
+    size_t size = S7Server::GetByteCountFromWordLen(
+      request->Items[i].Tag.WordLen) * request->Items[i].Tag.Size;
+    if (node::Buffer::Length(sources[i].As<v8::Object>()) < size) {
+      uv_mutex_unlock(&s7server->mutex_rw);
+      return Nan::ThrowTypeError("Buffer length too small");
+    }
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    PSrvRWItem item = &request->Items[i];
+    if (sources[i]->IsFalse()) {
+      item->Result = -1;
+      continue;
+    }
+
+    if (request->Operation == OperationRead) {
+      memcpy(
+          item->pData
+        , node::Buffer::Data(sources[i].As<v8::Object>())
+        , S7Server::GetByteCountFromWordLen(item->Tag.WordLen)
+          * item->Tag.Size);
+    }
+  }
+
+  s7server->rw_pending.erase(it);
+  request->done = true;
+  uv_cond_broadcast(&s7server->cond_rw);
+  uv_mutex_unlock(&s7server->mutex_rw);
 }
 
 #if NODE_VERSION_AT_LEAST(0, 11, 13)
@@ -739,10 +1039,16 @@ void S7Server::HandleEvent(uv_async_t* handle, int status) {
   Nan::HandleScope scope;
 
   S7Server *s7server = static_cast<S7Server*>(handle->data);
+  TSrvEvent Evt;
+  PSrvEvent Event = &Evt;
+
+  if (s7server->events_batch) {
+    s7server->EmitEventsBatch();
+    return;
+  }
 
-  uv_mutex_lock(&mutex_event);
-  while (!event_list_g.empty()) {
-    PSrvEvent Event = &event_list_g.front();
+  // Only this thread extracts from the queue, the workers never wait for it
+  while (s7server->snap7Server->PickEvent(Event)) {
     in_addr sin;
     sin.s_addr = Event->EvtSender;
     double time = static_cast<double>(Event->EvtTime * 1000);
@@ -771,9 +1077,73 @@ void S7Server::HandleEvent(uv_async_t* handle, int status) {
     };
 
     s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 2, argv);
-    event_list_g.pop_front();
   }
-  uv_mutex_unlock(&mutex_event);
+}
+
+// Emits all the pending events at once, one column per field, every
+// column is a typed array over the same Buffer :
+//   time     Float64 ms since epoch
+//   sender   Uint32  IPv4 address, host byte order
+//   code     Uint32
+//   retCode, param1..param4 Uint16
+void S7Server::EmitEventsBatch() {
+  std::vector<TSrvEvent> events;
+  TSrvEvent Event;
+
+  while (snap7Server->PickEvent(&Event)) {
+    events.push_back(Event);
+  }
+  if (events.empty())
+    return;
+
+  size_t count = events.size();
+  v8::Local<v8::Object> buffer = Nan::NewBuffer(
+    static_cast<uint32_t>(count * 26)).ToLocalChecked();
+  char *data = node::Buffer::Data(buffer);
+  double *time = reinterpret_cast<double*>(data);
+  uint32_t *sender = reinterpret_cast<uint32_t*>(data + count * 8);
+  uint32_t *code = reinterpret_cast<uint32_t*>(data + count * 12);
+  uint16_t *ret = reinterpret_cast<uint16_t*>(data + count * 16);
+
+  for (size_t i = 0; i < count; i++) {
+    time[i] = static_cast<double>(events[i].EvtTime) * 1000;
+    sender[i] = ntohl(events[i].EvtSender);
+    code[i] = events[i].EvtCode;
+    ret[i] = events[i].EvtRetCode;
+    ret[count + i] = events[i].EvtParam1;
+    ret[count * 2 + i] = events[i].EvtParam2;
+    ret[count * 3 + i] = events[i].EvtParam3;
+    ret[count * 4 + i] = events[i].EvtParam4;
+  }
+
+  // A Buffer allocated here has its own ArrayBuffer, starting at offset 0
+  v8::Local<v8::ArrayBuffer> store = buffer.As<v8::Uint8Array>()->Buffer();
+  const char *uint16_names[] = {
+    "retCode", "param1", "param2", "param3", "param4"
+  };
+
+  v8::Local<v8::Object> events_obj = Nan::New<v8::Object>();
+  Nan::Set(events_obj, Nan::New<v8::String>("count").ToLocalChecked()
+    , Nan::New<v8::Uint32>(static_cast<uint32_t>(count)));
+  Nan::Set(events_obj, Nan::New<v8::String>("buffer").ToLocalChecked()
+    , buffer);
+  Nan::Set(events_obj, Nan::New<v8::String>("time").ToLocalChecked()
+    , v8::Float64Array::New(store, 0, count));
+  Nan::Set(events_obj, Nan::New<v8::String>("sender").ToLocalChecked()
+    , v8::Uint32Array::New(store, count * 8, count));
+  Nan::Set(events_obj, Nan::New<v8::String>("code").ToLocalChecked()
+    , v8::Uint32Array::New(store, count * 12, count));
+  for (size_t c = 0; c < 5; c++) {
+    Nan::Set(events_obj, Nan::New<v8::String>(uint16_names[c]).ToLocalChecked()
+      , v8::Uint16Array::New(store, count * (16 + c * 2), count));
+  }
+
+  v8::Local<v8::Value> argv[2] = {
+    Nan::New("events").ToLocalChecked(),
+    events_obj
+  };
+
+  async_resource.runInAsyncScope(handle(), "emit", 2, argv);
 }
 
 #if NODE_VERSION_AT_LEAST(0, 11, 13)
@@ -784,46 +1154,217 @@ void S7Server::HandleReadWriteEvent(uv_async_t* handle, int status) {
   Nan::HandleScope scope;
 
   S7Server *s7server = static_cast<S7Server*>(handle->data);
-  in_addr sin;
-  sin.s_addr = rw_event_baton_g.Sender;
+  std::deque<unsigned int> rw_queue;
+  std::vector<TS7Tag> tags;
+  std::vector<char> bytes;
+
+  // All the requests queued up to now are emitted in this tick, they can
+  // be answered in any order
+  uv_mutex_lock(&s7server->mutex_rw);
+  rw_queue.swap(s7server->rw_queue);
+  uv_mutex_unlock(&s7server->mutex_rw);
+
+  for (size_t i = 0; i < rw_queue.size(); i++) {
+    std::map<unsigned int, TRWRequest*>::iterator it;
+    uv_mutex_lock(&s7server->mutex_rw);
+    it = s7server->rw_pending.find(rw_queue[i]);
+    // A listener may have stopped the server meanwhile
+    if (it == s7server->rw_pending.end()) {
+      uv_mutex_unlock(&s7server->mutex_rw);
+      continue;
+    }
 
-  v8::Local<v8::Object> rw_tag_obj = Nan::New<v8::Object>();
-  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Area").ToLocalChecked()
-    , Nan::New<v8::Integer>(rw_event_baton_g.Tag.Area));
-  Nan::Set(rw_tag_obj, Nan::New<v8::String>("DBNumber").ToLocalChecked()
-    , Nan::New<v8::Integer>(rw_event_baton_g.Tag.DBNumber));
-  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Start").ToLocalChecked()
-    , Nan::New<v8::Integer>(rw_event_baton_g.Tag.Start));
-  Nan::Set(rw_tag_obj, Nan::New<v8::String>("Size").ToLocalChecked()
-    , Nan::New<v8::Integer>(rw_event_baton_g.Tag.Size));
-  Nan::Set(rw_tag_obj, Nan::New<v8::String>("WordLen").ToLocalChecked()
-    , Nan::New<v8::Integer>(rw_event_baton_g.Tag.WordLen));
+    // A Stop() can release the request, and its worker free it, as soon as
+    // the lock is left : everything we need is copied before
+    TRWRequest *request = it->second;
+    unsigned int id = request->id;
+    int sender = request->Sender;
+    int operation = request->Operation;
+    bool batch = request->Items != NULL;
+    tags.clear();
+    bytes.clear();
+    if (batch) {
+      // Read : zeroed by the server, Write : the client data
+      for (int j = 0; j < request->ItemsCount; j++) {
+        PSrvRWItem item = &request->Items[j];
+        int size = S7Server::GetByteCountFromWordLen(item->Tag.WordLen)
+          * item->Tag.Size;
+        tags.push_back(item->Tag);
+        bytes.insert(bytes.end(), static_cast<char*>(item->pData)
+          , static_cast<char*>(item->pData) + size);
+      }
+    } else {
+      tags.push_back(request->Tag);
+      if (operation == OperationWrite) {
+        int size = S7Server::GetByteCountFromWordLen(request->Tag.WordLen)
+          * request->Tag.Size;
+        bytes.insert(bytes.end(), static_cast<char*>(request->pUsrData)
+          , static_cast<char*>(request->pUsrData) + size);
+      }
+    }
+    uv_mutex_unlock(&s7server->mutex_rw);
 
-  int byteCount, size;
-  byteCount = S7Server::GetByteCountFromWordLen(rw_event_baton_g.Tag.WordLen);
-  size = byteCount * rw_event_baton_g.Tag.Size;
+    in_addr sin;
+    sin.s_addr = sender;
+
+    // The callback finds its request by id, so a late or repeated call
+    // can't answer another one
+    v8::Local<v8::Array> data = Nan::New<v8::Array>(2);
+    Nan::Set(data, 0, s7server->handle());
+    Nan::Set(data, 1, Nan::New<v8::Uint32>(id));
+
+    if (batch) {
+      // One event for all the items of the PDU
+      uint32_t count = static_cast<uint32_t>(tags.size());
+      v8::Local<v8::Array> items = Nan::New<v8::Array>(count);
+      v8::Local<v8::Array> buffers = Nan::New<v8::Array>(count);
+      size_t offset = 0;
+      for (uint32_t j = 0; j < count; j++) {
+        int size = S7Server::GetByteCountFromWordLen(tags[j].WordLen)
+          * tags[j].Size;
+        v8::Local<v8::Object> buffer = Nan::CopyBuffer(
+          bytes.data() + offset, size).ToLocalChecked();
+        offset += size;
+        v8::Local<v8::Object> item_obj = NewTagObject(tags[j]);
+        Nan::Set(item_obj, Nan::New<v8::String>("Buffer").ToLocalChecked()
+          , buffer);
+        Nan::Set(items, j, item_obj);
+        Nan::Set(buffers, j, buffer);
+      }
+      Nan::Set(data, 2, buffers);
+
+      v8::Local<v8::Value> argv[5] = {
+        Nan::New("readWriteBatch").ToLocalChecked(),
+        Nan::New<v8::String>(inet_ntoa(sin)).ToLocalChecked(),
+        Nan::New<v8::Integer>(operation),
+        items,
+        Nan::New<v8::Function>(S7Server::RWBatchCallback, data)
+      };
+
+      s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 5
+        , argv);
+      continue;
+    }
 
-  v8::Local<v8::Object> buffer;
+    int byteCount, size;
+    byteCount = S7Server::GetByteCountFromWordLen(tags[0].WordLen);
+    size = byteCount * tags[0].Size;
 
-  if (rw_event_baton_g.Operation == OperationWrite) {
-    buffer = Nan::CopyBuffer(
-      static_cast<char*>(rw_event_baton_g.pUsrData),
-      size).ToLocalChecked();
-  } else {
-    buffer = Nan::NewBuffer(size).ToLocalChecked();
-    memset(node::Buffer::Data(buffer), 0, size);
+    v8::Local<v8::Object> buffer;
+
+    if (operation == OperationWrite) {
+      buffer = Nan::CopyBuffer(bytes.data(), size).ToLocalChecked();
+    } else {
+      buffer = Nan::NewBuffer(size).ToLocalChecked();
+      memset(node::Buffer::Data(buffer), 0, size);
+    }
+
+    v8::Local<v8::Value> argv[6] = {
+      Nan::New("readWrite").ToLocalChecked(),
+      Nan::New<v8::String>(inet_ntoa(sin)).ToLocalChecked(),
+      Nan::New<v8::Integer>(operation),
+      NewTagObject(tags[0]),
+      buffer,
+      Nan::New<v8::Function>(S7Server::RWBufferCallback, data)
+    };
+
+    s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 6
+      , argv);
   }
+}
+
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+void S7Server::HandleChanges(uv_async_t* handle) {
+#else
+void S7Server::HandleChanges(uv_async_t* handle, int status) {
+#endif
+  Nan::HandleScope scope;
+
+  S7Server *s7server = static_cast<S7Server*>(handle->data);
+  TSrvChange changes[256];
+  int count, n = 0;
+
+  // All the writes notified up to now are collected in one event
+  v8::Local<v8::Array> changes_arr = Nan::New<v8::Array>();
+  do {
+    count = sizeof(changes) / sizeof(changes[0]);
+    if (s7server->snap7Server->GetChanges(changes, &count) != 0)
+      break;
+
+    for (int i = 0; i < count; i++) {
+      v8::Local<v8::Object> change_obj = Nan::New<v8::Object>();
+      Nan::Set(change_obj, Nan::New<v8::String>("Area").ToLocalChecked()
+        , Nan::New<v8::Integer>(changes[i].Area));
+      Nan::Set(change_obj, Nan::New<v8::String>("DBNumber").ToLocalChecked()
+        , Nan::New<v8::Integer>(changes[i].Index));
+      Nan::Set(change_obj, Nan::New<v8::String>("Start").ToLocalChecked()
+        , Nan::New<v8::Integer>(changes[i].Start));
+      Nan::Set(change_obj, Nan::New<v8::String>("Size").ToLocalChecked()
+        , Nan::New<v8::Integer>(changes[i].Size));
+      Nan::Set(changes_arr, n++, change_obj);
+    }
+  } while (count == sizeof(changes) / sizeof(changes[0]));
+
+  if (n == 0)
+    return;
 
-  v8::Local<v8::Value> argv[6] = {
-    Nan::New("readWrite").ToLocalChecked(),
-    Nan::New<v8::String>(inet_ntoa(sin)).ToLocalChecked(),
-    Nan::New<v8::Integer>(rw_event_baton_g.Operation),
-    rw_tag_obj,
-    buffer,
-    Nan::New<v8::Function>(S7Server::RWBufferCallback)
+  v8::Local<v8::Value> argv[2] = {
+    Nan::New("changes").ToLocalChecked(),
+    changes_arr
   };
 
-  s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 6, argv);
+  s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 2, argv);
+}
+
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+void S7Server::HandleEventStats(uv_timer_t* handle) {
+#else
+void S7Server::HandleEventStats(uv_timer_t* handle, int status) {
+#endif
+  Nan::HandleScope scope;
+
+  S7Server *s7server = static_cast<S7Server*>(handle->data);
+  TSrvEventStat stats[256];
+  int count, n = 0;
+
+  v8::Local<v8::Array> stats_arr = Nan::New<v8::Array>();
+  do {
+    count = sizeof(stats) / sizeof(stats[0]);
+    if (s7server->snap7Server->GetEventStats(stats, &count) != 0)
+      break;
+
+    for (int i = 0; i < count; i++) {
+      in_addr sin;
+      sin.s_addr = stats[i].Sender;
+
+      v8::Local<v8::Object> stat_obj = Nan::New<v8::Object>();
+      Nan::Set(stat_obj, Nan::New<v8::String>("Sender").ToLocalChecked()
+        , Nan::New<v8::String>(inet_ntoa(sin)).ToLocalChecked());
+      Nan::Set(stat_obj, Nan::New<v8::String>("Area").ToLocalChecked()
+        , Nan::New<v8::Integer>(stats[i].Area));
+      Nan::Set(stat_obj, Nan::New<v8::String>("DBNumber").ToLocalChecked()
+        , Nan::New<v8::Integer>(stats[i].Index));
+      Nan::Set(stat_obj, Nan::New<v8::String>("Reads").ToLocalChecked()
+        , Nan::New<v8::Uint32>(stats[i].Reads));
+      Nan::Set(stat_obj, Nan::New<v8::String>("Writes").ToLocalChecked()
+        , Nan::New<v8::Uint32>(stats[i].Writes));
+      Nan::Set(stat_obj, Nan::New<v8::String>("ReadBytes").ToLocalChecked()
+        , Nan::New<v8::Uint32>(stats[i].ReadBytes));
+      Nan::Set(stat_obj, Nan::New<v8::String>("WriteBytes").ToLocalChecked()
+        , Nan::New<v8::Uint32>(stats[i].WriteBytes));
+      Nan::Set(stats_arr, n++, stat_obj);
+    }
+  } while (count == sizeof(stats) / sizeof(stats[0]));
+
+  if (n == 0)
+    return;
+
+  v8::Local<v8::Value> argv[2] = {
+    Nan::New("eventStats").ToLocalChecked(),
+    stats_arr
+  };
+
+  s7server->async_resource.runInAsyncScope(s7server->handle(), "emit", 2, argv);
 }
 
 void IOWorkerServer::Execute() {
@@ -835,7 +1376,7 @@ void IOWorkerServer::Execute() {
       **static_cast<Nan::Utf8String*>(pData));
 
     if (ret == 0) {
-      uv_ref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_ref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
     break;
 
@@ -843,15 +1384,15 @@ void IOWorkerServer::Execute() {
     ret = s7server->snap7Server->Start();
 
     if (ret == 0) {
-      uv_ref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_ref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
     break;
 
   case STOP:
-    ret = s7server->snap7Server->Stop();
+    ret = s7server->StopServer();
 
     if (ret == 0) {
-      uv_unref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_unref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
     break;
   }
@@ -891,7 +1432,7 @@ NAN_METHOD(S7Server::Start) {
     int ret = s7server->snap7Server->Start();
 
     if (ret == 0) {
-      uv_ref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_ref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
 
     s7server->lastError = ret;
@@ -921,7 +1462,7 @@ NAN_METHOD(S7Server::StartTo) {
     delete address;
 
     if (ret == 0) {
-      uv_ref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_ref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
 
     s7server->lastError = ret;
@@ -939,10 +1480,10 @@ NAN_METHOD(S7Server::Stop) {
   S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
 
   if (!info[0]->IsFunction()) {
-    int ret = s7server->snap7Server->Stop();
+    int ret = s7server->StopServer();
 
     if (ret == 0) {
-      uv_unref(reinterpret_cast<uv_handle_t *>(&event_async_g));
+      uv_unref(reinterpret_cast<uv_handle_t *>(s7server->event_async));
     }
 
     s7server->lastError = ret;
@@ -962,16 +1503,138 @@ NAN_METHOD(S7Server::SetResourceless) {
     return Nan::ThrowTypeError("Wrong arguments");
   }
 
+  if (!info[1]->IsUndefined() && !info[1]->IsBoolean()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
   bool resourceless = Nan::To<bool>(info[0]).FromJust();
+  // Batch : one 'readWriteBatch' event for all the items of a request
+  bool batch = resourceless && info[1]->IsTrue();
 
   int ret;
-  if (resourceless) {
-    ret = s7server->snap7Server->SetRWAreaCallback(&RWAreaCallBack, NULL);
-  } else {
-    ret = s7server->snap7Server->SetRWAreaCallback(NULL, NULL);
+  int concurrent = resourceless ? 1 : 0;
+  ret = s7server->snap7Server->SetParam(p_i32_RWAreaConcurrent, &concurrent);
+  if (ret == 0) {
+    ret = s7server->snap7Server->SetRWAreaBatchCallback(
+      batch ? &RWAreaBatchCallBack : NULL, batch ? s7server : NULL);
+  }
+  if (ret == 0) {
+    if (resourceless) {
+      ret = s7server->snap7Server->SetRWAreaCallback(&RWAreaCallBack
+        , s7server);
+    } else {
+      ret = s7server->snap7Server->SetRWAreaCallback(NULL, NULL);
+    }
+  }
+  s7server->lastError = ret;
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
+}
+
+NAN_METHOD(S7Server::SetEventsBatch) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  if (!info[0]->IsBoolean()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  s7server->events_batch = Nan::To<bool>(info[0]).FromJust();
+  info.GetReturnValue().SetUndefined();
+}
+
+NAN_METHOD(S7Server::SetEventFilters) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  if (!info[0]->IsUndefined() && !info[0]->IsArray()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  TSrvEventFilter filters[MaxEventFilters];
+  int count = 0;
+
+  if (info[0]->IsArray()) {
+    v8::Local<v8::Array> filters_arr = v8::Local<v8::Array>::Cast(info[0]);
+    if (filters_arr->Length() > MaxEventFilters) {
+      return Nan::ThrowRangeError("Too many filters");
+    }
+
+    for (count = 0; count < static_cast<int>(filters_arr->Length()); count++) {
+      v8::Local<v8::Value> filter = Nan::Get(filters_arr, count).ToLocalChecked();
+      if (!filter->IsObject()) {
+        return Nan::ThrowTypeError("Wrong filter");
+      }
+      v8::Local<v8::Object> filter_obj = filter.As<v8::Object>();
+      v8::Local<v8::Value> code = Nan::Get(filter_obj
+        , Nan::New<v8::String>("Code").ToLocalChecked()).ToLocalChecked();
+      v8::Local<v8::Value> area = Nan::Get(filter_obj
+        , Nan::New<v8::String>("Area").ToLocalChecked()).ToLocalChecked();
+      v8::Local<v8::Value> db_from = Nan::Get(filter_obj
+        , Nan::New<v8::String>("DBFrom").ToLocalChecked()).ToLocalChecked();
+      v8::Local<v8::Value> db_to = Nan::Get(filter_obj
+        , Nan::New<v8::String>("DBTo").ToLocalChecked()).ToLocalChecked();
+      v8::Local<v8::Value> sender = Nan::Get(filter_obj
+        , Nan::New<v8::String>("Sender").ToLocalChecked()).ToLocalChecked();
+
+      // Omitted fields match anything
+      if (!(code->IsUndefined() || code->IsUint32()) ||
+        !(area->IsUndefined() || area->IsInt32()) ||
+        !(db_from->IsUndefined() || db_from->IsUint32()) ||
+        !(db_to->IsUndefined() || db_to->IsUint32()) ||
+        !(sender->IsUndefined() || sender->IsString())) {
+        return Nan::ThrowTypeError("Wrong filter");
+      }
+
+      filters[count].Code = code->IsUndefined()
+        ? evcAll : Nan::To<uint32_t>(code).FromJust();
+      filters[count].Area = area->IsUndefined()
+        ? -1 : Nan::To<int32_t>(area).FromJust();
+      filters[count].DBFrom = db_from->IsUndefined()
+        ? 0 : static_cast<word>(Nan::To<uint32_t>(db_from).FromJust());
+      filters[count].DBTo = db_to->IsUndefined()
+        ? 0xFFFF : static_cast<word>(Nan::To<uint32_t>(db_to).FromJust());
+      if (sender->IsUndefined()) {
+        filters[count].Sender = 0;
+      } else {
+        Nan::Utf8String address(sender);
+        filters[count].Sender = inet_addr(*address);
+      }
+    }
+  }
+
+  int ret = s7server->snap7Server->SetEventFilters(filters, count);
+  s7server->lastError = ret;
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
+}
+
+NAN_METHOD(S7Server::SetEventsAggregate) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  if (!info[0]->IsUint32()) {
+    return Nan::ThrowTypeError("Wrong arguments");
   }
+
+  // 0 : the data events are emitted one by one again
+  uint32_t interval = Nan::To<uint32_t>(info[0]).FromJust();
+  int aggregate = interval > 0 ? 1 : 0;
+  int ret = s7server->snap7Server->SetParam(p_i32_EventsAggregate, &aggregate);
   s7server->lastError = ret;
 
+  if (ret == 0) {
+    uv_timer_stop(s7server->stats_timer);
+    if (interval > 0) {
+      uv_timer_start(s7server->stats_timer, S7Server::HandleEventStats
+        , interval, interval);
+    } else {
+      // Last counters collected up to now
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+      S7Server::HandleEventStats(s7server->stats_timer);
+#else
+      S7Server::HandleEventStats(s7server->stats_timer, 0);
+#endif
+    }
+  }
+
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
 
@@ -987,7 +1650,11 @@ NAN_METHOD(S7Server::GetParam) {
     , &pData);
   s7server->lastError = ret;
 
-  info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
+  if (ret == 0) {
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(pData));
+  } else {
+    info.GetReturnValue().Set(Nan::False());
+  }
 }
 
 NAN_METHOD(S7Server::SetParam) {
@@ -1019,7 +1686,9 @@ NAN_METHOD(S7Server::SetEventsMask) {
     return Nan::ThrowTypeError("Wrong arguments");
   }
 
+  // The emitted events are the queued ones, keep the two masks together
   s7server->snap7Server->SetEventsMask(Nan::To<uint32_t>(info[0]).FromJust());
+  s7server->snap7Server->SetLogMask(Nan::To<uint32_t>(info[0]).FromJust());
   info.GetReturnValue().SetUndefined();
 }
 
@@ -1031,24 +1700,54 @@ NAN_METHOD(S7Server::RegisterArea) {
   }
 
   int index;
-  char *pBuffer;
-  size_t len;
+  v8::Local<v8::Value> memory;
   int area = Nan::To<int32_t>(info[0]).FromJust();
 
   if (area == srvAreaDB) {
-    if (!info[1]->IsInt32() || !node::Buffer::HasInstance(info[2])) {
+    if (!info[1]->IsInt32()) {
       return Nan::ThrowTypeError("Wrong arguments");
     }
 
     index = Nan::To<int32_t>(info[1]).FromJust();
-    len = node::Buffer::Length(info[2].As<v8::Object>());
-    pBuffer = node::Buffer::Data(info[2].As<v8::Object>());
-  } else if (!node::Buffer::HasInstance(info[1])) {
-    return Nan::ThrowTypeError("Wrong arguments");
+    memory = info[2];
   } else {
     index = 0;
-    len = node::Buffer::Length(info[1].As<v8::Object>());
-    pBuffer = node::Buffer::Data(info[1].As<v8::Object>());
+    memory = info[1];
+  }
+
+  char *pBuffer;
+  size_t len;
+  bool zeroCopy = memory->IsArrayBuffer() || memory->IsSharedArrayBuffer();
+#if V8_MAJOR_VERSION >= 8
+  std::shared_ptr<v8::BackingStore> store;
+#endif
+
+  if (zeroCopy) {
+    // The clients are served straight from the caller's memory
+#if V8_MAJOR_VERSION >= 8
+    store = memory->IsArrayBuffer()
+      ? memory.As<v8::ArrayBuffer>()->GetBackingStore()
+      : memory.As<v8::SharedArrayBuffer>()->GetBackingStore();
+    pBuffer = static_cast<char*>(store->Data());
+    len = store->ByteLength();
+#else
+    if (memory->IsArrayBuffer()) {
+      v8::ArrayBuffer::Contents contents =
+        memory.As<v8::ArrayBuffer>()->GetContents();
+      pBuffer = static_cast<char*>(contents.Data());
+      len = contents.ByteLength();
+    } else {
+      v8::SharedArrayBuffer::Contents contents =
+        memory.As<v8::SharedArrayBuffer>()->GetContents();
+      pBuffer = static_cast<char*>(contents.Data());
+      len = contents.ByteLength();
+    }
+#endif
+  } else if (node::Buffer::HasInstance(memory)) {
+    len = node::Buffer::Length(memory.As<v8::Object>());
+    pBuffer = node::Buffer::Data(memory.As<v8::Object>());
+  } else {
+    return Nan::ThrowTypeError("Wrong arguments");
   }
 
   if (len > 0xFFFF) {
@@ -1056,16 +1755,33 @@ NAN_METHOD(S7Server::RegisterArea) {
   }
 
   word size = static_cast<word>(len);
-  char *data = new char[size];
-  memcpy(data, pBuffer, size);
+  char *data;
+  if (zeroCopy) {
+    data = pBuffer;
+  } else {
+    data = new char[size];
+    memcpy(data, pBuffer, size);
+  }
 
   int ret = s7server->snap7Server->RegisterArea(area, index, data, size);
   s7server->lastError = ret;
 
   if (ret == 0) {
-    s7server->area2buffer[area][index].pBuffer = data;
-    s7server->area2buffer[area][index].size = size;
-  } else {
+    TBufferInfo &bufferInfo = s7server->area2buffer[area][index];
+    bufferInfo.pBuffer = data;
+    bufferInfo.pBack = NULL;
+    bufferInfo.size = size;
+    bufferInfo.locked = false;
+    bufferInfo.pinned = NULL;
+    if (zeroCopy) {
+      // Pinned until UnregisterArea
+      bufferInfo.pinned = new Nan::Persistent<v8::Object>(
+        memory.As<v8::Object>());
+#if V8_MAJOR_VERSION >= 8
+      bufferInfo.store = store;
+#endif
+    }
+  } else if (!zeroCopy) {
     delete[] data;
   }
 
@@ -1090,11 +1806,15 @@ NAN_METHOD(S7Server::UnregisterArea) {
     index = Nan::To<int32_t>(info[1]).FromJust();
   }
 
+  if (LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area locked by LockArea()");
+  }
+
   int ret = s7server->snap7Server->UnregisterArea(area, index);
   s7server->lastError = ret;
 
   if (ret == 0) {
-    delete[] s7server->area2buffer[area][index].pBuffer;
+    FreeBufferInfo(s7server->area2buffer[area][index]);
     s7server->area2buffer[area].erase(index);
   }
 
@@ -1113,6 +1833,82 @@ NAN_METHOD(S7Server::SetArea) {
     return Nan::ThrowError("Unknown area");
   }
 
+  int index;
+  int offset = 0;
+  bool ranged = false;
+  char *pBuffer;
+  size_t len;
+
+  // SetArea(area, index, offset, buffer) writes only the given range
+  if (info[2]->IsInt32() && node::Buffer::HasInstance(info[3])) {
+    ranged = true;
+    offset = Nan::To<int32_t>(info[2]).FromJust();
+    len = node::Buffer::Length(info[3].As<v8::Object>());
+    pBuffer = node::Buffer::Data(info[3].As<v8::Object>());
+  }
+
+  if (area == srvAreaDB) {
+    if (!info[1]->IsInt32() || (!ranged && !node::Buffer::HasInstance(info[2]))) {
+      return Nan::ThrowTypeError("Wrong arguments");
+    }
+
+    index = Nan::To<int32_t>(info[1]).FromJust();
+    if (!s7server->area2buffer[area].count(index)) {
+      return Nan::ThrowError("DB index not found");
+    }
+
+    if (!ranged) {
+      len = node::Buffer::Length(info[2].As<v8::Object>());
+      pBuffer = node::Buffer::Data(info[2].As<v8::Object>());
+    }
+  } else {
+    index = 0;
+    if (!ranged) {
+      if (node::Buffer::HasInstance(info[1])) {
+        len = node::Buffer::Length(info[1].As<v8::Object>());
+        pBuffer = node::Buffer::Data(info[1].As<v8::Object>());
+      } else if (node::Buffer::HasInstance(info[2])) {
+        len = node::Buffer::Length(info[2].As<v8::Object>());
+        pBuffer = node::Buffer::Data(info[2].As<v8::Object>());
+      } else {
+        return Nan::ThrowTypeError("Wrong arguments");
+      }
+    }
+  }
+
+  if (LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area locked by LockArea()");
+  }
+
+  if (ranged) {
+    int size = s7server->area2buffer[area][index].size;
+    if (offset < 0 || offset > size
+      || len > static_cast<size_t>(size - offset)) {
+      return Nan::ThrowRangeError("Range exceeds the area size");
+    }
+  } else if (len != s7server->area2buffer[area][index].size) {
+    return Nan::ThrowError("Wrong buffer length");
+  }
+
+  // Copies only the blocks really changed and marks them for 'changes'
+  s7server->snap7Server->SetAreaData(area, index, offset, static_cast<int>(len)
+    , pBuffer);
+
+  info.GetReturnValue().SetUndefined();
+}
+
+NAN_METHOD(S7Server::PublishArea) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  if (!info[0]->IsInt32()) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  int area = Nan::To<int32_t>(info[0]).FromJust();
+  if (!s7server->area2buffer.count(area)) {
+    return Nan::ThrowError("Unknown area");
+  }
+
   int index;
   char *pBuffer;
   size_t len;
@@ -1142,19 +1938,38 @@ NAN_METHOD(S7Server::SetArea) {
     }
   }
 
-  if (len != s7server->area2buffer[area][index].size) {
+  TBufferInfo &bufferInfo = s7server->area2buffer[area][index];
+  if (len != bufferInfo.size) {
     return Nan::ThrowError("Wrong buffer length");
   }
 
-  s7server->snap7Server->LockArea(area, index);
+  if (bufferInfo.pinned != NULL) {
+    return Nan::ThrowError("Not available for a shared area");
+  }
 
-  memcpy(
-    s7server->area2buffer[area][index].pBuffer
-    , pBuffer, s7server->area2buffer[area][index].size);
+  if (bufferInfo.locked) {
+    return Nan::ThrowError("Area locked by LockArea()");
+  }
 
-  s7server->snap7Server->UnlockArea(area, index);
+  // The next image is built in the back buffer without any lock, then it
+  // replaces the current one which becomes the back buffer once the
+  // clients still reading it are done
+  if (bufferInfo.pBack == NULL) {
+    bufferInfo.pBack = new char[bufferInfo.size];
+  }
+  memcpy(bufferInfo.pBack, pBuffer, bufferInfo.size);
 
-  info.GetReturnValue().SetUndefined();
+  void *pOld;
+  int ret = s7server->snap7Server->PublishArea(area, index, bufferInfo.pBack
+    , &pOld);
+  s7server->lastError = ret;
+
+  if (ret == 0) {
+    bufferInfo.pBuffer = bufferInfo.pBack;
+    bufferInfo.pBack = static_cast<char*>(pOld);
+  }
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
 
 NAN_METHOD(S7Server::GetArea) {
@@ -1182,15 +1997,109 @@ NAN_METHOD(S7Server::GetArea) {
     }
   }
 
-  s7server->snap7Server->LockArea(area, index);
+  if (LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area locked by LockArea()");
+  }
+
+  // GetArea(area, index, offset, length) reads only the given range
+  int offset = 0;
+  int len = s7server->area2buffer[area][index].size;
+  if (info[2]->IsInt32()) {
+    if (!info[3]->IsInt32()) {
+      return Nan::ThrowTypeError("Wrong arguments");
+    }
 
-  v8::Local<v8::Object> buffer = Nan::CopyBuffer(
-      s7server->area2buffer[area][index].pBuffer
-    , s7server->area2buffer[area][index].size).ToLocalChecked();
+    offset = Nan::To<int32_t>(info[2]).FromJust();
+    len = Nan::To<int32_t>(info[3]).FromJust();
+    int size = s7server->area2buffer[area][index].size;
+    if (offset < 0 || len < 0 || offset > size || len > size - offset) {
+      return Nan::ThrowRangeError("Range exceeds the area size");
+    }
+  }
 
-  s7server->snap7Server->UnlockArea(area, index);
+  // Shared lock, doesn't block the clients reading the same area
+  v8::Local<v8::Object> buffer = Nan::NewBuffer(
+    static_cast<uint32_t>(len)).ToLocalChecked();
+  int ret = s7server->snap7Server->GetAreaData(area, index, offset, len
+    , node::Buffer::Data(buffer));
+  s7server->lastError = ret;
 
-  info.GetReturnValue().Set(buffer);
+  if (ret == 0) {
+    info.GetReturnValue().Set(buffer);
+  } else {
+    info.GetReturnValue().Set(Nan::False());
+  }
+}
+
+NAN_METHOD(S7Server::GetAreaInto) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  if (!info[0]->IsInt32() || !info[1]->IsInt32() || !info[2]->IsInt32()
+    || !node::Buffer::HasInstance(info[3])) {
+    return Nan::ThrowTypeError("Wrong arguments");
+  }
+
+  int area = Nan::To<int32_t>(info[0]).FromJust();
+  if (!s7server->area2buffer.count(area)) {
+    return Nan::ThrowError("Unknown area");
+  }
+
+  int index = 0;
+  if (area == srvAreaDB) {
+    index = Nan::To<int32_t>(info[1]).FromJust();
+    if (!s7server->area2buffer[area].count(index)) {
+      return Nan::ThrowError("DB index not found");
+    }
+  }
+
+  if (LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area locked by LockArea()");
+  }
+
+  int offset = Nan::To<int32_t>(info[2]).FromJust();
+  size_t len = node::Buffer::Length(info[3].As<v8::Object>());
+  int size = s7server->area2buffer[area][index].size;
+  if (offset < 0 || offset > size
+    || len > static_cast<size_t>(size - offset)) {
+    return Nan::ThrowRangeError("Range exceeds the area size");
+  }
+
+  // Fills the caller's buffer, no allocation at all
+  int ret = s7server->snap7Server->GetAreaData(area, index, offset
+    , static_cast<int>(len), node::Buffer::Data(info[3].As<v8::Object>()));
+  s7server->lastError = ret;
+
+  if (ret == 0) {
+    info.GetReturnValue().Set(info[3]);
+  } else {
+    info.GetReturnValue().Set(Nan::False());
+  }
+}
+
+NAN_METHOD(S7Server::InvalidateCache) {
+  S7Server *s7server = ObjectWrap::Unwrap<S7Server>(info.Holder());
+
+  // No area : the whole cache
+  int area = -1;
+  int index = 0;
+  if (!info[0]->IsUndefined()) {
+    if (!info[0]->IsInt32()) {
+      return Nan::ThrowTypeError("Wrong arguments");
+    }
+    area = Nan::To<int32_t>(info[0]).FromJust();
+
+    if (area == srvAreaDB) {
+      if (!info[1]->IsInt32()) {
+        return Nan::ThrowTypeError("Wrong arguments");
+      }
+      index = Nan::To<int32_t>(info[1]).FromJust();
+    }
+  }
+
+  int ret = s7server->snap7Server->InvalidateCache(area, index);
+  s7server->lastError = ret;
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
 
 NAN_METHOD(S7Server::LockArea) {
@@ -1211,9 +2120,18 @@ NAN_METHOD(S7Server::LockArea) {
     index = Nan::To<int32_t>(info[1]).FromJust();
   }
 
+  // Locking it again would never return
+  if (LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area already locked");
+  }
+
   int ret = s7server->snap7Server->LockArea(area, index);
   s7server->lastError = ret;
 
+  if (ret == 0 && s7server->area2buffer[area].count(index)) {
+    s7server->area2buffer[area][index].locked = true;
+  }
+
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
 
@@ -1235,9 +2153,17 @@ NAN_METHOD(S7Server::UnlockArea) {
     index = Nan::To<int32_t>(info[1]).FromJust();
   }
 
+  if (!LockedByUs(s7server, area, index)) {
+    return Nan::ThrowError("Area not locked");
+  }
+
   int ret = s7server->snap7Server->UnlockArea(area, index);
   s7server->lastError = ret;
 
+  if (ret == 0) {
+    s7server->area2buffer[area][index].locked = false;
+  }
+
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(ret == 0));
 }
 
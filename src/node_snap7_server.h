@@ -12,6 +12,8 @@
 #include <nan.h>
 #include <map>
 #include <deque>
+#include <vector>
+#include <memory>
 
 namespace node_snap7 {
 
@@ -21,9 +23,32 @@ enum ServerIOFunction {
 
 typedef struct {
   char* pBuffer;
+  char* pBack;  // Next image for PublishArea (allocated on first use)
   word size;
+  // Held by LockArea() : the area lock isn't recursive, so any other access
+  // from the JS thread would deadlock until UnlockArea()
+  bool locked;
+  // Caller-owned (Shared)ArrayBuffer registered without copy, NULL if
+  // pBuffer is ours
+  Nan::Persistent<v8::Object> *pinned;
+#if V8_MAJOR_VERSION >= 8
+  std::shared_ptr<v8::BackingStore> store;  // Survives a detach
+#endif
 }TBufferInfo;
 
+// readWrite request of a worker thread, lives on its stack until answered
+typedef struct {
+  unsigned int id;
+  int Sender;
+  int Operation;
+  TS7Tag Tag;
+  void *pUsrData;
+  PSrvRWItem Items;  // Batch request (readWriteBatch), NULL otherwise
+  int ItemsCount;
+  bool done;
+  int result;
+}TRWRequest;
+
 class S7Server : public Nan::ObjectWrap {
  public:
   explicit S7Server(v8::Local<v8::Object> resource);
@@ -34,6 +59,9 @@ class S7Server : public Nan::ObjectWrap {
   static NAN_METHOD(StartTo);
   static NAN_METHOD(Stop);
   static NAN_METHOD(SetResourceless);
+  static NAN_METHOD(SetEventsBatch);
+  static NAN_METHOD(SetEventFilters);
+  static NAN_METHOD(SetEventsAggregate);
   static NAN_METHOD(GetParam);
   static NAN_METHOD(SetParam);
   static NAN_METHOD(GetEventsMask);
@@ -41,7 +69,10 @@ class S7Server : public Nan::ObjectWrap {
   static NAN_METHOD(RegisterArea);
   static NAN_METHOD(UnregisterArea);
   static NAN_METHOD(SetArea);
+  static NAN_METHOD(PublishArea);
   static NAN_METHOD(GetArea);
+  static NAN_METHOD(GetAreaInto);
+  static NAN_METHOD(InvalidateCache);
   static NAN_METHOD(LockArea);
   static NAN_METHOD(UnlockArea);
   static NAN_METHOD(ServerStatus);
@@ -67,10 +98,41 @@ class S7Server : public Nan::ObjectWrap {
   static void HandleReadWriteEvent(uv_async_t* handle, int status);
 #endif
 
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+  static void HandleChanges(uv_async_t* handle);
+#else
+  static void HandleChanges(uv_async_t* handle, int status);
+#endif
+#if NODE_VERSION_AT_LEAST(0, 11, 13)
+  static void HandleEventStats(uv_timer_t* handle);
+#else
+  static void HandleEventStats(uv_timer_t* handle, int status);
+#endif
+
   static NAN_METHOD(RWBufferCallback);
+  static NAN_METHOD(RWBatchCallback);
+
+  int StopServer();
+  void ReleasePendingRW();
+  void EmitEventsBatch();
 
   uv_mutex_t mutex;
   TS7Server *snap7Server;
+  uv_async_t *event_async;
+  uv_async_t *rw_async;
+  uv_async_t *changes_async;
+  // Columnar 'events' emission instead of one 'event' per event
+  bool events_batch;
+  // Emits the 'eventStats' counters of the aggregation mode
+  uv_timer_t *stats_timer;
+  // Resourceless mode: requests not emitted yet and requests waiting for
+  // their answer, guarded by mutex_rw
+  uv_mutex_t mutex_rw;
+  uv_cond_t cond_rw;
+  std::deque<unsigned int> rw_queue;
+  std::map<unsigned int, TRWRequest*> rw_pending;
+  unsigned int rw_next_id;
+  bool rw_closing;
   std::map<int, std::map<int, TBufferInfo> > area2buffer;
   int lastError;
   Nan::AsyncResource async_resource;
@@ -98,6 +98,26 @@ int TS7Client::WriteMultiVars(PS7DataItem Item, int ItemsCount)
     return Cli_WriteMultiVars(Client, Item, ItemsCount);
 }
 //---------------------------------------------------------------------------
+int TS7Client::ReadTagList(PS7DataItem Item, int ItemsCount)
+{
+    return Cli_ReadTagList(Client, Item, ItemsCount);
+}
+//---------------------------------------------------------------------------
+int TS7Client::SubscribeCyclic(PS7DataItem Item, int ItemsCount, int Interval, int *JobID)
+{
+    return Cli_SubscribeCyclic(Client, Item, ItemsCount, Interval, JobID);
+}
+//---------------------------------------------------------------------------
+int TS7Client::UnsubscribeCyclic(int JobID)
+{
+    return Cli_UnsubscribeCyclic(Client, JobID);
+}
+//---------------------------------------------------------------------------
+int TS7Client::CheckCyclic(int *JobID, int Timeout)
+{
+    return Cli_CheckCyclic(Client, JobID, Timeout);
+}
+//---------------------------------------------------------------------------
 int TS7Client::DBRead(int DBNumber, int Start, int Size, void *pUsrData)
 {
     return Cli_DBRead(Client, DBNumber, Start, Size, pUsrData);
@@ -532,6 +552,21 @@ int TS7Server::SetRWAreaCallback(pfn_RWAreaCallBack PCallBack, void *UsrPtr)
 	return Srv_SetRWAreaCallback(Server, PCallBack, UsrPtr);
 }
 //---------------------------------------------------------------------------
+int TS7Server::SetRWAreaBatchCallback(pfn_RWAreaBatchCallBack PCallBack, void *UsrPtr)
+{
+	return Srv_SetRWAreaBatchCallback(Server, PCallBack, UsrPtr);
+}
+//---------------------------------------------------------------------------
+int TS7Server::InvalidateCache(int AreaCode, word DBNumber)
+{
+	return Srv_InvalidateCache(Server, AreaCode, DBNumber);
+}
+//---------------------------------------------------------------------------
+int TS7Server::SetChangesCallback(pfn_SrvChangesCallBack PCallBack, void *UsrPtr)
+{
+	return Srv_SetChangesCallback(Server, PCallBack, UsrPtr);
+}
+//---------------------------------------------------------------------------
 bool TS7Server::PickEvent(TSrvEvent *pEvent)
 {
     int EvtReady;
@@ -576,6 +611,16 @@ void TS7Server::SetLogMask(longword Mask)
     Srv_SetMask(Server, mkLog, Mask);
 }
 //---------------------------------------------------------------------------
+int TS7Server::SetEventFilters(TSrvEventFilter *pFilters, int Count)
+{
+    return Srv_SetEventFilters(Server, pFilters, Count);
+}
+//---------------------------------------------------------------------------
+int TS7Server::GetEventStats(TSrvEventStat *pStats, int *Count)
+{
+    return Srv_GetEventStats(Server, pStats, Count);
+}
+//---------------------------------------------------------------------------
 int TS7Server::RegisterArea(int AreaCode, word Index, void *pUsrData, word Size)
 {
     return Srv_RegisterArea(Server, AreaCode, Index, pUsrData, Size);
@@ -596,6 +641,26 @@ int TS7Server::UnlockArea(int AreaCode, word Index)
     return Srv_UnlockArea(Server, AreaCode, Index);
 }
 //---------------------------------------------------------------------------
+int TS7Server::GetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    return Srv_GetAreaData(Server, AreaCode, Index, Start, Size, pUsrData);
+}
+//---------------------------------------------------------------------------
+int TS7Server::SetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData)
+{
+    return Srv_SetAreaData(Server, AreaCode, Index, Start, Size, pUsrData);
+}
+//---------------------------------------------------------------------------
+int TS7Server::PublishArea(int AreaCode, word Index, void *pNewData, void **pOldData)
+{
+    return Srv_PublishArea(Server, AreaCode, Index, pNewData, pOldData);
+}
+//---------------------------------------------------------------------------
+int TS7Server::GetChanges(TSrvChange *pChanges, int *Count)
+{
+    return Srv_GetChanges(Server, pChanges, Count);
+}
+//---------------------------------------------------------------------------
 int TS7Server::ServerStatus()
 {
     int ServerStatus, CpuStatus, ClientsCount;
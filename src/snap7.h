@@ -221,6 +221,15 @@ const int p_i32_BSendTimeout    = 12;
 const int p_i32_BRecvTimeout    = 13;
 const int p_u32_RecoveryTime    = 14;
 const int p_u32_KeepAliveTime   = 15;
+const int p_i32_ReactorThreads  = 16;
+const int p_i32_AmQRequest      = 17;
+const int p_i32_SocketHandle    = 18; // read only
+const int p_i32_MaxDB           = 19;
+const int p_i32_RWAreaConcurrent= 20; // 1 : RWArea callback not serialized
+const int p_i32_RWCacheTTL      = 21; // ms, 0 : resourceless read cache off
+const int p_i32_EventsDropped   = 22; // read only
+const int p_i32_EventsAggregate = 23; // 1 : data events counted (GetEventStats)
+const int p_i32_EventsConcurrent= 24; // 1 : event callbacks not serialized
 
 // Client/Partner Job status 
 const int JobComplete           = 0;
@@ -271,6 +280,7 @@ const longword errCliInvalidParamNumber     = 0x02500000;
 const longword errCliCannotChangeParam      = 0x02600000;
 
 const int MaxVars     = 20; // Max vars that can be transferred with MultiRead/MultiWrite
+const int MaxCyclicJobs = 8; // Max cyclic data subscriptions per connection
 
 // Client Connection Type
 const word CONNTYPE_PG                      = 0x0001;  // Connect to the PLC as a PG
@@ -440,6 +450,11 @@ int S7API Cli_ReadArea(S7Object Client, int Area, int DBNumber, int Start, int A
 int S7API Cli_WriteArea(S7Object Client, int Area, int DBNumber, int Start, int Amount, int WordLen, void *pUsrData);
 int S7API Cli_ReadMultiVars(S7Object Client, PS7DataItem Item, int ItemsCount);
 int S7API Cli_WriteMultiVars(S7Object Client, PS7DataItem Item, int ItemsCount);
+int S7API Cli_ReadTagList(S7Object Client, PS7DataItem Item, int ItemsCount);
+// Cyclic data
+int S7API Cli_SubscribeCyclic(S7Object Client, PS7DataItem Item, int ItemsCount, int Interval, int *JobID);
+int S7API Cli_UnsubscribeCyclic(S7Object Client, int JobID);
+int S7API Cli_CheckCyclic(S7Object Client, int *JobID, int Timeout);
 // Data I/O Lean functions
 int S7API Cli_DBRead(S7Object Client, int DBNumber, int Start, int Size, void *pUsrData);
 int S7API Cli_DBWrite(S7Object Client, int DBNumber, int Start, int Size, void *pUsrData);
@@ -581,7 +596,7 @@ const longword evcDownload            = 0x00800000;
 const longword evcDirectory           = 0x01000000;
 const longword evcSecurity            = 0x02000000;
 const longword evcControl             = 0x04000000;
-const longword evcReserved_08000000   = 0x08000000; // actually unused
+const longword evcCyclicData          = 0x08000000;
 const longword evcReserved_10000000   = 0x10000000; // actually unused
 const longword evcReserved_20000000   = 0x20000000; // actually unused
 const longword evcReserved_40000000   = 0x40000000; // actually unused
@@ -601,6 +616,8 @@ const word evsGetClock                = 0x0001;
 const word evsSetClock                = 0x0002;
 const word evsSetPassword             = 0x0001;
 const word evsClrPassword             = 0x0002;
+const word evsCyclicSubscribe         = 0x0001;
+const word evsCyclicUnsubscribe       = 0x0002;
 // Event Params : functions group
 const word grProgrammer               = 0x0041;
 const word grCyclicData               = 0x0042;
@@ -637,6 +654,7 @@ const word evrCannotUpload            = 0x000E;
 const word evrCannotDownload          = 0x000F;
 const word evrUploadInvalidID         = 0x0010;
 const word evrResNotFound             = 0x0011;
+const word evrInvalidCyclicJob        = 0x0012;
 
 typedef struct{
 	time_t EvtTime;    // Timestamp
@@ -649,10 +667,51 @@ typedef struct{
 	word EvtParam4;    // Param 4 (if available)
 }TSrvEvent, *PSrvEvent;
 
+// Changed range of a registered area
+typedef struct{
+	int Area;          // srvAreaXX
+	int Index;         // DB number (if Area = srvAreaDB)
+	int Start;         // First byte changed
+	int Size;          // Range size
+}TSrvChange, *PSrvChange;
+
+// Item of a batched Read/Write callback, one for each item of the PDU
+typedef struct{
+	TS7Tag Tag;        // Item address
+	void  *pData;      // Read : data to fill, Write : data sent by the client
+	int    Result;     // Set by the callback, 0 : Ok, otherwise item refused
+}TSrvRWItem, *PSrvRWItem;
+
+const int MaxEventFilters = 32; // Max filters of Srv_SetEventFilters
+
+// Server event filter, once set an event must match one of them to pass
+typedef struct{
+	longword Code;     // evcXXX mask
+	int      Area;     // srvAreaXX, -1 : any (only for data events)
+	word     DBFrom;   // DB range (only for srvAreaDB)
+	word     DBTo;
+	longword Sender;   // IPv4 address, 0 : any
+}TSrvEventFilter, *PSrvEventFilter;
+
+// Data events of a client on an area (p_i32_EventsAggregate)
+typedef struct{
+	longword Sender;   // IPv4 address
+	int      Area;     // srvAreaXX
+	int      Index;    // DB number (if Area = srvAreaDB)
+	longword Reads;    // Read events
+	longword Writes;   // Write events
+	longword ReadBytes;
+	longword WriteBytes;
+}TSrvEventStat, *PSrvEventStat;
+
 // Server Events callback
 typedef void (S7API *pfn_SrvCallBack)(void *usrPtr, PSrvEvent PEvent, int Size);
 // Server Read/Write callback
 typedef int(S7API *pfn_RWAreaCallBack)(void *usrPtr, int Sender, int Operation, PS7Tag PTag, void *pUsrData);
+// Server Read/Write callback, all the items of a PDU at once
+typedef int(S7API *pfn_RWAreaBatchCallBack)(void *usrPtr, int Sender, int Operation, PSrvRWItem Items, int ItemsCount);
+// Server Changes callback (some area became dirty)
+typedef void (S7API *pfn_SrvChangesCallBack)(void *usrPtr);
 
 S7Object S7API Srv_Create();
 void S7API Srv_Destroy(S7Object *Server);
@@ -665,6 +724,10 @@ int S7API Srv_RegisterArea(S7Object Server, int AreaCode, word Index, void *pUsr
 int S7API Srv_UnregisterArea(S7Object Server, int AreaCode, word Index);
 int S7API Srv_LockArea(S7Object Server, int AreaCode, word Index);
 int S7API Srv_UnlockArea(S7Object Server, int AreaCode, word Index);
+int S7API Srv_GetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData);
+int S7API Srv_SetAreaData(S7Object Server, int AreaCode, word Index, int Start, int Size, void *pUsrData);
+int S7API Srv_PublishArea(S7Object Server, int AreaCode, word Index, void *pNewData, void **pOldData);
+int S7API Srv_GetChanges(S7Object Server, TSrvChange *pChanges, int *Count);
 int S7API Srv_GetStatus(S7Object Server, int *ServerStatus, int *CpuStatus, int *ClientsCount);
 int S7API Srv_SetCpuStatus(S7Object Server, int CpuStatus);
 int S7API Srv_ClearEvents(S7Object Server);
@@ -674,6 +737,11 @@ int S7API Srv_SetMask(S7Object Server, int MaskKind, longword Mask);
 int S7API Srv_SetEventsCallback(S7Object Server, pfn_SrvCallBack pCallback, void *usrPtr);
 int S7API Srv_SetReadEventsCallback(S7Object Server, pfn_SrvCallBack pCallback, void *usrPtr);
 int S7API Srv_SetRWAreaCallback(S7Object Server, pfn_RWAreaCallBack pCallback, void *usrPtr);
+int S7API Srv_SetRWAreaBatchCallback(S7Object Server, pfn_RWAreaBatchCallBack pCallback, void *usrPtr);
+int S7API Srv_InvalidateCache(S7Object Server, int AreaCode, word DBNumber);
+int S7API Srv_SetChangesCallback(S7Object Server, pfn_SrvChangesCallBack pCallback, void *usrPtr);
+int S7API Srv_SetEventFilters(S7Object Server, TSrvEventFilter *pFilters, int Count);
+int S7API Srv_GetEventStats(S7Object Server, TSrvEventStat *pStats, int *Count);
 int S7API Srv_EventText(TSrvEvent *Event, char *Text, int TextLen);
 int S7API Srv_ErrorText(int Error, char *Text, int TextLen);
 
@@ -774,6 +842,11 @@ public:
     int WriteArea(int Area, int DBNumber, int Start, int Amount, int WordLen, void *pUsrData);
     int ReadMultiVars(PS7DataItem Item, int ItemsCount);
     int WriteMultiVars(PS7DataItem Item, int ItemsCount);
+    int ReadTagList(PS7DataItem Item, int ItemsCount);
+    // Cyclic data
+    int SubscribeCyclic(PS7DataItem Item, int ItemsCount, int Interval, int *JobID);
+    int UnsubscribeCyclic(int JobID);
+    int CheckCyclic(int *JobID, int Timeout);
     // Data I/O Lean functions
     int DBRead(int DBNumber, int Start, int Size, void *pUsrData);
     int DBWrite(int DBNumber, int Start, int Size, void *pUsrData);
@@ -876,17 +949,26 @@ public:
     int SetEventsCallback(pfn_SrvCallBack PCallBack, void *UsrPtr);
 	int SetReadEventsCallback(pfn_SrvCallBack PCallBack, void *UsrPtr);
 	int SetRWAreaCallback(pfn_RWAreaCallBack PCallBack, void *UsrPtr);
+	int SetRWAreaBatchCallback(pfn_RWAreaBatchCallBack PCallBack, void *UsrPtr);
+	int InvalidateCache(int AreaCode, word DBNumber);
+	int SetChangesCallback(pfn_SrvChangesCallBack PCallBack, void *UsrPtr);
     bool PickEvent(TSrvEvent *pEvent);
     void ClearEvents();
     longword GetEventsMask();
     longword GetLogMask();
     void SetEventsMask(longword Mask);
     void SetLogMask(longword Mask);
+    int SetEventFilters(TSrvEventFilter *pFilters, int Count);
+    int GetEventStats(TSrvEventStat *pStats, int *Count);
     // Resources
     int RegisterArea(int AreaCode, word Index, void *pUsrData, word Size);
     int UnregisterArea(int AreaCode, word Index);
     int LockArea(int AreaCode, word Index);
     int UnlockArea(int AreaCode, word Index);
+    int GetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData);
+    int SetAreaData(int AreaCode, word Index, int Start, int Size, void *pUsrData);
+    int PublishArea(int AreaCode, word Index, void *pNewData, void **pOldData);
+    int GetChanges(TSrvChange *pChanges, int *Count);
     // Properties
     int ServerStatus();
     int GetCpuStatus();
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Test of the 'changes' event with two S7Server instances : every server
+// must report only the changes of its own areas (no TCP involved)
+// Usage: node test/changes.js
+
+var assert = require('assert');
+var snap7 = require('../');
+
+var servers = [new snap7.S7Server(), new snap7.S7Server()];
+var received = [[], []];
+
+servers.forEach(function(s7server, n) {
+    s7server.RegisterArea(s7server.srvAreaDB, n + 1, Buffer.alloc(64));
+    s7server.on('changes', function(changes) {
+        received[n] = received[n].concat(changes);
+    });
+});
+
+var guard = setTimeout(function() {
+    assert.fail('Timed out, changes received : ' + JSON.stringify(received));
+}, 5000);
+
+// Only the second server changes first, then only the first one
+servers[1].SetArea(servers[1].srvAreaDB, 2, 16, Buffer.from([1, 2, 3, 4]));
+
+setTimeout(function() {
+    assert.deepStrictEqual(received[0], []);
+    assert.strictEqual(received[1].length, 1);
+    assert.strictEqual(received[1][0].DBNumber, 2);
+    assert.strictEqual(received[1][0].Start, 16);
+
+    servers[0].SetArea(servers[0].srvAreaDB, 1, 0, Buffer.from([5, 6]));
+    setTimeout(function() {
+        assert.strictEqual(received[0].length, 1);
+        assert.strictEqual(received[0][0].DBNumber, 1);
+        assert.strictEqual(received[0][0].Start, 0);
+        assert.strictEqual(received[1].length, 1);
+        clearTimeout(guard);
+        console.log('ok');
+    }, 100);
+}, 100);
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Loopback test of the cyclic data subscriptions against a local S7Server
+// (binds port 102) : subscribe, update the data pushed, mix blocking calls,
+// unsubscribe
+// Usage: node test/cyclic.js
+
+var assert = require('assert');
+var snap7 = require('../');
+
+var s7server = new snap7.S7Server();
+var db = Buffer.from([1, 2, 3, 4, 5, 6, 7, 8]);
+s7server.RegisterArea(s7server.srvAreaDB, 1, db);
+if (!s7server.StartTo('127.0.0.1')) {
+    console.log('Server start failed : ' + s7server.ErrorText(s7server.LastError()));
+    process.exit(1);
+}
+
+var s7client = new snap7.S7Client();
+if (!s7client.ConnectTo('127.0.0.1', 0, 2)) {
+    console.log('Connection failed : ' + s7client.ErrorText(s7client.LastError()));
+    process.exit(1);
+}
+
+var items = [{
+    Area: s7client.S7AreaDB,
+    WordLen: s7client.S7WLByte,
+    DBNumber: 1,
+    Start: 0,
+    Amount: 4
+}, {
+    Area: s7client.S7AreaDB,
+    WordLen: s7client.S7WLWord,
+    DBNumber: 1,
+    Start: 4,
+    Amount: 2
+}];
+
+var guard = setTimeout(function() {
+    assert.fail('Timed out in the ' + step + ' step');
+}, 5000);
+
+var step = 'subscribe';
+var jobId = 0;
+var pushes = 0;
+var updated = false;
+
+s7client.on('cyclic', function(id, result) {
+    assert.strictEqual(id, jobId);
+    assert.strictEqual(result.length, 2);
+    assert.strictEqual(result[0].Result, 0);
+    assert.strictEqual(result[1].Result, 0);
+    pushes++;
+
+    if (step === 'push') {
+        assert.deepStrictEqual(Array.from(result[0].Data), [1, 2, 3, 4]);
+        assert.deepStrictEqual(Array.from(result[1].Data), [5, 6, 7, 8]);
+        // Blocking calls share the connection with the async jobs and with
+        // the checks of the pushes
+        for (var i = 0; i < 20; i++) {
+            s7client.DBRead(1, 4, 4, function(err, data) {
+                assert.ifError(err);
+                assert.strictEqual(data.length, 4);
+            });
+            assert.deepStrictEqual(Array.from(s7client.DBRead(1, 0, 4)), [1, 2, 3, 4]);
+        }
+        step = 'update';
+        s7client.DBWrite(1, 2, 4, Buffer.from([9, 10, 11, 12]), function(err) {
+            assert.ifError(err);
+            updated = true;
+        });
+    } else if ((step === 'update') && updated && (result[0].Data[2] === 9)) {
+        // Only the last values are delivered, an older push can come first
+        assert.deepStrictEqual(Array.from(result[0].Data), [1, 2, 9, 10]);
+        assert.deepStrictEqual(Array.from(result[1].Data), [11, 12, 7, 8]);
+        step = 'unsubscribe';
+        unsubscribe();
+    }
+});
+
+s7client.SubscribeCyclic(items, 100, function(err, id, result) {
+    assert.ifError(err);
+    assert.ok(id > 0, 'jobId');
+    assert.deepStrictEqual(Array.from(result[0].Data), [1, 2, 3, 4]);
+    jobId = id;
+    step = 'push';
+});
+
+function unsubscribe() {
+    s7client.UnsubscribeCyclic(jobId, function(err) {
+        assert.ifError(err);
+        // Let a push already on the wire arrive, then nothing more must come
+        setTimeout(function() {
+            var count = pushes;
+            step = 'unsubscribed';
+            setTimeout(function() {
+                assert.strictEqual(pushes, count, 'Push after UnsubscribeCyclic');
+                clearTimeout(guard);
+                s7client.Disconnect();
+                s7server.Stop();
+                console.log('ok ' + pushes + ' pushes');
+            }, 350);
+        }, 150);
+    });
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Loopback test of the reactor mode (S7Server.ReactorThreads, Linux only,
+// binds port 102) : a peer which sends a partial message must neither
+// stall the other clients nor, once it closes, keep the reactor busy
+// Usage: node test/reactor.js
+
+var assert = require('assert');
+var net = require('net');
+var snap7 = require('../');
+
+var s7server = new snap7.S7Server();
+if (!s7server.SetParam(s7server.ReactorThreads, 1)) {
+    console.log('skipped, no reactor mode on this platform');
+    process.exit(0);
+}
+s7server.RegisterArea(s7server.srvAreaDB, 1, Buffer.from([1, 2, 3, 4]));
+if (!s7server.StartTo('127.0.0.1')) {
+    console.log('Server start failed : ' + s7server.ErrorText(s7server.LastError()));
+    process.exit(1);
+}
+
+var s7client = new snap7.S7Client();
+if (!s7client.ConnectTo('127.0.0.1', 0, 2)) {
+    console.log('Connection failed : ' + s7client.ErrorText(s7client.LastError()));
+    process.exit(1);
+}
+
+var guard = setTimeout(function() {
+    assert.fail('Timed out');
+}, 10000);
+
+// Only the first 5 bytes of a 22 bytes TPKT (a connection request)
+var peer = net.connect(102, '127.0.0.1', function() {
+    peer.write(Buffer.from([0x03, 0x00, 0x00, 0x16, 0x11]));
+    setTimeout(partialSent, 100);
+});
+peer.on('error', function() {});
+
+function partialSent() {
+    assert.strictEqual(s7server.ClientsCount(), 2);
+    // The same reactor serves the other client meanwhile
+    s7client.DBRead(1, 0, 4, function(err, data) {
+        assert.ifError(err);
+        assert.deepStrictEqual(Array.from(data), [1, 2, 3, 4]);
+        peer.end();
+        setTimeout(peerClosed, 200);
+    });
+}
+
+function peerClosed() {
+    assert.strictEqual(s7server.ClientsCount(), 1, 'Session of the closed peer');
+    // The reactor must be idle, not spinning on the closed socket
+    var usage = process.cpuUsage();
+    setTimeout(function() {
+        var used = process.cpuUsage(usage);
+        var ms = (used.user + used.system) / 1000;
+        assert.ok(ms < 250, 'CPU used while idle : ' + ms + ' ms');
+        s7client.DBRead(1, 0, 4, function(err) {
+            assert.ifError(err);
+            clearTimeout(guard);
+            s7client.Disconnect();
+            s7server.Stop();
+            console.log('ok ' + ms.toFixed(1) + ' ms of CPU while idle');
+        });
+    }, 1000);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Loopback test of the shared reads of S7Client against a local S7Server
+// (binds port 102) : the queued reads contained in the one just executed
+// are answered with its data, unless a job that can change the data was
+// queued before them
+// Usage: node test/share.js
+
+var assert = require('assert');
+var snap7 = require('../');
+
+var mem = Buffer.alloc(256);
+for (var i = 0; i < mem.length; i++) {
+    mem[i] = i;
+}
+
+// Resourceless : every read waits for this listener, so the jobs submitted
+// meanwhile are queued
+var s7server = new snap7.S7Server();
+s7server.SetResourceless(true);
+s7server.on('readWrite', function(sender, operation, tag, buffer, callback) {
+    setTimeout(function() {
+        if (operation === s7server.operationRead) {
+            callback(mem.subarray(tag.Start, tag.Start + tag.Size));
+        } else {
+            buffer.copy(mem, tag.Start);
+            callback();
+        }
+    }, 30);
+});
+if (!s7server.StartTo('127.0.0.1')) {
+    console.log('Server start failed : ' + s7server.ErrorText(s7server.LastError()));
+    process.exit(1);
+}
+
+var s7client = new snap7.S7Client();
+if (!s7client.ConnectTo('127.0.0.1', 0, 2)) {
+    console.log('Connection failed : ' + s7client.ErrorText(s7client.LastError()));
+    process.exit(1);
+}
+
+var guard = setTimeout(function() {
+    assert.fail('Timed out');
+}, 10000);
+
+function shared() {
+    return s7client.GetQueueStats()[s7client.PriorityInteractive].Shared;
+}
+
+// Runs the jobs of a step, then the next step once all their callbacks came
+function step(jobs, next) {
+    var left = jobs.length;
+    jobs.forEach(function(job) {
+        job(function() {
+            if (--left === 0)
+                next();
+        });
+    });
+}
+
+function read(start, size, check) {
+    return function(done) {
+        s7client.DBRead(1, start, size, function(err, data) {
+            assert.ifError(err);
+            check(data);
+            done();
+        });
+    };
+}
+
+function expect(start, size) {
+    return function(data) {
+        assert.deepStrictEqual(data, mem.subarray(start, start + size));
+    };
+}
+
+var before = shared();
+
+// The two reads are contained in the first one
+step([
+    read(0, 64, expect(0, 64)),
+    read(4, 8, expect(4, 8)),
+    read(32, 32, expect(32, 32))
+], function() {
+    assert.strictEqual(shared() - before, 2);
+    before = shared();
+
+    // A write queued in between : the read after it must see it
+    step([
+        read(0, 64, function() {}),
+        function(done) {
+            s7client.DBWrite(1, 0, 4, Buffer.from([9, 9, 9, 9]), function(err) {
+                assert.ifError(err);
+                done();
+            });
+        },
+        read(0, 4, function(data) {
+            assert.deepStrictEqual(Array.from(data), [9, 9, 9, 9]);
+        })
+    ], function() {
+        assert.strictEqual(shared() - before, 0);
+        before = shared();
+
+        // A block command of another class is a barrier as well
+        step([
+            read(0, 64, function() {}),
+            function(done) {
+                s7client.DBFill(1, 0, function() {
+                    done();
+                });
+            },
+            read(0, 4, function() {})
+        ], function() {
+            assert.strictEqual(shared() - before, 0, 'Read shared across DBFill');
+            clearTimeout(guard);
+            s7client.Disconnect();
+            s7server.Stop();
+            console.log('ok');
+        });
+    });
+});
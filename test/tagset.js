@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019, Mathias Küsel
+ * MIT License <https://github.com/mathiask88/node-snap7/blob/master/LICENSE>
+ */
+
+// Loopback test of the prepared tag sets against a local S7Server (binds
+// port 102) : sets bigger than a PDU are split into the telegrams needed,
+// for reading and for writing
+// Usage: node test/tagset.js
+
+var assert = require('assert');
+var snap7 = require('../');
+
+var s7server = new snap7.S7Server();
+// Registered without a copy, so the test sees the data written
+var store = new ArrayBuffer(4096);
+var db = Buffer.from(store);
+s7server.RegisterArea(s7server.srvAreaDB, 1, store);
+if (!s7server.StartTo('127.0.0.1')) {
+    console.log('Server start failed : ' + s7server.ErrorText(s7server.LastError()));
+    process.exit(1);
+}
+
+var s7client = new snap7.S7Client();
+if (!s7client.ConnectTo('127.0.0.1', 0, 2)) {
+    console.log('Connection failed : ' + s7client.ErrorText(s7client.LastError()));
+    process.exit(1);
+}
+var pdu = s7client.PDULength();
+
+function items(count, size, step) {
+    var list = [];
+    for (var i = 0; i < count; i++) {
+        list.push({
+            Area: s7client.S7AreaDB,
+            WordLen: s7client.S7WLByte,
+            DBNumber: 1,
+            Start: i * step,
+            Amount: size
+        });
+    }
+    return list;
+}
+
+function pattern(size, seed) {
+    var buffer = Buffer.alloc(size);
+    for (var i = 0; i < size; i++) {
+        buffer[i] = (i * 7 + seed) & 0xFF;
+    }
+    return buffer;
+}
+
+// Checks every item of the set against the server area
+function checkArea(set, list, buffer) {
+    list.forEach(function(item, i) {
+        assert.deepStrictEqual(db.subarray(item.Start, item.Start + item.Amount)
+          , buffer.subarray(set.Offsets[i], set.Offsets[i] + item.Amount));
+    });
+}
+
+var guard = setTimeout(function() {
+    assert.fail('Timed out');
+}, 10000);
+
+// Small : a single telegram each way
+var small = items(4, 10, 100);
+var smallSet = s7client.PrepareTagSet(small);
+var buffer = pattern(smallSet.Size, 1);
+assert.ok(smallSet.Write(buffer));
+checkArea(smallSet, small, buffer);
+var result = smallSet.Read();
+assert.ok(result);
+result.forEach(function(item, i) {
+    assert.strictEqual(item.Result, 0);
+    assert.deepStrictEqual(item.Data, buffer.subarray(smallSet.Offsets[i]
+      , smallSet.Offsets[i + 1] || smallSet.Size));
+});
+
+// Up to MaxVars items, but their data don't fit a PDU
+var wide = items(12, Math.ceil(pdu / 8), 200);
+var wideSet = s7client.PrepareTagSet(wide);
+assert.ok(wideSet.Size > pdu);
+buffer = pattern(wideSet.Size, 2);
+result = wideSet.Write(buffer);
+assert.ok(result, 'Write of a set bigger than the PDU');
+result.forEach(function(item) {
+    assert.strictEqual(item.Result, 0);
+});
+checkArea(wideSet, wide, buffer);
+db.fill(0x55, 0, 200);
+result = wideSet.Read();
+assert.ok(result, 'Read of a set bigger than the PDU');
+assert.deepStrictEqual(result[0].Data, db.subarray(0, wide[0].Amount));
+assert.deepStrictEqual(result[11].Data, buffer.subarray(wideSet.Offsets[11]));
+
+// More items than MaxVars, one of them bigger than a PDU, odd sizes
+var mixed = items(30, 5, 11);
+mixed.push({ Area: s7client.S7AreaDB, WordLen: s7client.S7WLByte, DBNumber: 1
+  , Start: 1000, Amount: pdu * 2 + 1 });
+var mixedSet = s7client.PrepareTagSet(mixed);
+buffer = pattern(mixedSet.Size, 3);
+
+mixedSet.Write(buffer, function(err, res) {
+    assert.ifError(err);
+    res.forEach(function(item) {
+        assert.strictEqual(item.Result, 0);
+    });
+    checkArea(mixedSet, mixed, buffer);
+    var into = Buffer.alloc(mixedSet.Size);
+    mixedSet.ReadInto(into, function(err, layout) {
+        assert.ifError(err);
+        assert.strictEqual(layout[mixed.length * 2], 0);
+        assert.deepStrictEqual(into, buffer);
+        clearTimeout(guard);
+        s7client.Disconnect();
+        s7server.Stop();
+        console.log('ok PDU ' + pdu);
+    });
+});